@@ -0,0 +1,90 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <inttypes.h>
+#include <unistd.h>
+
+#ifdef USE_CHAINING
+#include "../src/hash_table.h"
+#define TABLE_NAME "Chaining"
+#define EMPTY_TABLE(power) new_table(power, (1ULL << (power)) - 1)
+#else
+#include "../src/open_addressing.h"
+#define TABLE_NAME "Open Addressing"
+#define EMPTY_TABLE(power) empty_table(power)
+#endif
+
+// Loading num_items random keys into a table starting at mersenne_power: an insert_key loop, like main.c does, vs
+// build_table from 1 thread up to max_threads (all cores by default), doubling. Wall clock time, since clock() adds up
+// every thread's CPU time.
+
+static double now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+// PRNG for consistent benchmarks across runs with same seed
+static uint64_t xorshift64(uint64_t *state) {
+    uint64_t x = *state;
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+    return *state = x;
+}
+
+int main(int argc, char **argv) {
+    if (argc < 4) {
+        fprintf(stderr, "Usage: %s <seed> <num_items> <mersenne_power> [max_threads]\n", argv[0]);
+        return 1;
+    }
+
+    uint64_t seed = strtoull(argv[1], NULL, 10);
+    size_t num_items = strtoull(argv[2], NULL, 10);
+    uint8_t mersenne_power = (uint8_t)strtoull(argv[3], NULL, 10);
+    int max_threads = argc > 4 ? atoi(argv[4]) : (int)sysconf(_SC_NPROCESSORS_ONLN);
+    if (max_threads < 1) max_threads = 1;
+
+    unsigned int *keys = malloc(num_items * sizeof *keys);
+    if (!keys) {
+        fprintf(stderr, "Failed to allocate keys\n");
+        return 1;
+    }
+    uint64_t rng_state = seed;
+    for (size_t i = 0; i < num_items; ++i) {
+        keys[i] = (unsigned int)xorshift64(&rng_state);
+        if (keys[i] == 0) keys[i] = 1;
+    }
+
+    // Format: Table, Method, Threads, Seconds, Mkeys/s
+    struct hash_table *table = EMPTY_TABLE(mersenne_power);
+    if (!table) {
+        fprintf(stderr, "Failed to allocate table\n");
+        return 1;
+    }
+    double t0 = now_ns();
+    for (size_t i = 0; i < num_items; ++i) insert_key(table, keys[i]);
+    double seconds = (now_ns() - t0) / 1e9;
+    size_t count = table->count;
+    delete_table(table);
+    printf("BULK,%s,insert_key,1,%.3f,%.2f\n", TABLE_NAME, seconds, num_items / seconds / 1e6);
+
+    for (int threads = 1;; threads *= 2) {
+        // Always finish on max_threads, power of two or not.
+        if (threads > max_threads) threads = max_threads;
+        t0 = now_ns();
+        table = build_table(mersenne_power, keys, num_items, threads);
+        seconds = (now_ns() - t0) / 1e9;
+        if (!table) {
+            fprintf(stderr, "Failed to build table\n");
+            return 1;
+        }
+        if (table->count != count) fprintf(stderr, "build_table got %zu keys, insert_key %zu\n", table->count, count);
+        delete_table(table);
+        printf("BULK,%s,build_table,%d,%.3f,%.2f\n", TABLE_NAME, threads, seconds, num_items / seconds / 1e6);
+        if (threads == max_threads) break;
+    }
+
+    free(keys);
+    return 0;
+}
@@ -0,0 +1,80 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <inttypes.h>
+#include <unistd.h>
+
+#include "../src/concurrent_table.h"
+#include "thread_benchmark.h"
+
+// Striped concurrent chaining (src/concurrent_table.c) vs the plain chaining table behind one mutex, which is what we
+// had to do before. The workload is thread_benchmark.h's: every thread does num_items operations on 2 * num_items
+// keys, read_percent of them lookups. From 1 thread up to max_threads (all cores by default), doubling.
+
+static void *striped_create(uint8_t power) {
+    return new_concurrent_table(power);
+}
+
+static void striped_destroy(void *table) {
+    delete_concurrent_table(table);
+}
+
+static void *striped_join(void *table) {
+    return join_table(table);
+}
+
+static void striped_leave(void *thread) {
+    leave_table(thread);
+}
+
+static bool striped_contains(void *thread, unsigned int key) {
+    return concurrent_contains_key(thread, key);
+}
+
+static void striped_insert(void *thread, unsigned int key) {
+    concurrent_insert_key(thread, key);
+}
+
+static void striped_delete(void *thread, unsigned int key) {
+    concurrent_delete_key(thread, key);
+}
+
+static const struct thread_table striped_ops = {"Striped",        striped_create, striped_destroy, striped_join,
+                                                striped_leave,    striped_contains, striped_insert, striped_delete};
+
+static struct hash_table *new_chaining_table(uint8_t power) {
+    return new_table(power, (1ULL << power) - 1);
+}
+
+LOCKED_TABLE(global_mutex, "Global Mutex", struct hash_table, new_chaining_table);
+
+int main(int argc, char **argv) {
+    if (argc < 4) {
+        fprintf(stderr, "Usage: %s <seed> <num_items> <mersenne_power> [read_percent] [max_threads]\n", argv[0]);
+        return 1;
+    }
+
+    uint64_t seed = strtoull(argv[1], NULL, 10);
+    size_t num_items = strtoull(argv[2], NULL, 10);
+    uint8_t mersenne_power = (uint8_t)strtoull(argv[3], NULL, 10);
+    unsigned int read_percent = argc > 4 ? (unsigned int)strtoul(argv[4], NULL, 10) : 90;
+    int max_threads = argc > 5 ? atoi(argv[5]) : (int)sysconf(_SC_NPROCESSORS_ONLN);
+    if (max_threads < 1) max_threads = 1;
+
+    size_t num_keys = 2 * num_items;
+    unsigned int *keys = random_keys(num_keys, seed);
+    const struct thread_table *tables[] = {&striped_ops, &global_mutex_ops};
+
+    // Format: Table, Threads, ReadPercent, Mops/s
+    for (int threads = 1;; threads *= 2) {
+        // Always finish on max_threads, power of two or not.
+        if (threads > max_threads) threads = max_threads;
+        for (size_t t = 0; t < sizeof tables / sizeof *tables; ++t) {
+            double mops = run_threads(tables[t], keys, num_keys, num_items, mersenne_power, read_percent, threads, seed);
+            printf("CONCURRENT,%s,%d,%u,%.2f\n", tables[t]->name, threads, read_percent, mops);
+        }
+        if (threads == max_threads) break;
+    }
+
+    free(keys);
+    return 0;
+}
@@ -0,0 +1,127 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <inttypes.h>
+#include <unistd.h>
+
+#include "../src/frozen_table.h"
+
+// Lookups on a chaining table vs the same table frozen (frozen_table.h), at max_items / 100, / 10 and max_items random
+// keys. The table starts at mersenne_power and grows as the keys go in, the frozen one has the same bins. num_lookups
+// random keys, half of them in the table, one at a time and as one batch. Memory is bins plus links (16 bytes each, in
+// slabs) against offsets plus keys. Mapping is map_frozen_table on the file save_frozen_table just wrote.
+
+static double now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+// PRNG for consistent benchmarks across runs with same seed
+static uint64_t xorshift64(uint64_t *state) {
+    uint64_t x = *state;
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+    return *state = x;
+}
+
+#define NUM_LOOKUPS 1000000
+
+int main(int argc, char **argv) {
+    if (argc < 4) {
+        fprintf(stderr, "Usage: %s <seed> <max_items> <mersenne_power> [snapshot_path]\n", argv[0]);
+        return 1;
+    }
+
+    uint64_t seed = strtoull(argv[1], NULL, 10);
+    size_t max_items = strtoull(argv[2], NULL, 10);
+    uint8_t mersenne_power = (uint8_t)strtoull(argv[3], NULL, 10);
+    const char *path = argc > 4 ? argv[4] : "frozen.bin";
+
+    unsigned int *keys = malloc(max_items * sizeof *keys);
+    unsigned int *lookups = malloc(NUM_LOOKUPS * sizeof *lookups);
+    uint64_t *bitmap = malloc((NUM_LOOKUPS + 63) / 64 * sizeof *bitmap);
+    if (!keys || !lookups || !bitmap) {
+        fprintf(stderr, "Failed to allocate keys\n");
+        return 1;
+    }
+    uint64_t rng_state = seed;
+    for (size_t i = 0; i < max_items; ++i) keys[i] = (unsigned int)xorshift64(&rng_state);
+
+    // Format: Items, ChainedMB, FrozenMB, FreezeTime, MapTime, Chained, ChainedBatch, Frozen, FrozenBatch, Mapped
+    for (size_t num_items = max_items / 100; num_items <= max_items; num_items *= 10) {
+        if (!num_items) continue;
+        for (size_t i = 0; i < NUM_LOOKUPS; ++i) {
+            uint64_t r = xorshift64(&rng_state);
+            lookups[i] = r % 2 ? keys[(r >> 1) % num_items] : (unsigned int)(r >> 32);
+        }
+
+        struct hash_table *table = new_table(mersenne_power, (1U << mersenne_power) - 1);
+        if (!table) {
+            fprintf(stderr, "Failed to allocate table\n");
+            return 1;
+        }
+        insert_keys(table, keys, num_items);
+
+        double t0 = now_ns();
+        struct frozen_table *frozen = freeze_table(table);
+        double freeze_time = (now_ns() - t0) / 1e9;
+        if (!frozen) {
+            fprintf(stderr, "freeze_table failed\n");
+            return 1;
+        }
+        if (!save_frozen_table(frozen, path)) {
+            perror("save_frozen_table");
+            return 1;
+        }
+        t0 = now_ns();
+        struct frozen_table *mapped = map_frozen_table(path);
+        double map_time = (now_ns() - t0) / 1e9;
+        if (!mapped) {
+            fprintf(stderr, "map_frozen_table failed\n");
+            return 1;
+        }
+
+        size_t hits[5] = {0};
+        double times[5];
+        t0 = now_ns();
+        for (size_t i = 0; i < NUM_LOOKUPS; ++i) hits[0] += contains_key(table, lookups[i]);
+        times[0] = (now_ns() - t0) / 1e9;
+
+        t0 = now_ns();
+        contains_keys(table, lookups, NUM_LOOKUPS, bitmap);
+        times[1] = (now_ns() - t0) / 1e9;
+        for (size_t i = 0; i < (NUM_LOOKUPS + 63) / 64; ++i) hits[1] += __builtin_popcountll(bitmap[i]);
+
+        t0 = now_ns();
+        for (size_t i = 0; i < NUM_LOOKUPS; ++i) hits[2] += frozen_contains_key(frozen, lookups[i]);
+        times[2] = (now_ns() - t0) / 1e9;
+
+        t0 = now_ns();
+        frozen_contains_keys(frozen, lookups, NUM_LOOKUPS, bitmap);
+        times[3] = (now_ns() - t0) / 1e9;
+        for (size_t i = 0; i < (NUM_LOOKUPS + 63) / 64; ++i) hits[3] += __builtin_popcountll(bitmap[i]);
+
+        t0 = now_ns();
+        for (size_t i = 0; i < NUM_LOOKUPS; ++i) hits[4] += frozen_contains_key(mapped, lookups[i]);
+        times[4] = (now_ns() - t0) / 1e9;
+
+        for (int i = 1; i < 5; ++i)
+            if (hits[i] != hits[0]) fprintf(stderr, "Lookup %d found %zu, contains_key %zu\n", i, hits[i], hits[0]);
+
+        printf("FROZEN,%zu,%.1f,%.1f,%.6f,%.6f,%.6f,%.6f,%.6f,%.6f,%.6f\n", num_items,
+               (table->size * sizeof(struct link *) + table->count * sizeof(struct link)) / 1e6,
+               (frozen->size + 1 + frozen->count) * sizeof(uint32_t) / 1e6, freeze_time, map_time, times[0], times[1],
+               times[2], times[3], times[4]);
+        delete_frozen_table(mapped);
+        delete_frozen_table(frozen);
+        delete_table(table);
+    }
+
+    unlink(path);
+    free(keys);
+    free(lookups);
+    free(bitmap);
+    return 0;
+}
@@ -0,0 +1,165 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <inttypes.h>
+
+#ifdef USE_CHAINING
+#include "../src/hash_table.h"
+#define TABLE_NAME "Chaining"
+#else
+#include "../src/open_addressing.h"
+#define TABLE_NAME "Open Addressing"
+#endif
+
+// Every hash function (see src/hash_table_helper.h) against a few key sets, reporting ns/key and how long the chains
+// (Chaining) or probe sequences (Open Addressing) get: for every key, how many keys a lookup for it compares against.
+// Times are the best of REPEATS runs.
+
+#define REPEATS 3
+
+static const struct {
+    enum hash_function function;
+    const char *name;
+} functions[] = {
+    {HASH_IDENTITY, "Identity"},
+    {HASH_MULTIPLY_SHIFT, "Multiply-Shift"},
+    {HASH_UNIVERSAL, "Universal"},
+    {HASH_TABULATION, "Tabulation"},
+};
+
+enum key_set { RANDOM_KEYS, STRIDED_KEYS, ADVERSARIAL_KEYS };
+static const char *key_set_names[] = {"Random", "Strided", "Adversarial"};
+
+static double now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+// PRNG for consistent benchmarks across runs with same seed
+static uint64_t xorshift64(uint64_t *state) {
+    uint64_t x = *state;
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+    return *state = x;
+}
+
+static void make_keys(unsigned int *keys, size_t num_items, enum key_set set, uint8_t power, uint64_t seed) {
+    uint64_t rng_state = seed;
+    uint64_t mersenne = (1ULL << power) - 1;
+    for (size_t i = 0; i < num_items; ++i) {
+        switch (set) {
+        case RANDOM_KEYS:
+            keys[i] = (unsigned int)xorshift64(&rng_state);
+            break;
+        case STRIDED_KEYS:
+            // Like pointers to 4 KB objects.
+            keys[i] = (unsigned int)((i + 1) * 4096);
+            break;
+        case ADVERSARIAL_KEYS:
+            // Only 256 different values mod 2^s - 1, so identity puts them all in 256 bins.
+            keys[i] = (unsigned int)((i % 256) + 1 + (i / 256) * mersenne);
+            break;
+        }
+        if (keys[i] == 0) keys[i] = 1;
+    }
+}
+
+static int compare_sizes(const void *a, const void *b) {
+    size_t x = *(const size_t *)a, y = *(const size_t *)b;
+    return (x > y) - (x < y);
+}
+
+// Fills lengths with one entry per key in the table, returns how many.
+static size_t collect_lengths(struct hash_table *table, size_t *lengths) {
+    size_t n = 0;
+#ifdef USE_CHAINING
+    for (size_t i = 0; i < table->size; ++i) {
+        size_t position = 0;
+        for (struct link *link = table->bins[i]; link; link = link->next) lengths[n++] = ++position;
+    }
+#else
+    // Linear probing: a key is as many probes from home as it is bins away from it.
+    for (size_t i = 0; i < table->size; ++i) {
+        const struct bin *bin = &table->table[i];
+        if (!bin->is_used || bin->is_deleted) continue;
+        size_t home = reduce_index(hash_key(&table->hasher, bin->key), table->index_mode, table->mersenne_prime_power,
+                                   table->size);
+        lengths[n++] = (i + table->size - home) % table->size + 1;
+    }
+#endif
+    return n;
+}
+
+int main(int argc, char **argv) {
+    if (argc < 4) {
+        fprintf(stderr, "Usage: %s <seed> <num_items> <mersenne_power>\n", argv[0]);
+        return 1;
+    }
+
+    uint64_t seed = strtoull(argv[1], NULL, 10);
+    size_t num_items = strtoull(argv[2], NULL, 10);
+    uint8_t mersenne_power = (uint8_t)strtoull(argv[3], NULL, 10);
+
+    unsigned int *keys = malloc(num_items * sizeof *keys);
+    size_t *lengths = malloc(num_items * sizeof *lengths);
+    if (!keys || !lengths) {
+        fprintf(stderr, "Failed to allocate keys\n");
+        return 1;
+    }
+
+    // Format: Table, Function, KeySet, Insert ns/key, Lookup ns/key, Mean length, p99 length, Max length
+    for (int set = RANDOM_KEYS; set <= ADVERSARIAL_KEYS; ++set) {
+        make_keys(keys, num_items, set, mersenne_power, seed);
+
+        for (size_t f = 0; f < sizeof functions / sizeof *functions; ++f) {
+            double best_insert = 1e300, best_lookup = 1e300;
+            size_t n = 0;
+
+            for (int r = 0; r < REPEATS; ++r) {
+#ifdef USE_CHAINING
+                struct hash_table *table = new_table(mersenne_power, (1ULL << mersenne_power) - 1);
+#else
+                struct hash_table *table = empty_table(mersenne_power);
+#endif
+                if (!table) {
+                    fprintf(stderr, "Failed to allocate table\n");
+                    return 1;
+                }
+                // Keep the table at the size we asked for, we're after what the hash does to it.
+#ifdef USE_CHAINING
+                table->max_load_factor = 1e9;
+#else
+                set_load_factors(table, 1.0, 1.0);
+#endif
+                set_hash_function(table, functions[f].function, seed);
+
+                double t0 = now_ns();
+                for (size_t i = 0; i < num_items; ++i) insert_key(table, keys[i]);
+                double t1 = now_ns();
+                volatile int hits = 0; // Prevent optimization
+                for (size_t i = 0; i < num_items; ++i) hits += contains_key(table, keys[i]);
+                double t2 = now_ns();
+
+                if (t1 - t0 < best_insert) best_insert = t1 - t0;
+                if (t2 - t1 < best_lookup) best_lookup = t2 - t1;
+                // Same seed every run, so same table every run.
+                n = collect_lengths(table, lengths);
+                delete_table(table);
+            }
+
+            double total = 0;
+            for (size_t i = 0; i < n; ++i) total += lengths[i];
+            qsort(lengths, n, sizeof *lengths, compare_sizes);
+
+            printf("HASH,%s,%s,%s,%.1f,%.1f,%.2f,%zu,%zu\n", TABLE_NAME, functions[f].name, key_set_names[set],
+                   best_insert / num_items, best_lookup / num_items, n ? total / n : 0.0,
+                   n ? lengths[(n - 1) * 99 / 100] : 0, n ? lengths[n - 1] : 0);
+        }
+    }
+
+    free(lengths);
+    free(keys);
+    return 0;
+}
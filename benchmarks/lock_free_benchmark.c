@@ -0,0 +1,67 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <inttypes.h>
+
+#include "../src/lock_free_table.h"
+#include "../src/open_addressing.h"
+#include "thread_benchmark.h"
+
+// Lock-free open addressing (src/lock_free_table.c) vs src/open_addressing.c behind one mutex, at 1, 2, 4, 8 and 16
+// threads. The workload is thread_benchmark.h's, same as concurrent_benchmark.c: every thread does num_items operations
+// on 2 * num_items keys, read_percent of them lookups. Read heavy by default.
+
+static const int thread_counts[] = {1, 2, 4, 8, 16};
+
+static void *lock_free_create(uint8_t power) {
+    return new_lock_free_table(power);
+}
+
+static void lock_free_destroy(void *table) {
+    delete_lock_free_table(table);
+}
+
+static bool lock_free_contains(void *table, unsigned int key) {
+    return lock_free_contains_key(table, key);
+}
+
+static void lock_free_insert(void *table, unsigned int key) {
+    lock_free_insert_key(table, key);
+}
+
+static void lock_free_delete(void *table, unsigned int key) {
+    lock_free_delete_key(table, key);
+}
+
+// No handles, every thread uses the table as it is.
+static const struct thread_table lock_free_ops = {"Lock-Free",        lock_free_create, lock_free_destroy, NULL, NULL,
+                                                  lock_free_contains, lock_free_insert, lock_free_delete};
+
+LOCKED_TABLE(mutex, "Mutex", struct hash_table, empty_table);
+
+int main(int argc, char **argv) {
+    if (argc < 4) {
+        fprintf(stderr, "Usage: %s <seed> <num_items> <mersenne_power> [read_percent]\n", argv[0]);
+        return 1;
+    }
+
+    uint64_t seed = strtoull(argv[1], NULL, 10);
+    size_t num_items = strtoull(argv[2], NULL, 10);
+    uint8_t mersenne_power = (uint8_t)strtoull(argv[3], NULL, 10);
+    unsigned int read_percent = argc > 4 ? (unsigned int)strtoul(argv[4], NULL, 10) : 95;
+
+    size_t num_keys = 2 * num_items;
+    unsigned int *keys = random_keys(num_keys, seed);
+    const struct thread_table *tables[] = {&lock_free_ops, &mutex_ops};
+
+    // Format: Table, Threads, ReadPercent, Mops/s
+    for (size_t i = 0; i < sizeof thread_counts / sizeof *thread_counts; ++i) {
+        for (size_t t = 0; t < sizeof tables / sizeof *tables; ++t) {
+            double mops = run_threads(tables[t], keys, num_keys, num_items, mersenne_power, read_percent,
+                                      thread_counts[i], seed);
+            printf("LOCKFREE,%s,%d,%u,%.2f\n", tables[t]->name, thread_counts[i], read_percent, mops);
+        }
+    }
+
+    free(keys);
+    return 0;
+}
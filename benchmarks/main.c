@@ -6,11 +6,59 @@
 #ifdef USE_CHAINING
 #include "../src/hash_table.h"
 #define TABLE_NAME "Chaining"
+#elif defined(USE_BUCKET_CHAINING)
+#include "../src/bucket_chaining.h"
+#define TABLE_NAME "Bucket Chaining"
+#elif defined(USE_SWISS)
+#include "../src/swiss_table.h"
+#define TABLE_NAME "Swiss Table"
+#elif defined(USE_ROBIN_HOOD)
+#include "../src/robin_hood.h"
+#define TABLE_NAME "Robin Hood"
+#elif defined(USE_CUCKOO)
+#include "../src/cuckoo.h"
+#define TABLE_NAME "Cuckoo"
+#elif defined(USE_FREE_BIT)
+#include "../src/hash_table_with_free_bit.h"
+#define TABLE_NAME "Free Bit"
+// Its functions have their own names (it gets linked next to hash_table.c), map them to the usual ones.
+#define hash_table hash_table_with_free_bit
+#define insert_key insert_key_with_free_bit
+#define contains_key contains_key_with_free_bit
+#define delete_key delete_key_with_free_bit
+#define delete_table delete_table_with_free_bit
+#define print_metrics print_metrics_with_free_bit
+#elif defined(USE_QUOTIENT)
+#include "../src/quotient_table.h"
+#define TABLE_NAME "Quotient"
 #else
 #include "../src/open_addressing.h"
 #define TABLE_NAME "Open Addressing"
 #endif
 
+#ifdef WITH_LATENCY
+// clock() only has microsecond resolution, way too coarse for a single insert.
+static double now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static int compare_doubles(const void *a, const void *b) {
+    double x = *(const double *)a, y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+static double percentile(const double *sorted, size_t n, double p) {
+    size_t i = (size_t)(p * (n - 1));
+    return sorted[i];
+}
+#endif
+
+#ifdef WITH_BATCH
+#define BATCH_KEYS 1024
+#endif
+
 // PRNG for consistent benchmarks across runs with same seed
 static uint64_t xorshift64(uint64_t *state) {
     uint64_t x = *state;
@@ -22,17 +70,35 @@ static uint64_t xorshift64(uint64_t *state) {
 
 int main(int argc, char **argv) {
     if (argc < 4) {
-        fprintf(stderr, "Usage: %s <seed> <num_items> <mersenne_power>\n", argv[0]);
+        fprintf(stderr, "Usage: %s <seed> <num_items> <mersenne_power> [churn_ops] [bins]\n", argv[0]);
         return 1;
     }
 
     uint64_t seed = strtoull(argv[1], NULL, 10);
     size_t num_items = strtoull(argv[2], NULL, 10);
     uint8_t mersenne_power = (uint8_t)strtoull(argv[3], NULL, 10);
+    // Delete + insert pairs to run between the inserts and the lookups, to see what deletes do to the table.
+    size_t churn_ops = argc > 4 ? strtoull(argv[4], NULL, 10) : 0;
+#ifdef INDEX_MODE
+    // Chaining and Open Addressing built with -DINDEX_MODE=INDEX_FIBONACCI/INDEX_FASTRANGE (see src/hash_table_helper.h)
+    // can be given their number of bins, any number for fastrange. Otherwise it's what mersenne_power means for the mode.
+    size_t bins = argc > 5 ? strtoull(argv[5], NULL, 10) : index_bins(INDEX_MODE, mersenne_power);
+#endif
     
     // Initialize table
-#ifdef USE_CHAINING
+    clock_t create_start = clock();
+#if defined(USE_CHAINING) && defined(INDEX_MODE)
+    struct hash_table *table = new_table_with_index(index_power(INDEX_MODE, bins), bins, INDEX_MODE);
+#elif defined(USE_CHAINING)
     struct hash_table *table = new_table(mersenne_power, (1ULL<<mersenne_power)-1);
+#elif defined(USE_BUCKET_CHAINING)
+    // A bin holds up to 14 keys here, so use 8x fewer bins (~6 keys per bin at the usual load).
+    uint8_t bucket_power = mersenne_power > 3 ? mersenne_power - 3 : 1;
+    struct hash_table *table = new_table(bucket_power, (1ULL<<bucket_power)-1);
+#elif defined(USE_FREE_BIT)
+    struct hash_table *table = new_table_with_free_bit(mersenne_power, (1ULL<<mersenne_power)-1);
+#elif defined(INDEX_MODE)
+    struct hash_table *table = empty_table_with_index(bins, INDEX_MODE, DEFAULT_PROBING);
 #else
     struct hash_table *table = empty_table(mersenne_power);
 #endif
@@ -41,6 +107,8 @@ int main(int argc, char **argv) {
         fprintf(stderr, "Failed to allocate table\n");
         return 1;
     }
+    // Mostly how long it takes to get the bins zeroed, see src/table_alloc.h.
+    printf("CREATE,%s,%f\n", TABLE_NAME, (double)(clock() - create_start) / CLOCKS_PER_SEC);
 
     // Generate Data
     // We generate data FIRST so generation time isn't included in insert time.
@@ -58,23 +126,69 @@ int main(int argc, char **argv) {
     }
 
     // Benchmark Insertion
+#ifdef WITH_LATENCY
+    // Per insert latencies, mostly to see what resizing does to the tail.
+    double *latencies = malloc(num_items * sizeof *latencies);
+    if (!latencies) {
+        fprintf(stderr, "Failed to allocate latencies\n");
+        return 1;
+    }
+#endif
     clock_t start = clock();
+#ifdef WITH_BATCH
+    // Chaining and Open Addressing only: the keys go in BATCH_KEYS at a time through the batch API, which overlaps the
+    // cache misses of neighbouring keys.
+    for (size_t i = 0; i < num_items; i += BATCH_KEYS) {
+        insert_keys(table, keys + i, num_items - i < BATCH_KEYS ? num_items - i : BATCH_KEYS);
+    }
+#else
     for (size_t i = 0; i < num_items; ++i) {
+#ifdef WITH_LATENCY
+        double t0 = now_ns();
+        insert_key(table, keys[i]);
+        latencies[i] = now_ns() - t0;
+#else
         insert_key(table, keys[i]);
+#endif
     }
+#endif
     clock_t end = clock();
     
     double insert_time = (double)(end - start) / CLOCKS_PER_SEC;
 
+    // Churn: replace the oldest key with a fresh one, churn_ops times. The table stays at the same load factor but every
+    // delete leaves its mark (tombstones for Open Addressing).
+    if (churn_ops) {
+        clock_t churn_start = clock();
+        for (size_t i = 0; i < churn_ops; ++i) {
+            size_t victim = i % num_items;
+            delete_key(table, keys[victim]);
+            keys[victim] = (unsigned int)xorshift64(&rng_state);
+            if (keys[victim] == 0) keys[victim] = 1;
+            insert_key(table, keys[victim]);
+        }
+        clock_t churn_end = clock();
+        printf("CHURN,%s,%zu,%f\n", TABLE_NAME, churn_ops, (double)(churn_end - churn_start) / CLOCKS_PER_SEC);
+    }
+
     // Benchmark Lookup
     // We look up every key we inserted (Hit case)
     clock_t val_start = clock();
     volatile int hits = 0; // Prevent optimization
+#ifdef WITH_BATCH
+    uint64_t found[BATCH_KEYS / 64];
+    for (size_t i = 0; i < num_items; i += BATCH_KEYS) {
+        size_t n = num_items - i < BATCH_KEYS ? num_items - i : BATCH_KEYS;
+        contains_keys(table, keys + i, n, found);
+        for (size_t w = 0; w < (n + 63) / 64; ++w) hits += __builtin_popcountll(found[w]);
+    }
+#else
     for (size_t i = 0; i < num_items; ++i) {
         if (contains_key(table, keys[i])) {
             hits++;
         }
     }
+#endif
     clock_t val_end = clock();
     double lookup_time = (double)(val_end - val_start) / CLOCKS_PER_SEC;
 
@@ -85,6 +199,18 @@ int main(int argc, char **argv) {
 #else
     printf("BENCH,%s,%f,%f,N/A,N/A\n", TABLE_NAME, insert_time, lookup_time);
 #endif
+#ifdef WITH_METRICS
+    if (churn_ops) print_metrics(table);
+#endif
+
+#ifdef WITH_LATENCY
+    // Format: Name, p50, p99, p99.9, Max (all in ns)
+    qsort(latencies, num_items, sizeof *latencies, compare_doubles);
+    printf("LATENCY,%s,%.0f,%.0f,%.0f,%.0f\n", TABLE_NAME, percentile(latencies, num_items, 0.50),
+           percentile(latencies, num_items, 0.99), percentile(latencies, num_items, 0.999),
+           latencies[num_items - 1]);
+    free(latencies);
+#endif
 
     // Clean up
     free(keys);
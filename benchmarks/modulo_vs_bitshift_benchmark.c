@@ -4,6 +4,7 @@
 #include <stdio.h>
 #include <time.h>
 
+#include "../src/hash_bin_indexes.h"
 #include "../src/hash_table_helper.h"
 
 double
@@ -56,6 +57,42 @@ benchmark_mersenne_prime_bitshift(uint64_t iterations) {
   return run;
 }
 
+benchmark_run_t
+benchmark_mersenne_prime_bitshift_batch(uint64_t iterations) {
+  printf("Benchmarking Mersenne prime bit-shift, batched (hash_bin_indexes, %s)...\n", hash_bin_indexes_kernel());
+  static uint32_t keys[BATCH_SIZE], indexes[BATCH_SIZE];
+
+  // Has to match hash_bin_index exactly. Check that first, on the small keys and the ones right below 2^32.
+  for (uint64_t base = 0; base < (1ULL << 32); base += (1ULL << 32) - 2 * BATCH_SIZE) {
+    for (size_t j = 0; j < BATCH_SIZE; j++) keys[j] = (uint32_t)(base + j * 3);
+    for (uint8_t s = 1; s <= 32; s++) {
+      hash_bin_indexes(keys, indexes, BATCH_SIZE, s);
+      for (size_t j = 0; j < BATCH_SIZE; j++) {
+        if (indexes[j] != hash_bin_index(keys[j], s)) {
+          printf("Unexpected: hash_bin_indexes(%u, %u) = %u, hash_bin_index says %llu\n", keys[j], s, indexes[j],
+                 (unsigned long long)hash_bin_index(keys[j], s));
+          break;
+        }
+      }
+    }
+  }
+
+  // Filling in and adding up BATCH_SIZE keys one by one would cost more than reducing them, so the same batch goes
+  // through every time, with one key changed so there's something new to do.
+  for (size_t j = 0; j < BATCH_SIZE; j++) keys[j] = (uint32_t)(j * 2654435761u);
+  double start = get_time_ms();
+  uint64_t result = 0;
+
+  for (uint64_t i = 0; i < iterations; i += BATCH_SIZE) {
+    keys[0] = (uint32_t)i;
+    hash_bin_indexes(keys, indexes, BATCH_SIZE, POWER_OF_TWO_SHIFT);
+    result += indexes[0] + indexes[BATCH_SIZE - 1];
+  }
+
+  benchmark_run_t run = {get_time_ms() - start, result};
+  return run;
+}
+
 benchmark_run_t
 benchmark_mersenne_modulo(uint64_t iterations) {
   printf("Benchmarking Mersenne prime modulo...\n");
@@ -70,30 +107,69 @@ benchmark_mersenne_modulo(uint64_t iterations) {
   return run;
 }
 
+benchmark_run_t
+benchmark_fibonacci_power_of_two(uint64_t iterations) {
+  printf("Benchmarking Fibonacci hashing into a power of two...\n");
+  double start = get_time_ms();
+  uint64_t result = 0;
+
+  for (uint64_t i = 0; i < iterations; i++) {
+    result += reduce_index(i, INDEX_FIBONACCI, POWER_OF_TWO_SHIFT, POWER_OF_TWO_SIZE);
+  }
+
+  benchmark_run_t run = {get_time_ms() - start, result};
+  return run;
+}
+
+benchmark_run_t
+benchmark_fastrange(uint64_t iterations) {
+  printf("Benchmarking Lemire fastrange (any size)...\n");
+  double start = get_time_ms();
+  uint64_t result = 0;
+
+  // Same size as the non-prime modulo, fastrange doesn't care what it is.
+  for (uint64_t i = 0; i < iterations; i++) {
+    result += reduce_index(i, INDEX_FASTRANGE, POWER_OF_TWO_SHIFT, NON_PRIME_SIZE);
+  }
+
+  benchmark_run_t run = {get_time_ms() - start, result};
+  return run;
+}
+
 benchmark_results_t
 run_modulo_vs_bitshift_benchmark(uint64_t iterations) {
   benchmark_results_t results = {0};
 
   printf("Running modulo vs bit-shift benchmark with %llu iterations...\n", iterations);
-  printf("Comparing four methods:\n");
+  printf("Comparing seven methods:\n");
   printf("  1. Non-prime modulo:     i %% ((1 << 32) - 6)\n");
   printf("  2. Power of two bitmask: i & ((1 << 32) - 1)\n");
   printf("  3. Mersenne prime shift: hash_bin_index(i, 32)\n");
   printf("  4. Mersenne prime modulo: i %% ((1 << 32) - 1)\n");
+  printf("  5. Fibonacci hashing:    (i * 2^64 / phi) >> 32\n");
+  printf("  6. Fastrange:            ((uint32_t)i * ((1 << 32) - 6)) >> 32\n");
+  printf("  7. Mersenne prime shift, batched: hash_bin_indexes(keys, indexes, %d, 32)\n", BATCH_SIZE);
   printf("\n");
 
   benchmark_run_t run1 = benchmark_non_prime_modulo(iterations);
   benchmark_run_t run2 = benchmark_power_of_two_bitmask(iterations);
   benchmark_run_t run3 = benchmark_mersenne_prime_bitshift(iterations);
   benchmark_run_t run4 = benchmark_mersenne_modulo(iterations);
+  benchmark_run_t run5 = benchmark_fibonacci_power_of_two(iterations);
+  benchmark_run_t run6 = benchmark_fastrange(iterations);
+  benchmark_run_t run7 = benchmark_mersenne_prime_bitshift_batch(iterations);
 
   results.non_prime_modulo_ms = run1.time_ms;
   results.power_of_two_bitmask_ms = run2.time_ms;
   results.mersenne_prime_bitshift_ms = run3.time_ms;
   results.mersenne_prime_modulo_ms = run4.time_ms;
+  results.fibonacci_power_of_two_ms = run5.time_ms;
+  results.fastrange_ms = run6.time_ms;
+  results.mersenne_prime_bitshift_batch_ms = run7.time_ms;
 
   // Use results to prevent optimization
-  uint64_t total = run1.result + run2.result + run3.result + run4.result;
+  uint64_t total = run1.result + run2.result + run3.result + run4.result + run5.result + run6.result +
+                   run7.result;
   if (total == 0) printf("Unexpected: all results were zero\n");
 
   // Print results
@@ -107,6 +183,10 @@ run_modulo_vs_bitshift_benchmark(uint64_t iterations) {
   printf("  Power of two bitmask ((1 << 32) - 1): %.3f ms\n", results.power_of_two_bitmask_ms);
   printf("  Mersenne prime bitshift:              %.3f ms\n", results.mersenne_prime_bitshift_ms);
   printf("  Mersenne prime modulo:                %.3f ms\n", results.mersenne_prime_modulo_ms);
+  printf("  Fibonacci hashing (1 << 32):          %.3f ms\n", results.fibonacci_power_of_two_ms);
+  printf("  Fastrange ((1 << 32) - 6):            %.3f ms\n", results.fastrange_ms);
+  printf("  Mersenne prime bitshift, batched:     %.3f ms (%s)\n", results.mersenne_prime_bitshift_batch_ms,
+         hash_bin_indexes_kernel());
 
   // Find fastest and calculate speedups
   double fastest = results.non_prime_modulo_ms;
@@ -124,6 +204,18 @@ run_modulo_vs_bitshift_benchmark(uint64_t iterations) {
     fastest = results.mersenne_prime_modulo_ms;
     fastest_name = "Mersenne prime modulo";
   }
+  if (results.fibonacci_power_of_two_ms < fastest) {
+    fastest = results.fibonacci_power_of_two_ms;
+    fastest_name = "Fibonacci hashing";
+  }
+  if (results.fastrange_ms < fastest) {
+    fastest = results.fastrange_ms;
+    fastest_name = "Fastrange";
+  }
+  if (results.mersenne_prime_bitshift_batch_ms < fastest) {
+    fastest = results.mersenne_prime_bitshift_batch_ms;
+    fastest_name = "Mersenne prime bitshift, batched";
+  }
 
   printf("\n=== Performance Analysis ===\n");
   printf("  Fastest method: %s (%.3f ms)\n", fastest_name, fastest);
@@ -132,6 +224,9 @@ run_modulo_vs_bitshift_benchmark(uint64_t iterations) {
   printf("    Power of two bitmask:    %.2fx slower than fastest\n", results.power_of_two_bitmask_ms / fastest);
   printf("    Mersenne prime bitshift: %.2fx slower than fastest\n", results.mersenne_prime_bitshift_ms / fastest);
   printf("    Mersenne prime modulo:   %.2fx slower than fastest\n", results.mersenne_prime_modulo_ms / fastest);
+  printf("    Fibonacci hashing:       %.2fx slower than fastest\n", results.fibonacci_power_of_two_ms / fastest);
+  printf("    Fastrange:               %.2fx slower than fastest\n", results.fastrange_ms / fastest);
+  printf("    Mersenne batched:        %.2fx slower than fastest\n", results.mersenne_prime_bitshift_batch_ms / fastest);
 
   printf("\n=== SUMMARY ===\n");
   printf("Power of 2 bitmask:\n");
@@ -144,6 +239,15 @@ run_modulo_vs_bitshift_benchmark(uint64_t iterations) {
   printf("\nMersenne prime modulo:\n");
   printf("  - Uses: i %% (2^n - 1)\n");
   printf("  - Standard modulo with Mersenne prime\n");
+  printf("\nMersenne prime bitshift, batched:\n");
+  printf("  - Uses: hash_bin_indexes, the same folds on 8 (AVX2) or 16 (AVX-512) keys at a time\n");
+  printf("  - Picked at runtime from what the CPU supports, same results as hash_bin_index\n");
+  printf("\nFibonacci hashing:\n");
+  printf("  - Uses: (i * 2^64 / phi) >> (64 - n), the top n bits of one multiply\n");
+  printf("  - Power of two sizes like the bitmask, but every bit of i counts, not just the low n\n");
+  printf("\nFastrange:\n");
+  printf("  - Uses: ((uint32_t)i * size) >> 32 (Lemire's multiply-high)\n");
+  printf("  - Any size at all, one multiply, needs a well mixed hash since it's the high bits that decide\n");
   printf("\nNon-prime modulo:\n");
   printf("  - Uses: standard %% operator\n");
   printf("  - No bit-shift optimization available\n");
@@ -9,6 +9,7 @@
 // 1. Non-prime close to 2^32: (1 << 32) - 6
 // 2. Perfect power of 2: 1 << 32
 // 3. Mersenne prime: (1 << 32) - 1
+// Fibonacci hashing uses the power of two size, fastrange the non-prime one (it takes any size).
 
 #define NON_PRIME_SIZE ((1ULL << 32) - 6)  // 2^32 - 6 (not prime)
 #define POWER_OF_TWO_SIZE (1ULL << 32)     // 2^32
@@ -17,6 +18,8 @@
 
 // Default number of iterations for the benchmark loop
 #define DEFAULT_ITERATIONS 100000000
+// Keys per hash_bin_indexes call in the batched benchmark, small enough to stay in L1.
+#define BATCH_SIZE 2048
 
 typedef struct {
   double time_ms;
@@ -28,6 +31,9 @@ typedef struct {
   double power_of_two_bitmask_ms;
   double mersenne_prime_bitshift_ms;
   double mersenne_prime_modulo_ms;
+  double fibonacci_power_of_two_ms;
+  double fastrange_ms;
+  double mersenne_prime_bitshift_batch_ms;
 } benchmark_results_t;
 
 double
@@ -42,9 +48,18 @@ benchmark_power_of_two_bitmask(uint64_t iterations);
 benchmark_run_t
 benchmark_mersenne_prime_bitshift(uint64_t iterations);
 
+benchmark_run_t
+benchmark_mersenne_prime_bitshift_batch(uint64_t iterations);
+
 benchmark_run_t
 benchmark_mersenne_modulo(uint64_t iterations);
 
+benchmark_run_t
+benchmark_fibonacci_power_of_two(uint64_t iterations);
+
+benchmark_run_t
+benchmark_fastrange(uint64_t iterations);
+
 benchmark_results_t
 run_modulo_vs_bitshift_benchmark(uint64_t iterations);
 
@@ -0,0 +1,117 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <inttypes.h>
+#include <unistd.h>
+
+#include "../src/perfect_hash.h"
+
+#ifdef USE_CHAINING
+#include "../src/hash_table.h"
+#define TABLE_NAME "Chaining"
+#define EMPTY_TABLE(power) new_table(power, (1ULL << (power)) - 1)
+#define TABLE_BYTES(table) ((table)->size * sizeof(struct link *) + (table)->count * sizeof(struct link))
+#else
+#include "../src/open_addressing.h"
+#define TABLE_NAME "Open Addressing"
+#define EMPTY_TABLE(power) empty_table(power)
+#define TABLE_BYTES(table) ((table)->size * sizeof(struct bin))
+#endif
+
+// num_items random keys in a table starting at mersenne_power (insert_keys) vs a perfect hash of them, built from 1
+// thread up to max_threads (all cores by default), doubling. Then num_lookups random keys, half of them in the set,
+// through contains_key and perfect_hash_contains. Bytes per key is everything, keys included. Wall clock time.
+
+static double now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+// PRNG for consistent benchmarks across runs with same seed
+static uint64_t xorshift64(uint64_t *state) {
+    uint64_t x = *state;
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+    return *state = x;
+}
+
+#define NUM_LOOKUPS 1000000
+
+int main(int argc, char **argv) {
+    if (argc < 4) {
+        fprintf(stderr, "Usage: %s <seed> <num_items> <mersenne_power> [max_threads]\n", argv[0]);
+        return 1;
+    }
+
+    uint64_t seed = strtoull(argv[1], NULL, 10);
+    size_t num_items = strtoull(argv[2], NULL, 10);
+    uint8_t mersenne_power = (uint8_t)strtoull(argv[3], NULL, 10);
+    int max_threads = argc > 4 ? atoi(argv[4]) : (int)sysconf(_SC_NPROCESSORS_ONLN);
+    if (max_threads < 1) max_threads = 1;
+
+    unsigned int *keys = malloc(num_items * sizeof *keys);
+    unsigned int *lookups = malloc(NUM_LOOKUPS * sizeof *lookups);
+    if (!keys || !lookups) {
+        fprintf(stderr, "Failed to allocate keys\n");
+        return 1;
+    }
+    uint64_t rng_state = seed;
+    for (size_t i = 0; i < num_items; ++i) {
+        keys[i] = (unsigned int)xorshift64(&rng_state);
+        if (keys[i] == 0) keys[i] = 1;
+    }
+    for (size_t i = 0; i < NUM_LOOKUPS; ++i) {
+        uint64_t r = xorshift64(&rng_state);
+        lookups[i] = r % 2 ? keys[(r >> 1) % num_items] : (unsigned int)(r >> 32);
+    }
+
+    // Format: Structure, Threads, BuildTime, BytesPerKey, MetadataBitsPerKey, LookupTime
+    struct hash_table *table = EMPTY_TABLE(mersenne_power);
+    if (!table) {
+        fprintf(stderr, "Failed to allocate table\n");
+        return 1;
+    }
+    double t0 = now_ns();
+    insert_keys(table, keys, num_items);
+    double seconds = (now_ns() - t0) / 1e9;
+    size_t table_hits = 0;
+    t0 = now_ns();
+    for (size_t i = 0; i < NUM_LOOKUPS; ++i) table_hits += contains_key(table, lookups[i]);
+    double lookup_time = (now_ns() - t0) / 1e9;
+    printf("PERFECT,%s,1,%.3f,%.2f,-,%.6f\n", TABLE_NAME, seconds, (double)TABLE_BYTES(table) / table->count,
+           lookup_time);
+    delete_table(table);
+
+    struct perfect_hash *hash = NULL;
+    for (int threads = 1;; threads *= 2) {
+        // Always finish on max_threads, power of two or not.
+        if (threads > max_threads) threads = max_threads;
+        if (hash) delete_perfect_hash(hash);
+        t0 = now_ns();
+        hash = build_perfect_hash(keys, num_items, threads);
+        seconds = (now_ns() - t0) / 1e9;
+        if (!hash) {
+            fprintf(stderr, "Failed to build perfect hash\n");
+            return 1;
+        }
+
+        size_t hits = 0;
+        t0 = now_ns();
+        for (size_t i = 0; i < NUM_LOOKUPS; ++i) hits += perfect_hash_contains(hash, lookups[i]);
+        lookup_time = (now_ns() - t0) / 1e9;
+        if (hits != table_hits) fprintf(stderr, "Perfect hash found %zu, table %zu\n", hits, table_hits);
+
+        size_t metadata = perfect_hash_metadata_bytes(hash);
+        printf("PERFECT,Perfect hash,%d,%.3f,%.2f,%.2f,%.6f\n", threads, seconds,
+               (double)(metadata + hash->count * sizeof *hash->keys) / hash->count, metadata * 8.0 / hash->count,
+               lookup_time);
+        if (threads == max_threads) break;
+    }
+
+    delete_perfect_hash(hash);
+    free(keys);
+    free(lookups);
+    return 0;
+}
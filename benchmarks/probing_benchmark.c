@@ -0,0 +1,105 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <inttypes.h>
+
+#include "../src/open_addressing.h"
+
+// Every probing strategy at every load factor, same keys for all of them. Growing is turned off so the table really
+// sits at the load factor we asked for. Each one is run REPEATS times and the best time is kept, these are short runs.
+
+#define REPEATS 3
+
+static const struct {
+    enum probing probing;
+    const char *name;
+} strategies[] = {
+    {PROBE_LINEAR, "Linear"},
+    {PROBE_TRIANGULAR, "Triangular"},
+    {PROBE_DOUBLE_HASHING, "Double Hashing"},
+};
+
+static const double load_factors[] = {0.5, 0.6, 0.7, 0.8, 0.9, 0.95};
+
+static double now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+// PRNG for consistent benchmarks across runs with same seed
+static uint64_t xorshift64(uint64_t *state) {
+    uint64_t x = *state;
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+    return *state = x;
+}
+
+int main(int argc, char **argv) {
+    if (argc < 3) {
+        fprintf(stderr, "Usage: %s <seed> <mersenne_power>\n", argv[0]);
+        return 1;
+    }
+
+    uint64_t seed = strtoull(argv[1], NULL, 10);
+    uint8_t mersenne_power = (uint8_t)strtoull(argv[2], NULL, 10);
+    size_t size = (1ULL << mersenne_power) - 1;
+
+    // Enough for the highest load factor, plus as many keys again for the misses.
+    size_t max_items = (size_t)(load_factors[sizeof load_factors / sizeof *load_factors - 1] * size);
+    unsigned int *keys = malloc(2 * max_items * sizeof(unsigned int));
+    if (!keys) {
+        fprintf(stderr, "Failed to allocate keys\n");
+        return 1;
+    }
+    uint64_t rng_state = seed;
+    for (size_t i = 0; i < 2 * max_items; ++i) {
+        keys[i] = (unsigned int)xorshift64(&rng_state);
+        if (keys[i] == 0) keys[i] = 1;
+    }
+    unsigned int *misses = keys + max_items;
+
+    // Format: Name, LoadFactor, Insert ns/key, Hit ns/key, Miss ns/key, Collisions/key
+    for (size_t s = 0; s < sizeof strategies / sizeof *strategies; ++s) {
+        for (size_t l = 0; l < sizeof load_factors / sizeof *load_factors; ++l) {
+            size_t num_items = (size_t)(load_factors[l] * size);
+            double best[3] = {1e300, 1e300, 1e300};
+            double collisions = 0;
+
+            for (int r = 0; r < REPEATS; ++r) {
+                struct hash_table *table = empty_table_with_probing(mersenne_power, strategies[s].probing);
+                if (!table) {
+                    fprintf(stderr, "Failed to allocate table\n");
+                    return 1;
+                }
+                set_load_factors(table, 1.0, 1.0);
+
+                double t0 = now_ns();
+                for (size_t i = 0; i < num_items; ++i) insert_key(table, keys[i]);
+                double t1 = now_ns();
+
+                volatile int hits = 0; // Prevent optimization
+                for (size_t i = 0; i < num_items; ++i) hits += contains_key(table, keys[i]);
+                double t2 = now_ns();
+                for (size_t i = 0; i < num_items; ++i) hits += contains_key(table, misses[i]);
+                double t3 = now_ns();
+
+                double times[3] = {t1 - t0, t2 - t1, t3 - t2};
+                for (int t = 0; t < 3; ++t) {
+                    if (times[t] < best[t]) best[t] = times[t];
+                }
+#ifdef WITH_METRICS
+                collisions = (double)table->collisions / num_items;
+#endif
+                delete_table(table);
+            }
+
+            printf("PROBING,%s,%.2f,%.1f,%.1f,%.1f,%.2f\n", strategies[s].name, load_factors[l], best[0] / num_items,
+                   best[1] / num_items, best[2] / num_items, collisions);
+        }
+    }
+
+    free(keys);
+    return 0;
+}
@@ -22,6 +22,61 @@ if [ $? -ne 0 ]; then
     exit 1
 fi
 
+# Compile Bucket Chaining
+# -march=native so the bucket probe gets AVX2 where there is one, it falls back to SSE2/scalar otherwise.
+echo "Compiling Bucket Chaining Benchmark..."
+clang -O2 -march=native -DWITH_METRICS -DUSE_BUCKET_CHAINING -o bench_bucket_chaining main.c ../src/bucket_chaining.c
+
+if [ $? -ne 0 ]; then
+    echo "Compilation of Bucket Chaining failed!"
+    exit 1
+fi
+
+# Compile Swiss Table
+echo "Compiling Swiss Table Benchmark..."
+clang -O2 -DWITH_METRICS -DUSE_SWISS -o bench_swiss main.c ../src/swiss_table.c
+
+if [ $? -ne 0 ]; then
+    echo "Compilation of Swiss Table failed!"
+    exit 1
+fi
+
+# Compile Robin Hood
+echo "Compiling Robin Hood Benchmark..."
+clang -O2 -DWITH_METRICS -DUSE_ROBIN_HOOD -o bench_robin_hood main.c ../src/robin_hood.c
+
+if [ $? -ne 0 ]; then
+    echo "Compilation of Robin Hood failed!"
+    exit 1
+fi
+
+# Compile Cuckoo
+echo "Compiling Cuckoo Benchmark..."
+clang -O2 -DWITH_METRICS -DUSE_CUCKOO -o bench_cuckoo main.c ../src/cuckoo.c
+
+if [ $? -ne 0 ]; then
+    echo "Compilation of Cuckoo failed!"
+    exit 1
+fi
+
+# Compile Free Bit (open addressing with the bin state in bitmaps)
+echo "Compiling Free Bit Benchmark..."
+clang -O2 -DWITH_METRICS -DUSE_FREE_BIT -o bench_free_bit main.c ../src/hash_table_with_free_bit.c
+
+if [ $? -ne 0 ]; then
+    echo "Compilation of Free Bit failed!"
+    exit 1
+fi
+
+# Compile Quotient (Robin Hood storing only the part of the key the bin doesn't give away)
+echo "Compiling Quotient Benchmark..."
+clang -O2 -DWITH_METRICS -DUSE_QUOTIENT -o bench_quotient main.c ../src/quotient_table.c
+
+if [ $? -ne 0 ]; then
+    echo "Compilation of Quotient failed!"
+    exit 1
+fi
+
 # Initialize CSV
 echo "Type,InsertTime,LookupTime,Count,Collisions" > $OUT_FILE
 
@@ -38,6 +93,24 @@ do
     
     # Run Open Addressing
     ./bench_oa $SEED $NUM_ITEMS $MERSENNE_POWER | grep "^BENCH" | cut -d',' -f2- >> $OUT_FILE
+
+    # Run Swiss Table
+    ./bench_swiss $SEED $NUM_ITEMS $MERSENNE_POWER | grep "^BENCH" | cut -d',' -f2- >> $OUT_FILE
+
+    # Run Robin Hood
+    ./bench_robin_hood $SEED $NUM_ITEMS $MERSENNE_POWER | grep "^BENCH" | cut -d',' -f2- >> $OUT_FILE
+
+    # Run Free Bit
+    ./bench_free_bit $SEED $NUM_ITEMS $MERSENNE_POWER | grep "^BENCH" | cut -d',' -f2- >> $OUT_FILE
+
+    # Run Quotient
+    ./bench_quotient $SEED $NUM_ITEMS $MERSENNE_POWER | grep "^BENCH" | cut -d',' -f2- >> $OUT_FILE
+
+    # Run Cuckoo
+    ./bench_cuckoo $SEED $NUM_ITEMS $MERSENNE_POWER | grep "^BENCH" | cut -d',' -f2- >> $OUT_FILE
+
+    # Run Bucket Chaining
+    ./bench_bucket_chaining $SEED $NUM_ITEMS $MERSENNE_POWER | grep "^BENCH" | cut -d',' -f2- >> $OUT_FILE
     
     echo -n "."
 done
@@ -48,24 +121,327 @@ echo "Done. Results in $OUT_FILE"
 echo ""
 echo "=== Summary ==="
 awk -F, '
-{
-    if ($1 == "Chaining") {
-        c_inst += $2; c_look += $3; c_coll += $5; c_count++;
-    } else if ($1 == "Open Addressing") {
-        o_inst += $2; o_look += $3; o_coll += $5; o_count++;
-    }
+NR > 1 {
+    if (!($1 in runs)) order[++types] = $1;
+    runs[$1]++; inst[$1] += $2; look[$1] += $3; coll[$1] += $5;
 }
 END {
-    if (c_count > 0) {
-        printf "Chaining (Avg of %d runs):\n", c_count;
-        printf "  Insert Time: %.6f s\n", c_inst / c_count;
-        printf "  Lookup Time: %.6f s\n", c_look / c_count;
-        printf "  Collisions:  %.2f\n", c_coll / c_count;
-    }
-    if (o_count > 0) {
-        printf "Open Addressing (Avg of %d runs):\n", o_count;
-        printf "  Insert Time: %.6f s\n", o_inst / o_count;
-        printf "  Lookup Time: %.6f s\n", o_look / o_count;
-        printf "  Collisions:  %.2f\n", o_coll / o_count;
+    for (i = 1; i <= types; i++) {
+        t = order[i];
+        printf "%s (Avg of %d runs):\n", t, runs[t];
+        printf "  Insert Time: %.6f s\n", inst[t] / runs[t];
+        printf "  Lookup Time: %.6f s\n", look[t] / runs[t];
+        printf "  Collisions:  %.2f\n", coll[t] / runs[t];
     }
 }' $OUT_FILE
+
+# Churn: 5x the table's worth of delete + insert pairs before the lookups. Open Addressing piles up tombstones, Robin
+# Hood shifts keys back instead.
+CHURN_OPS=$((NUM_ITEMS * 5))
+echo ""
+echo "=== Lookup time after $CHURN_OPS delete + insert pairs ==="
+for bench in bench_oa bench_free_bit bench_robin_hood; do
+    ./$bench 12346 $NUM_ITEMS $MERSENNE_POWER $CHURN_OPS | grep "^BENCH" | cut -d',' -f2,4
+done
+
+# High load: ~0.96 of the 2^19 slots. Open Addressing grows past its 0.9 load factor, Cuckoo is fine where it is.
+HIGH_LOAD_ITEMS=503000
+echo ""
+echo "=== $HIGH_LOAD_ITEMS items into 2^$MERSENNE_POWER slots ==="
+for bench in bench_oa bench_cuckoo; do
+    ./$bench 12346 $HIGH_LOAD_ITEMS $MERSENNE_POWER | grep "^BENCH" | cut -d',' -f2-
+done
+
+# Quotiented keys: from 2^24 on a Quotient slot is 2 bytes, vs 8 for an Open Addressing / Robin Hood bin.
+QUOTIENT_POWER=24
+QUOTIENT_ITEMS=12000000
+echo ""
+echo "=== $QUOTIENT_ITEMS items into 2^$QUOTIENT_POWER - 1 slots ==="
+for bench in bench_oa bench_robin_hood bench_quotient; do
+    ./$bench 12346 $QUOTIENT_ITEMS $QUOTIENT_POWER | grep "^BENCH" | cut -d',' -f2-
+done
+
+# Specialized powers: Open Addressing with its probe loops compiled for each power from 16 to 32 (the default), vs
+# the generic loops that take the power at runtime. No WITH_METRICS, counting collisions hides the difference.
+echo ""
+echo "Compiling Specialization Benchmark..."
+clang -O2 -o bench_oa_specialized main.c ../src/open_addressing.c && \
+clang -O2 -DWITHOUT_SPECIALIZED_POWERS -o bench_oa_generic main.c ../src/open_addressing.c
+
+if [ $? -ne 0 ]; then
+    echo "Compilation of Specialization Benchmark failed!"
+    exit 1
+fi
+
+echo "=== Open Addressing, specialized vs generic probe loops (2^$MERSENNE_POWER - 1 bins, avg of $ITERATIONS runs) ==="
+echo "Loops,InsertTime,LookupTime"
+for bench in bench_oa_specialized bench_oa_generic; do
+    for ((i=1; i<=ITERATIONS; i++)); do
+        ./$bench $((12345 + i)) $NUM_ITEMS $MERSENNE_POWER | grep "^BENCH" | cut -d',' -f3,4
+    done | awk -F, -v name=$bench '{ins += $1; look += $2} END {printf "%s,%.6f,%.6f\n", name, ins / NR, look / NR}'
+done
+
+# Probing strategies: linear, triangular and double hashing at load factors 0.5 - 0.95, growing turned off.
+echo ""
+echo "Compiling Probing Benchmark..."
+clang -O2 -DWITH_METRICS -o bench_probing probing_benchmark.c ../src/open_addressing.c
+
+if [ $? -ne 0 ]; then
+    echo "Compilation of Probing Benchmark failed!"
+    exit 1
+fi
+
+echo "=== Probing strategies (2^$MERSENNE_POWER - 1 bins, ns per key) ==="
+echo "Strategy,LoadFactor,Insert,Hit,Miss,Collisions/key"
+./bench_probing 12346 $MERSENNE_POWER | grep "^PROBING" | cut -d',' -f2-
+
+# Hash functions ahead of hash_bin_index, on random, strided (4 KB apart, like pointers) and adversarial (few values
+# mod 2^s - 1) keys. Smaller table, identity on the adversarial keys is quadratic.
+HASH_POWER=15
+HASH_ITEMS=24000
+echo ""
+echo "Compiling Hash Function Benchmarks..."
+clang -O2 -DUSE_CHAINING -o bench_hash_chaining hash_function_benchmark.c ../src/hash_table.c && \
+clang -O2 -o bench_hash_oa hash_function_benchmark.c ../src/open_addressing.c
+
+if [ $? -ne 0 ]; then
+    echo "Compilation of Hash Function Benchmarks failed!"
+    exit 1
+fi
+
+echo "=== Hash functions ($HASH_ITEMS items, 2^$HASH_POWER - 1 bins, ns per key, lengths in keys compared) ==="
+echo "Table,Function,Keys,Insert,Lookup,MeanLength,p99Length,MaxLength"
+for bench in bench_hash_chaining bench_hash_oa; do
+    ./$bench 12346 $HASH_ITEMS $HASH_POWER | grep "^HASH" | cut -d',' -f2-
+done
+
+# Index reductions: the same keys into 2^19 - 1 bins (Mersenne), 2^19 bins (Fibonacci), and into 2^19 - 1 and 450,000
+# bins with fastrange, which takes any size (e.g. what fits a memory budget).
+BUDGET_BINS=450000
+echo ""
+echo "Compiling Index Reduction Benchmarks..."
+for mode in FIBONACCI FASTRANGE; do
+    clang -O2 -DWITH_METRICS -DUSE_CHAINING -DINDEX_MODE=INDEX_$mode -o bench_chaining_$mode main.c ../src/hash_table.c && \
+    clang -O2 -DWITH_METRICS -DINDEX_MODE=INDEX_$mode -o bench_oa_$mode main.c ../src/open_addressing.c || break
+done
+
+if [ $? -ne 0 ]; then
+    echo "Compilation of Index Reduction Benchmarks failed!"
+    exit 1
+fi
+
+echo "=== Index reductions ($NUM_ITEMS items) ==="
+echo "Table,Mode,Bins,InsertTime,LookupTime,Count,Collisions"
+for bench in chaining oa; do
+    echo -n "$bench,Mersenne,$(((1 << MERSENNE_POWER) - 1)),"
+    ./bench_$bench 12346 $NUM_ITEMS $MERSENNE_POWER | grep "^BENCH" | cut -d',' -f3-
+    echo -n "$bench,Fibonacci,$((1 << MERSENNE_POWER)),"
+    ./bench_${bench}_FIBONACCI 12346 $NUM_ITEMS $MERSENNE_POWER | grep "^BENCH" | cut -d',' -f3-
+    for bins in $(((1 << MERSENNE_POWER) - 1)) $BUDGET_BINS; do
+        echo -n "$bench,Fastrange,$bins,"
+        ./bench_${bench}_FASTRANGE 12346 $NUM_ITEMS $MERSENNE_POWER 0 $bins | grep "^BENCH" | cut -d',' -f3-
+    done
+done
+
+# Page size: a 2^27 - 1 bin table (1 GB of bins for Open Addressing) with 10M keys, so every probe is somewhere random
+# in a lot of memory. 4K pages vs huge pages, see src/table_alloc.h. (The 2^31 run in walkthrough.md needs 16 GB.)
+PAGES_POWER=27
+PAGES_ITEMS=10000000
+echo ""
+echo "Compiling Page Size Benchmarks..."
+clang -O2 -DWITH_SMALL_PAGES -o bench_oa_small_pages main.c ../src/open_addressing.c && \
+clang -O2 -DWITH_HUGE_PAGES -o bench_oa_huge_pages main.c ../src/open_addressing.c
+
+if [ $? -ne 0 ]; then
+    echo "Compilation of Page Size Benchmarks failed!"
+    exit 1
+fi
+
+echo "=== $PAGES_ITEMS items into 2^$PAGES_POWER - 1 bins ==="
+echo "Pages,CreateTime,InsertTime,LookupTime"
+for pages in small huge; do
+    echo -n "$pages,"
+    ./bench_oa_${pages}_pages 12346 $PAGES_ITEMS $PAGES_POWER | grep "^CREATE\|^BENCH" | cut -d',' -f3,4 | paste -sd','
+done
+
+# Batches: the same 10M keys into 2^27 - 1 bins, one key at a time vs insert_keys/contains_keys (1024 keys per call),
+# which prefetch ahead so the cache misses overlap. Only pays off once the table is way bigger than the cache.
+echo ""
+echo "Compiling Batch Benchmarks..."
+clang -O2 -DUSE_CHAINING -o bench_chaining_single main.c ../src/hash_table.c && \
+clang -O2 -DUSE_CHAINING -DWITH_BATCH -o bench_chaining_batch main.c ../src/hash_table.c && \
+clang -O2 -o bench_oa_single main.c ../src/open_addressing.c && \
+clang -O2 -DWITH_BATCH -o bench_oa_batch main.c ../src/open_addressing.c
+
+if [ $? -ne 0 ]; then
+    echo "Compilation of Batch Benchmarks failed!"
+    exit 1
+fi
+
+echo "=== $PAGES_ITEMS items into 2^$PAGES_POWER - 1 bins, single vs batched ==="
+echo "Table,Mode,InsertTime,LookupTime"
+for bench in chaining oa; do
+    for mode in single batch; do
+        echo -n "$bench,$mode,"
+        ./bench_${bench}_${mode} 12346 $PAGES_ITEMS $PAGES_POWER | grep "^BENCH" | cut -d',' -f3,4
+    done
+done
+
+# Growth: start from a tiny table (2^10 - 1 bins) so it has to resize its way up to 2^19 - 1, and compare per insert
+# latency of the incremental migration against a stop-the-world rehash.
+GROWTH_POWER=10
+echo ""
+echo "Compiling Growth Benchmarks..."
+clang -O2 -DWITH_LATENCY -DUSE_CHAINING -o bench_chaining_growth main.c ../src/hash_table.c && \
+clang -O2 -DWITH_LATENCY -DUSE_CHAINING -DMIGRATE_BINS_PER_OP=UINT_MAX -o bench_chaining_growth_stw main.c ../src/hash_table.c && \
+clang -O2 -DWITH_LATENCY -o bench_oa_growth main.c ../src/open_addressing.c && \
+clang -O2 -DWITH_LATENCY -DMIGRATE_BINS_PER_OP=SIZE_MAX -o bench_oa_growth_stw main.c ../src/open_addressing.c
+
+if [ $? -ne 0 ]; then
+    echo "Compilation of Growth Benchmarks failed!"
+    exit 1
+fi
+
+echo "=== Insert latency while growing from 2^$GROWTH_POWER - 1 bins (ns) ==="
+echo "Mode,p50,p99,p99.9,Max"
+for bench in chaining oa; do
+    echo -n "$bench Incremental,"
+    ./bench_${bench}_growth 12346 $NUM_ITEMS $GROWTH_POWER | grep "^LATENCY" | cut -d',' -f3-
+    echo -n "$bench Stop-the-world,"
+    ./bench_${bench}_growth_stw 12346 $NUM_ITEMS $GROWTH_POWER | grep "^LATENCY" | cut -d',' -f3-
+done
+
+# Threads: striped concurrent chaining vs chaining behind one mutex, from 1 thread to every core, mostly reads and
+# half writes. Starts at 2^$MERSENNE_POWER - 1 bins with 1M of 2M keys in.
+CONCURRENT_ITEMS=1000000
+echo ""
+echo "Compiling Concurrent Benchmark..."
+clang -O2 -pthread -o bench_concurrent concurrent_benchmark.c ../src/concurrent_table.c ../src/hash_table.c
+
+if [ $? -ne 0 ]; then
+    echo "Compilation of Concurrent Benchmark failed!"
+    exit 1
+fi
+
+echo "=== Concurrent chaining ($CONCURRENT_ITEMS ops per thread, million ops/s) ==="
+echo "Table,Threads,ReadPercent,Mops"
+for reads in 90 50; do
+    ./bench_concurrent 12346 $CONCURRENT_ITEMS $MERSENNE_POWER $reads | grep "^CONCURRENT" | cut -d',' -f2-
+done
+
+# Lock-free open addressing vs open addressing behind one mutex, at 1 to 16 threads, read heavy and half writes.
+echo ""
+echo "Compiling Lock-Free Benchmark..."
+clang -O2 -pthread -o bench_lock_free lock_free_benchmark.c ../src/lock_free_table.c ../src/open_addressing.c
+
+if [ $? -ne 0 ]; then
+    echo "Compilation of Lock-Free Benchmark failed!"
+    exit 1
+fi
+
+echo "=== Lock-free open addressing ($CONCURRENT_ITEMS ops per thread, million ops/s) ==="
+echo "Table,Threads,ReadPercent,Mops"
+for reads in 95 50; do
+    ./bench_lock_free 12346 $CONCURRENT_ITEMS $MERSENNE_POWER $reads | grep "^LOCKFREE" | cut -d',' -f2-
+done
+
+# The sharded front end, every thread locking shards vs each thread owning its shards (64 shards).
+echo ""
+echo "Compiling Sharded Benchmark..."
+clang -O2 -pthread -o bench_sharded sharded_benchmark.c ../src/sharded_table.c ../src/hash_table.c
+
+if [ $? -ne 0 ]; then
+    echo "Compilation of Sharded Benchmark failed!"
+    exit 1
+fi
+
+echo "=== Sharded chaining ($CONCURRENT_ITEMS ops per thread, million ops/s) ==="
+echo "Mode,Threads,ReadPercent,Mops"
+for reads in 90 50; do
+    ./bench_sharded 12346 $CONCURRENT_ITEMS $MERSENNE_POWER 6 $reads | grep "^SHARDED" | cut -d',' -f2-
+done
+
+# Bulk loading: an insert_key loop vs build_table (radix partitioned, one range of bins per thread), 1 to all cores.
+BULK_ITEMS=20000000
+echo ""
+echo "Compiling Bulk Build Benchmarks..."
+clang -O2 -pthread -DUSE_CHAINING -o bench_bulk_chaining bulk_build_benchmark.c ../src/hash_table.c ../src/hash_table_bulk.c ../src/radix_partition.c && \
+clang -O2 -pthread -o bench_bulk_oa bulk_build_benchmark.c ../src/open_addressing.c ../src/open_addressing_bulk.c ../src/radix_partition.c
+
+if [ $? -ne 0 ]; then
+    echo "Compilation of Bulk Build Benchmarks failed!"
+    exit 1
+fi
+
+echo "=== Bulk build ($BULK_ITEMS random keys) ==="
+echo "Table,Method,Threads,Seconds,Mkeys"
+for table in chaining oa; do
+    ./bench_bulk_$table 12346 $BULK_ITEMS $MERSENNE_POWER | grep "^BULK" | cut -d',' -f2-
+done
+
+# Snapshots: map_table on a file from save_table vs building the table again, 20K to 20M keys.
+echo ""
+echo "Compiling Snapshot Benchmark..."
+clang -O2 -o bench_snapshot snapshot_benchmark.c ../src/open_addressing.c
+
+if [ $? -ne 0 ]; then
+    echo "Compilation of Snapshot Benchmark failed!"
+    exit 1
+fi
+
+echo "=== Open Addressing snapshots (page cache warm, 1M lookups) ==="
+echo "Items,FileMB,BuildTime,SaveTime,MapTime,LookupTimeMapped,LookupTimeBuilt"
+./bench_snapshot 12346 20000000 $MERSENNE_POWER | grep "^SNAPSHOT" | cut -d',' -f2-
+
+# Streaming ingest: key files (and a pipe) through src/key_stream.c and insert_keys, binary and text.
+echo ""
+echo "Compiling Ingest Benchmarks..."
+clang -O2 -pthread -DUSE_CHAINING -o bench_ingest_chaining ingest_benchmark.c ../src/hash_table.c ../src/key_stream.c && \
+clang -O2 -pthread -o bench_ingest_oa ingest_benchmark.c ../src/open_addressing.c ../src/key_stream.c
+
+if [ $? -ne 0 ]; then
+    echo "Compilation of Ingest Benchmarks failed!"
+    exit 1
+fi
+
+./bench_ingest_oa write keys.bin binary 12346 $BULK_ITEMS
+./bench_ingest_oa write keys.txt text 12346 $BULK_ITEMS
+echo "=== Streaming ingest ($BULK_ITEMS random keys, page cache warm) ==="
+echo "Table,Format,Keys,Count,MB,Seconds,Mkeys/s,MB/s"
+for table in chaining oa; do
+    ./bench_ingest_$table load keys.bin binary $MERSENNE_POWER | grep "^INGEST" | cut -d',' -f2-
+    ./bench_ingest_$table load keys.txt text $MERSENNE_POWER | grep "^INGEST" | cut -d',' -f2-
+    cat keys.txt | ./bench_ingest_$table load - text $MERSENNE_POWER | grep "^INGEST" | cut -d',' -f2-
+done
+rm -f keys.bin keys.txt
+
+# Frozen chaining tables: contains_key on the chains vs the same keys frozen into offsets + keys, 200K to 20M keys.
+echo ""
+echo "Compiling Frozen Table Benchmark..."
+clang -O2 -o bench_frozen frozen_benchmark.c ../src/hash_table.c ../src/frozen_table.c
+
+if [ $? -ne 0 ]; then
+    echo "Compilation of Frozen Table Benchmark failed!"
+    exit 1
+fi
+
+echo "=== Frozen chaining tables (1M lookups, seconds) ==="
+echo "Items,ChainedMB,FrozenMB,FreezeTime,MapTime,Chained,ChainedBatch,Frozen,FrozenBatch,Mapped"
+./bench_frozen 12346 $BULK_ITEMS $MERSENNE_POWER | grep "^FROZEN" | cut -d',' -f2-
+
+# Minimal perfect hash: build time, bytes per key and lookups against contains_key on chaining and open addressing.
+echo ""
+echo "Compiling Perfect Hash Benchmarks..."
+clang -O2 -pthread -DUSE_CHAINING -o bench_perfect_chaining perfect_hash_benchmark.c ../src/hash_table.c ../src/perfect_hash.c ../src/radix_partition.c && \
+clang -O2 -pthread -o bench_perfect_oa perfect_hash_benchmark.c ../src/open_addressing.c ../src/perfect_hash.c ../src/radix_partition.c
+
+if [ $? -ne 0 ]; then
+    echo "Compilation of Perfect Hash Benchmarks failed!"
+    exit 1
+fi
+
+echo "=== Perfect hash vs tables ($BULK_ITEMS random keys, 1M lookups) ==="
+echo "Structure,Threads,BuildTime,BytesPerKey,MetadataBitsPerKey,LookupTime"
+./bench_perfect_chaining 12346 $BULK_ITEMS $MERSENNE_POWER | grep "^PERFECT" | cut -d',' -f2-
+# The perfect hash rows would be the same again.
+./bench_perfect_oa 12346 $BULK_ITEMS $MERSENNE_POWER 1 | grep "^PERFECT,Open" | cut -d',' -f2-
@@ -0,0 +1,176 @@
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <inttypes.h>
+#include <unistd.h>
+
+#include "../src/sharded_table.h"
+
+// The sharded front end (src/sharded_table.c) both ways: every thread going through the shard locks, and shared-nothing
+// where each thread owns its shards and sends everything else to their owners. Same workload as concurrent_benchmark.c:
+// every thread does num_items operations on keys picked at random from 2 * num_items keys, half of them in the table to
+// begin with, read_percent of them lookups and the rest inserts and deletes half and half. The operations are picked
+// before the clock starts, run_shard_ops wants them up front. From 1 thread up to max_threads (all cores by default),
+// doubling, and 2^shard_bits shards of 2^(mersenne_power - shard_bits) - 1 bins each.
+
+static double now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+// PRNG for consistent benchmarks across runs with same seed
+static uint64_t xorshift64(uint64_t *state) {
+    uint64_t x = *state;
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+    return *state = x;
+}
+
+enum mode { LOCKED, SHARED_NOTHING };
+static const char *mode_names[] = {"Locked", "Shared-nothing"};
+
+struct shared {
+    enum mode mode;
+    struct sharded_table *table;
+    struct shard_group *group;
+    size_t ops;
+    pthread_barrier_t start;
+};
+
+struct worker {
+    struct shared *shared;
+    int id;
+    enum shard_op *ops;
+    unsigned int *keys;
+    uint64_t *hits;
+};
+
+static void *run_worker(void *arg) {
+    struct worker *worker = arg;
+    struct shared *shared = worker->shared;
+
+    pthread_barrier_wait(&shared->start);
+    if (shared->mode == SHARED_NOTHING) {
+        run_shard_ops(shared->group, worker->id, worker->ops, worker->keys, shared->ops, worker->hits);
+    } else {
+        for (size_t i = 0; i < shared->ops; ++i) {
+            switch (worker->ops[i]) {
+            case SHARD_CONTAINS:
+                if (sharded_contains_key(shared->table, worker->keys[i])) worker->hits[i / 64] |= 1ULL << (i % 64);
+                break;
+            case SHARD_INSERT:
+                sharded_insert_key(shared->table, worker->keys[i]);
+                break;
+            case SHARD_DELETE:
+                sharded_delete_key(shared->table, worker->keys[i]);
+                break;
+            }
+        }
+    }
+    pthread_barrier_wait(&shared->start);
+    return NULL;
+}
+
+// Returns million operations per second.
+static double run(enum mode mode, const unsigned int *keys, size_t num_keys, size_t ops, uint8_t power,
+                  uint8_t shard_bits, unsigned int read_percent, int threads, uint64_t seed) {
+    uint8_t shard_power = power > shard_bits + 1 ? power - shard_bits : 1;
+    struct shared shared = {.mode = mode, .ops = ops};
+    shared.table = new_sharded_table(shard_bits, shard_power);
+    if (!shared.table) {
+        fprintf(stderr, "Failed to allocate table\n");
+        exit(1);
+    }
+    for (size_t i = 0; i < num_keys; i += 2) sharded_insert_key(shared.table, keys[i]);
+    if (mode == SHARED_NOTHING && !(shared.group = new_shard_group(shared.table, threads))) {
+        fprintf(stderr, "Failed to allocate shard group\n");
+        exit(1);
+    }
+    // The workers plus us, so we can start the clock when they start.
+    pthread_barrier_init(&shared.start, NULL, threads + 1);
+
+    pthread_t ids[threads];
+    struct worker workers[threads];
+    for (int t = 0; t < threads; ++t) {
+        workers[t] = (struct worker){.shared = &shared, .id = t};
+        workers[t].ops = malloc(ops * sizeof *workers[t].ops);
+        workers[t].keys = malloc(ops * sizeof *workers[t].keys);
+        workers[t].hits = calloc((ops + 63) / 64, sizeof *workers[t].hits);
+        if (!workers[t].ops || !workers[t].keys || !workers[t].hits) {
+            fprintf(stderr, "Failed to allocate operations\n");
+            exit(1);
+        }
+        uint64_t rng_state = seed + t + 1;
+        for (size_t i = 0; i < ops; ++i) {
+            uint64_t r = xorshift64(&rng_state);
+            unsigned int op = r % 100;
+            workers[t].keys[i] = keys[(r >> 8) % num_keys];
+            workers[t].ops[i] = op < read_percent ? SHARD_CONTAINS : op % 2 ? SHARD_INSERT : SHARD_DELETE;
+        }
+        pthread_create(&ids[t], NULL, run_worker, &workers[t]);
+    }
+    pthread_barrier_wait(&shared.start);
+    double t0 = now_ns();
+    pthread_barrier_wait(&shared.start);
+    double t1 = now_ns();
+    for (int t = 0; t < threads; ++t) {
+        pthread_join(ids[t], NULL);
+        free(workers[t].ops);
+        free(workers[t].keys);
+        free(workers[t].hits);
+    }
+
+    pthread_barrier_destroy(&shared.start);
+    if (shared.group) delete_shard_group(shared.group);
+    delete_sharded_table(shared.table);
+    return (double)ops * threads / (t1 - t0) * 1e3;
+}
+
+int main(int argc, char **argv) {
+    if (argc < 4) {
+        fprintf(stderr, "Usage: %s <seed> <num_items> <mersenne_power> [shard_bits] [read_percent] [max_threads]\n",
+                argv[0]);
+        return 1;
+    }
+
+    uint64_t seed = strtoull(argv[1], NULL, 10);
+    size_t num_items = strtoull(argv[2], NULL, 10);
+    uint8_t mersenne_power = (uint8_t)strtoull(argv[3], NULL, 10);
+    uint8_t shard_bits = argc > 4 ? (uint8_t)strtoul(argv[4], NULL, 10) : 6;
+    unsigned int read_percent = argc > 5 ? (unsigned int)strtoul(argv[5], NULL, 10) : 90;
+    int max_threads = argc > 6 ? atoi(argv[6]) : (int)sysconf(_SC_NPROCESSORS_ONLN);
+    if (max_threads < 1) max_threads = 1;
+    if (shard_bits > MAX_SHARD_BITS) {
+        fprintf(stderr, "At most %d shard bits\n", MAX_SHARD_BITS);
+        return 1;
+    }
+
+    size_t num_keys = 2 * num_items;
+    unsigned int *keys = malloc(num_keys * sizeof *keys);
+    if (!keys) {
+        fprintf(stderr, "Failed to allocate keys\n");
+        return 1;
+    }
+    uint64_t rng_state = seed;
+    for (size_t i = 0; i < num_keys; ++i) {
+        keys[i] = (unsigned int)xorshift64(&rng_state);
+        if (keys[i] == 0) keys[i] = 1;
+    }
+
+    // Format: Mode, Threads, ReadPercent, Mops/s
+    for (int threads = 1;; threads *= 2) {
+        // Always finish on max_threads, power of two or not.
+        if (threads > max_threads) threads = max_threads;
+        for (int mode = LOCKED; mode <= SHARED_NOTHING; ++mode) {
+            double mops = run(mode, keys, num_keys, num_items, mersenne_power, shard_bits, read_percent, threads, seed);
+            printf("SHARDED,%s,%d,%u,%.2f\n", mode_names[mode], threads, read_percent, mops);
+        }
+        if (threads == max_threads) break;
+    }
+
+    free(keys);
+    return 0;
+}
@@ -0,0 +1,106 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <inttypes.h>
+#include <unistd.h>
+
+#include "../src/open_addressing.h"
+
+// Cold start from a snapshot vs building the table again, at max_items / 1000, / 100, / 10 and max_items random keys.
+// Building is insert_keys into an empty table at mersenne_power, which grows as it goes. Mapping is map_table on the
+// file save_table just wrote, so its pages are still in the page cache. The lookups are num_lookups random keys, half
+// of them in the table, against the mapped table and the one that was built.
+
+static double now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+// PRNG for consistent benchmarks across runs with same seed
+static uint64_t xorshift64(uint64_t *state) {
+    uint64_t x = *state;
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+    return *state = x;
+}
+
+#define NUM_LOOKUPS 1000000
+
+static double time_lookups(struct hash_table *table, const unsigned int *lookups, size_t *hits) {
+    double t0 = now_ns();
+    *hits = 0;
+    for (size_t i = 0; i < NUM_LOOKUPS; ++i) *hits += contains_key(table, lookups[i]);
+    return (now_ns() - t0) / 1e9;
+}
+
+int main(int argc, char **argv) {
+    if (argc < 4) {
+        fprintf(stderr, "Usage: %s <seed> <max_items> <mersenne_power> [snapshot_path]\n", argv[0]);
+        return 1;
+    }
+
+    uint64_t seed = strtoull(argv[1], NULL, 10);
+    size_t max_items = strtoull(argv[2], NULL, 10);
+    uint8_t mersenne_power = (uint8_t)strtoull(argv[3], NULL, 10);
+    const char *path = argc > 4 ? argv[4] : "snapshot.bin";
+
+    unsigned int *keys = malloc(max_items * sizeof *keys);
+    unsigned int *lookups = malloc(NUM_LOOKUPS * sizeof *lookups);
+    if (!keys || !lookups) {
+        fprintf(stderr, "Failed to allocate keys\n");
+        return 1;
+    }
+    uint64_t rng_state = seed;
+    for (size_t i = 0; i < max_items; ++i) keys[i] = (unsigned int)xorshift64(&rng_state);
+
+    // Format: Items, FileMB, BuildTime, SaveTime, MapTime, LookupTimeMapped, LookupTimeBuilt
+    for (size_t num_items = max_items / 1000; num_items <= max_items; num_items *= 10) {
+        if (!num_items) continue;
+        for (size_t i = 0; i < NUM_LOOKUPS; ++i) {
+            uint64_t r = xorshift64(&rng_state);
+            lookups[i] = r % 2 ? keys[(r >> 1) % num_items] : (unsigned int)(r >> 32);
+        }
+
+        struct hash_table *built = empty_table(mersenne_power);
+        if (!built) {
+            fprintf(stderr, "Failed to allocate table\n");
+            return 1;
+        }
+        double t0 = now_ns();
+        insert_keys(built, keys, num_items);
+        double build_time = (now_ns() - t0) / 1e9;
+
+        t0 = now_ns();
+        if (!save_table(built, path)) {
+            perror("save_table");
+            return 1;
+        }
+        double save_time = (now_ns() - t0) / 1e9;
+
+        t0 = now_ns();
+        struct hash_table *mapped = map_table(path);
+        double map_time = (now_ns() - t0) / 1e9;
+        if (!mapped) {
+            fprintf(stderr, "map_table failed\n");
+            return 1;
+        }
+
+        size_t mapped_hits, built_hits;
+        double mapped_time = time_lookups(mapped, lookups, &mapped_hits);
+        double built_time = time_lookups(built, lookups, &built_hits);
+        if (mapped_hits != built_hits) fprintf(stderr, "Mapped table found %zu, built one %zu\n", mapped_hits, built_hits);
+
+        printf("SNAPSHOT,%zu,%.1f,%.6f,%.6f,%.6f,%.6f,%.6f\n", num_items,
+               (SNAPSHOT_HEADER_SIZE + mapped->size * sizeof(struct bin)) / 1e6, build_time, save_time, map_time,
+               mapped_time, built_time);
+        delete_table(mapped);
+        delete_table(built);
+    }
+
+    unlink(path);
+    free(keys);
+    free(lookups);
+    return 0;
+}
@@ -0,0 +1,198 @@
+#ifndef THREAD_BENCHMARK_H
+#define THREAD_BENCHMARK_H
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+/*
+ * The pthread driver the concurrent table benchmarks share. Every thread does ops_per_thread operations on keys picked
+ * at random from num_keys keys, half of them in the table to begin with: read_percent of them lookups, the rest inserts
+ * and deletes half and half, so the table stays about the same size. All a benchmark brings is its tables, as a struct
+ * thread_table each.
+ */
+
+struct thread_table {
+    const char *name;
+    // An empty table starting at 2^power - 1 bins, NULL if it couldn't be made.
+    void *(*create)(uint8_t power);
+    void (*destroy)(void *table);
+    // What a thread passes to the operations, for tables that want threads to register. NULL means the table itself.
+    void *(*join)(void *table);
+    void (*leave)(void *handle);
+    bool (*contains)(void *handle, unsigned int key);
+    void (*insert)(void *handle, unsigned int key);
+    void (*delete)(void *handle, unsigned int key);
+};
+
+static double now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+// PRNG for consistent benchmarks across runs with same seed
+static uint64_t xorshift64(uint64_t *state) {
+    uint64_t x = *state;
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+    return *state = x;
+}
+
+// num_keys random keys, none of them 0 (no table takes it).
+static unsigned int *random_keys(size_t num_keys, uint64_t seed) {
+    unsigned int *keys = malloc(num_keys * sizeof *keys);
+    if (!keys) {
+        fprintf(stderr, "Failed to allocate keys\n");
+        exit(1);
+    }
+    uint64_t rng_state = seed;
+    for (size_t i = 0; i < num_keys; ++i) {
+        keys[i] = (unsigned int)xorshift64(&rng_state);
+        if (keys[i] == 0) keys[i] = 1;
+    }
+    return keys;
+}
+
+struct thread_shared {
+    const struct thread_table *ops;
+    void *table;
+    const unsigned int *keys;
+    size_t num_keys;
+    size_t ops_per_thread;
+    unsigned int read_percent;
+    pthread_barrier_t start;
+};
+
+struct thread_worker {
+    struct thread_shared *shared;
+    uint64_t seed;
+    size_t hits;
+};
+
+static void *join_thread_table(const struct thread_table *ops, void *table) {
+    void *handle = ops->join ? ops->join(table) : table;
+    if (!handle) {
+        fprintf(stderr, "Failed to join table\n");
+        exit(1);
+    }
+    return handle;
+}
+
+static void *run_thread_worker(void *arg) {
+    struct thread_worker *worker = arg;
+    struct thread_shared *shared = worker->shared;
+    const struct thread_table *ops = shared->ops;
+    void *handle = join_thread_table(ops, shared->table);
+    uint64_t rng_state = worker->seed;
+
+    pthread_barrier_wait(&shared->start);
+    for (size_t i = 0; i < shared->ops_per_thread; ++i) {
+        uint64_t r = xorshift64(&rng_state);
+        unsigned int key = shared->keys[(r >> 8) % shared->num_keys];
+        unsigned int op = r % 100;
+
+        if (op < shared->read_percent)
+            worker->hits += ops->contains(handle, key);
+        else if (op % 2)
+            ops->insert(handle, key);
+        else
+            ops->delete(handle, key);
+    }
+    pthread_barrier_wait(&shared->start);
+
+    if (ops->leave) ops->leave(handle);
+    return NULL;
+}
+
+// Returns million operations per second.
+static double run_threads(const struct thread_table *ops, const unsigned int *keys, size_t num_keys,
+                          size_t ops_per_thread, uint8_t power, unsigned int read_percent, int threads, uint64_t seed) {
+    struct thread_shared shared = {.ops = ops, .keys = keys, .num_keys = num_keys, .ops_per_thread = ops_per_thread,
+                                   .read_percent = read_percent};
+    if (!(shared.table = ops->create(power))) {
+        fprintf(stderr, "Failed to allocate table\n");
+        exit(1);
+    }
+    void *handle = join_thread_table(ops, shared.table);
+    for (size_t i = 0; i < num_keys; i += 2) ops->insert(handle, keys[i]);
+    if (ops->leave) ops->leave(handle);
+    // The workers plus us, so we can start the clock when they start.
+    pthread_barrier_init(&shared.start, NULL, threads + 1);
+
+    pthread_t ids[threads];
+    struct thread_worker workers[threads];
+    for (int t = 0; t < threads; ++t) {
+        workers[t] = (struct thread_worker){.shared = &shared, .seed = seed + t + 1, .hits = 0};
+        pthread_create(&ids[t], NULL, run_thread_worker, &workers[t]);
+    }
+    pthread_barrier_wait(&shared.start);
+    double t0 = now_ns();
+    pthread_barrier_wait(&shared.start);
+    double t1 = now_ns();
+    for (int t = 0; t < threads; ++t) pthread_join(ids[t], NULL);
+
+    pthread_barrier_destroy(&shared.start);
+    ops->destroy(shared.table);
+    return (double)ops_per_thread * threads / (t1 - t0) * 1e3;
+}
+
+/*
+ * A single threaded table behind one mutex, the baseline every benchmark compares against. LOCKED_TABLE(name, title,
+ * type, create) defines name##_ops for it, called title in the output, with create(power) making an empty table of type
+ * and the usual insert_key, contains_key, delete_key and delete_table.
+ */
+struct locked_table {
+    pthread_mutex_t lock;
+    void *table;
+};
+
+#define LOCKED_TABLE(name, title, type, create_table)                                                                \
+    static void *name##_create(uint8_t power) {                                                                      \
+        struct locked_table *locked = malloc(sizeof *locked);                                                        \
+        if (!locked) return NULL;                                                                                    \
+        if (!(locked->table = create_table(power))) {                                                                \
+            free(locked);                                                                                            \
+            return NULL;                                                                                             \
+        }                                                                                                            \
+        pthread_mutex_init(&locked->lock, NULL);                                                                     \
+        return locked;                                                                                               \
+    }                                                                                                                \
+                                                                                                                     \
+    static void name##_destroy(void *arg) {                                                                          \
+        struct locked_table *locked = arg;                                                                           \
+        pthread_mutex_destroy(&locked->lock);                                                                        \
+        delete_table((type *)locked->table);                                                                         \
+        free(locked);                                                                                                \
+    }                                                                                                                \
+                                                                                                                     \
+    static bool name##_contains(void *arg, unsigned int key) {                                                       \
+        struct locked_table *locked = arg;                                                                           \
+        pthread_mutex_lock(&locked->lock);                                                                           \
+        bool found = contains_key((type *)locked->table, key);                                                       \
+        pthread_mutex_unlock(&locked->lock);                                                                         \
+        return found;                                                                                                \
+    }                                                                                                                \
+                                                                                                                     \
+    static void name##_insert(void *arg, unsigned int key) {                                                         \
+        struct locked_table *locked = arg;                                                                           \
+        pthread_mutex_lock(&locked->lock);                                                                           \
+        insert_key((type *)locked->table, key);                                                                      \
+        pthread_mutex_unlock(&locked->lock);                                                                         \
+    }                                                                                                                \
+                                                                                                                     \
+    static void name##_delete(void *arg, unsigned int key) {                                                         \
+        struct locked_table *locked = arg;                                                                           \
+        pthread_mutex_lock(&locked->lock);                                                                           \
+        delete_key((type *)locked->table, key);                                                                      \
+        pthread_mutex_unlock(&locked->lock);                                                                         \
+    }                                                                                                                \
+                                                                                                                     \
+    static const struct thread_table name##_ops = {title,           name##_create, name##_destroy, NULL, NULL,       \
+                                                   name##_contains, name##_insert, name##_delete}
+
+#endif
@@ -0,0 +1,174 @@
+#include "bucket_chaining.h"
+
+#include <string.h>
+
+#include "hash_table_helper.h"
+
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+#define BUCKET_LANES_MASK ((1u << KEYS_PER_BUCKET) - 1)
+
+/*
+ * Returns a bitmask with bit i set if bucket->keys[i] == key.
+ *
+ * The bucket is loaded as 16 ints in one go (that's the whole cache line), the last two lanes are the next pointer so
+ * they get masked off.
+ */
+static inline uint32_t
+bucket_match(const struct bucket *bucket, unsigned int key) {
+#if defined(__AVX2__)
+  const __m256i *lanes = (const __m256i *)bucket;
+  __m256i needle = _mm256_set1_epi32((int)key);
+  uint32_t lo = (uint32_t)_mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(_mm256_load_si256(lanes), needle)));
+  uint32_t hi =
+      (uint32_t)_mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(_mm256_load_si256(lanes + 1), needle)));
+  return (lo | hi << 8) & BUCKET_LANES_MASK;
+#elif defined(__SSE2__)
+  const __m128i *lanes = (const __m128i *)bucket;
+  __m128i needle = _mm_set1_epi32((int)key);
+  uint32_t mask = 0;
+  for (int i = 0; i < 4; i++) {
+    __m128i eq = _mm_cmpeq_epi32(_mm_load_si128(lanes + i), needle);
+    mask |= (uint32_t)_mm_movemask_ps(_mm_castsi128_ps(eq)) << (4 * i);
+  }
+  return mask & BUCKET_LANES_MASK;
+#else
+  uint32_t mask = 0;
+  for (int i = 0; i < KEYS_PER_BUCKET; i++) {
+    mask |= (uint32_t)(bucket->keys[i] == key) << i;
+  }
+  return mask;
+#endif
+}
+
+static struct bucket *
+new_bucket(void) {
+  struct bucket *bucket = aligned_alloc(sizeof *bucket, sizeof *bucket);
+  if (bucket) memset(bucket, 0, sizeof *bucket);
+  return bucket;
+}
+
+struct hash_table *
+new_table(uint8_t mersenne_prime_power, unsigned int size) {
+  struct hash_table *table = (struct hash_table *)malloc(sizeof *table);
+  // Buckets have to stay cache line aligned or every lookup touches two lines.
+  struct bucket *bins = aligned_alloc(sizeof *bins, (size_t)size * sizeof *bins);
+
+  // Sadly malloc can fail.
+  if (!table || !bins) goto error;
+
+  // All zeroes means every slot is DEFAULT_KEY and there's no overflow bucket.
+  memset(bins, 0, (size_t)size * sizeof *bins);
+  table->bins = bins;
+  table->size = size;
+  table->mersenne_prime_power = mersenne_prime_power;
+  table->count = 0;
+
+#ifdef WITH_METRICS
+  table->collisions = 0;
+  table->overflow_buckets = 0;
+#endif
+
+  return table;
+
+error:
+  free(table);
+  free(bins);
+  return NULL;
+}
+
+void
+delete_table(struct hash_table *table) {
+  for (struct bucket *bin = table->bins; bin < table->bins + table->size; bin++) {
+    struct bucket *bucket = bin->next;
+    while (bucket) {
+      struct bucket *next = bucket->next;
+      free(bucket);
+      bucket = next;
+    }
+  }
+  free(table->bins);
+  free(table);
+}
+
+struct bucket *
+get_bin_for_key(struct hash_table *table, unsigned int key) {
+  return (table->bins) + hash_bin_index(key, table->mersenne_prime_power);
+}
+
+void
+insert_key(struct hash_table *table, unsigned int key) {
+  // Same as hash_table.c, DEFAULT_KEY marks an empty slot.
+  if (key == DEFAULT_KEY) return;
+
+  struct bucket *bin = get_bin_for_key(table, key);
+  struct bucket *free_bucket = NULL;
+  uint32_t free_slots = 0;
+
+  // No duplicates, so we have to look at the whole chain anyway. Remember the first hole on the way.
+  for (struct bucket *bucket = bin; bucket; bucket = bucket->next) {
+    if (bucket_match(bucket, key)) return;
+    if (!free_bucket && (free_slots = bucket_match(bucket, DEFAULT_KEY))) free_bucket = bucket;
+  }
+
+#ifdef WITH_METRICS
+  // Same as hash_table.c, it's a collision if the bin already had something in it.
+  if (bin->next || bucket_match(bin, DEFAULT_KEY) != BUCKET_LANES_MASK) {
+    table->collisions++;
+  }
+#endif
+
+  if (!free_bucket) {
+    // Every bucket is full, put a new one right behind the inline one.
+    if (!(free_bucket = new_bucket())) return;
+    free_bucket->next = bin->next;
+    bin->next = free_bucket;
+    free_slots = BUCKET_LANES_MASK;
+#ifdef WITH_METRICS
+    table->overflow_buckets++;
+#endif
+  }
+
+  free_bucket->keys[__builtin_ctz(free_slots)] = key;
+  table->count++;
+}
+
+bool
+contains_key(struct hash_table *table, unsigned int key) {
+  // DEFAULT_KEY would match every empty slot.
+  if (key == DEFAULT_KEY) return false;
+
+  for (struct bucket *bucket = get_bin_for_key(table, key); bucket; bucket = bucket->next) {
+    if (bucket_match(bucket, key)) return true;
+  }
+  return false;
+}
+
+void
+delete_key(struct hash_table *table, unsigned int key) {
+  if (key == DEFAULT_KEY) return;
+
+  for (struct bucket *bucket = get_bin_for_key(table, key); bucket; bucket = bucket->next) {
+    uint32_t match = bucket_match(bucket, key);
+    if (match) {
+      bucket->keys[__builtin_ctz(match)] = DEFAULT_KEY;
+      table->count--;
+      return;
+    }
+  }
+}
+
+#ifdef WITH_METRICS
+#include <stdio.h>
+void
+print_metrics(struct hash_table *table) {
+  size_t bytes = ((size_t)table->size + table->overflow_buckets) * sizeof(struct bucket);
+  printf("Total stats:\n");
+  printf("Count            : %zu\n", table->count);
+  printf("Collisions       : %zu\n", table->collisions);
+  printf("Overflow buckets : %zu\n", table->overflow_buckets);
+  printf("Bytes per key    : %.2f\n", table->count ? (double)bytes / table->count : 0.0);
+}
+#endif
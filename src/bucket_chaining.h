@@ -0,0 +1,67 @@
+#ifndef BUCKET_CHAINING_H
+#define BUCKET_CHAINING_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+/*
+ * Chaining, but with one cache line per node instead of one key per node.
+ *
+ * A struct link spends 8 bytes of pointer (plus 4 of padding) on every 4 byte key, and every key in a chain is another
+ * pointer to chase. Here a node is a 64 byte bucket: 14 keys and a next pointer. The first bucket of every bin lives
+ * inline in the bin array, so most lookups are a single cache line, no pointer chasing at all. Overflow buckets only
+ * show up when a bin gets more than 14 keys.
+ *
+ * Since a bin now holds a bucket's worth of keys, you want about 8x fewer bins than with hash_table.c for the same
+ * number of keys (new_table(s - 3, ...) instead of new_table(s, ...)).
+ *
+ * Empty slots hold DEFAULT_KEY, same as hash_table.h, so 0 can't be inserted. Deleting just clears the slot, holes
+ * are fine since lookups look at the whole bucket anyway.
+ */
+
+#define DEFAULT_KEY (unsigned int)0
+#define KEYS_PER_BUCKET 14
+
+struct bucket {
+  unsigned int keys[KEYS_PER_BUCKET];
+  struct bucket *next;
+};
+
+_Static_assert(sizeof(struct bucket) == 64, "a bucket should be exactly one cache line");
+
+struct hash_table {
+  unsigned int size;
+  uint8_t mersenne_prime_power;
+  size_t count;
+#ifdef WITH_METRICS
+  size_t collisions;
+  size_t overflow_buckets;
+#endif
+  struct bucket *bins;
+};
+
+struct hash_table *
+new_table(uint8_t mersenne_prime_power, unsigned int size);
+
+void
+delete_table(struct hash_table *table);
+
+struct bucket *
+get_bin_for_key(struct hash_table *table, unsigned int key);
+
+void
+insert_key(struct hash_table *table, unsigned int key);
+
+bool
+contains_key(struct hash_table *table, unsigned int key);
+
+void
+delete_key(struct hash_table *table, unsigned int key);
+
+#ifdef WITH_METRICS
+void
+print_metrics(struct hash_table *table);
+#endif
+
+#endif
@@ -0,0 +1,344 @@
+#include "concurrent_table.h"
+
+#include <sched.h>
+#include <string.h>
+
+#include "hash_table_helper.h"
+#include "table_alloc.h"
+
+static inline size_t
+bins_bytes(unsigned int size) {
+  return sizeof(struct concurrent_bins) + (size_t)size * sizeof(struct link *);
+}
+
+static struct concurrent_bins *
+new_bins(uint8_t mersenne_prime_power) {
+  unsigned int size = (unsigned int)((1ULL << mersenne_prime_power) - 1);
+  // Zeroed, so every bin starts out as an empty chain.
+  struct concurrent_bins *bins = table_alloc(bins_bytes(size));
+  if (!bins) return NULL;
+  bins->size = size;
+  bins->mersenne_prime_power = mersenne_prime_power;
+  return bins;
+}
+
+static void
+free_bins(struct concurrent_bins *bins) {
+  table_free(bins, bins_bytes(bins->size));
+}
+
+struct concurrent_table *
+new_concurrent_table(uint8_t mersenne_prime_power) {
+  struct concurrent_table *table = aligned_alloc(_Alignof(struct concurrent_table), sizeof *table);
+  struct concurrent_bins *bins = new_bins(mersenne_prime_power);
+  // Sadly malloc can fail.
+  if (!table || !bins) goto error;
+
+  memset(table, 0, sizeof *table);
+  table->bins = bins;
+  table->max_load_factor = DEFAULT_MAX_LOAD_FACTOR;
+  // Starts at 3 so there's no wrapping around below 0 when checking for e + 3.
+  table->epoch = 3;
+  for (size_t i = 0; i < CONCURRENT_STRIPES; ++i) pthread_mutex_init(&table->stripes[i].lock, NULL);
+  pthread_mutex_init(&table->lock, NULL);
+  return table;
+
+error:
+  free(table);
+  if (bins) free_bins(bins);
+  return NULL;
+}
+
+void
+delete_concurrent_table(struct concurrent_table *table) {
+  // The links all live in the slabs.
+  while (table->slabs) {
+    struct slab *next = table->slabs->next;
+    free(table->slabs);
+    table->slabs = next;
+  }
+  for (size_t i = 0; i < CONCURRENT_STRIPES; ++i) pthread_mutex_destroy(&table->stripes[i].lock);
+  pthread_mutex_destroy(&table->lock);
+  free_bins(table->bins);
+  free(table);
+}
+
+struct concurrent_thread *
+join_table(struct concurrent_table *table) {
+  struct concurrent_thread *thread = malloc(sizeof *thread);
+  if (!thread) return NULL;
+
+  pthread_mutex_lock(&table->lock);
+  size_t i = 0;
+  while (i < CONCURRENT_MAX_THREADS && table->joined[i]) i++;
+  if (i < CONCURRENT_MAX_THREADS) table->joined[i] = true;
+  pthread_mutex_unlock(&table->lock);
+
+  if (i == CONCURRENT_MAX_THREADS) {
+    free(thread);
+    return NULL;
+  }
+
+  *thread = (struct concurrent_thread){.table = table, .record = &table->records[i], .deletes = 0};
+  thread->epoch = __atomic_load_n(&table->epoch, __ATOMIC_ACQUIRE);
+  init_slab_allocator(&thread->allocator);
+  return thread;
+}
+
+void
+leave_table(struct concurrent_thread *thread) {
+  struct concurrent_table *table = thread->table;
+
+  // Deleted links still waiting for their epoch just don't get reused, they go away with the slabs.
+  for (size_t l = 0; l < LIMBO_LISTS; ++l) free(thread->limbo[l].links);
+
+  pthread_mutex_lock(&table->lock);
+  while (thread->allocator.slabs) {
+    struct slab *slab = thread->allocator.slabs;
+    thread->allocator.slabs = slab->next;
+    slab->next = table->slabs;
+    table->slabs = slab;
+  }
+  table->joined[thread->record - table->records] = false;
+  pthread_mutex_unlock(&table->lock);
+
+  free(thread);
+}
+
+/*
+ * Epochs.
+ */
+
+// Hands the links of a limbo list back to the allocator, nobody can see them any more.
+static void
+reuse_links(struct concurrent_thread *thread, struct limbo *limbo) {
+  for (size_t i = 0; i < limbo->count; ++i) {
+    limbo->links[i]->next = thread->allocator.free_links;
+    thread->allocator.free_links = limbo->links[i];
+  }
+  limbo->count = 0;
+}
+
+static void
+enter(struct concurrent_thread *thread) {
+  uint64_t epoch = __atomic_load_n(&thread->table->epoch, __ATOMIC_ACQUIRE);
+  for (;;) {
+    __atomic_store_n(&thread->record->state, (epoch << 1) | 1, __ATOMIC_RELAXED);
+    // Has to be visible before we read any bin, otherwise the epoch could move on under us.
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    // If we were preempted between reading the epoch and announcing it, it may have moved on a few times since, and
+    // announcing (and retiring links with) a stale epoch would let them be reused while readers are still on them.
+    // Once the epoch is the same after the fence, it can't move past epoch + 1 while we're in.
+    uint64_t now = __atomic_load_n(&thread->table->epoch, __ATOMIC_SEQ_CST);
+    if (now == epoch) break;
+    epoch = now;
+  }
+
+  if (epoch != thread->epoch) {
+    thread->epoch = epoch;
+    for (size_t l = 0; l < LIMBO_LISTS; ++l) {
+      if (thread->limbo[l].count && thread->limbo[l].epoch + 3 <= epoch) reuse_links(thread, &thread->limbo[l]);
+    }
+  }
+}
+
+static void
+leave(struct concurrent_thread *thread) {
+  __atomic_store_n(&thread->record->state, 0, __ATOMIC_RELEASE);
+}
+
+// Moves the global epoch on if every thread that's inside an operation is in the current one.
+static void
+try_advance(struct concurrent_table *table) {
+  uint64_t epoch = __atomic_load_n(&table->epoch, __ATOMIC_SEQ_CST);
+  for (size_t i = 0; i < CONCURRENT_MAX_THREADS; ++i) {
+    uint64_t state = __atomic_load_n(&table->records[i].state, __ATOMIC_SEQ_CST);
+    if ((state & 1) && (state >> 1) != epoch) return;
+  }
+  __atomic_compare_exchange_n(&table->epoch, &epoch, epoch + 1, false, __ATOMIC_SEQ_CST, __ATOMIC_RELAXED);
+}
+
+// Only called between enter and leave, so the thread's epoch is the one it announced.
+static void
+retire(struct concurrent_thread *thread, struct link *link) {
+  struct limbo *limbo = &thread->limbo[thread->epoch % LIMBO_LISTS];
+  // Whatever is in there is from LIMBO_LISTS epochs ago at least, so done waiting.
+  if (limbo->epoch != thread->epoch) {
+    reuse_links(thread, limbo);
+    limbo->epoch = thread->epoch;
+  }
+
+  if (limbo->count == limbo->capacity) {
+    size_t capacity = limbo->capacity ? 2 * limbo->capacity : 64;
+    struct link **links = realloc(limbo->links, capacity * sizeof *links);
+    // Can't keep track of it, so it never gets reused :shrug:
+    if (!links) return;
+    limbo->links = links;
+    limbo->capacity = capacity;
+  }
+  limbo->links[limbo->count++] = link;
+
+  if (++thread->deletes % DELETES_PER_ADVANCE == 0) try_advance(thread->table);
+}
+
+// Returns once every thread that was in an operation when this was called is out of it. Call it outside of one.
+static void
+wait_for_readers(struct concurrent_table *table) {
+  uint64_t target = __atomic_load_n(&table->epoch, __ATOMIC_SEQ_CST) + 2;
+  while (__atomic_load_n(&table->epoch, __ATOMIC_SEQ_CST) < target) {
+    try_advance(table);
+    sched_yield();
+  }
+}
+
+/*
+ * Growing.
+ */
+
+static void
+lock_all(struct concurrent_table *table) {
+  for (size_t i = 0; i < CONCURRENT_STRIPES; ++i) pthread_mutex_lock(&table->stripes[i].lock);
+}
+
+static void
+unlock_all(struct concurrent_table *table) {
+  for (size_t i = 0; i < CONCURRENT_STRIPES; ++i) pthread_mutex_unlock(&table->stripes[i].lock);
+}
+
+static void
+grow(struct concurrent_thread *thread, struct concurrent_bins *old) {
+  struct concurrent_table *table = thread->table;
+  if (old->mersenne_prime_power == MAX_MERSENNE_PRIME_POWER) return;
+
+  lock_all(table);
+  // Someone else got here first.
+  if (table->bins != old) {
+    unlock_all(table);
+    return;
+  }
+
+  struct concurrent_bins *bins = new_bins(old->mersenne_prime_power + 1);
+  // Not being able to grow isn't fatal, the chains just get longer.
+  if (!bins) goto unlock;
+
+  // Copies, the readers on the old chains need them as they are.
+  size_t counts[CONCURRENT_STRIPES] = {0};
+  for (unsigned int i = 0; i < old->size; ++i) {
+    for (struct link *link = old->bins[i]; link; link = link->next) {
+      uint64_t index = hash_bin_index(link->key, bins->mersenne_prime_power);
+      struct link *copy = slab_new_link(&thread->allocator, link->key, bins->bins[index]);
+      if (!copy) goto undo;
+      bins->bins[index] = copy;
+      counts[index % CONCURRENT_STRIPES]++;
+    }
+  }
+
+  for (size_t i = 0; i < CONCURRENT_STRIPES; ++i)
+    __atomic_store_n(&table->stripes[i].count, counts[i], __ATOMIC_RELAXED);
+  __atomic_store_n(&table->bins, bins, __ATOMIC_RELEASE);
+  unlock_all(table);
+
+  // Nobody can reach the old links any more once the readers are gone, and nobody but us would free them.
+  wait_for_readers(table);
+  for (unsigned int i = 0; i < old->size; ++i) {
+    while (old->bins[i]) slab_free_head(&thread->allocator, &old->bins[i]);
+  }
+  free_bins(old);
+  return;
+
+undo:
+  for (unsigned int i = 0; i < bins->size; ++i) {
+    while (bins->bins[i]) slab_free_head(&thread->allocator, &bins->bins[i]);
+  }
+  free_bins(bins);
+unlock:
+  unlock_all(table);
+}
+
+/*
+ * The operations.
+ */
+
+// Locks the stripe key belongs to in the current bins, returns those bins.
+static struct concurrent_bins *
+lock_stripe(struct concurrent_table *table, unsigned int key, struct stripe **stripe, struct link ***bin) {
+  for (;;) {
+    struct concurrent_bins *bins = __atomic_load_n(&table->bins, __ATOMIC_ACQUIRE);
+    uint64_t index = hash_bin_index(key, bins->mersenne_prime_power);
+    *stripe = &table->stripes[index % CONCURRENT_STRIPES];
+    pthread_mutex_lock(&(*stripe)->lock);
+    // A resize needs every lock, so if the bins are still the same now they stay that way until we unlock.
+    if (__atomic_load_n(&table->bins, __ATOMIC_RELAXED) == bins) {
+      *bin = &bins->bins[index];
+      return bins;
+    }
+    pthread_mutex_unlock(&(*stripe)->lock);
+  }
+}
+
+void
+concurrent_insert_key(struct concurrent_thread *thread, unsigned int key) {
+  if (key == DEFAULT_KEY) return;
+
+  struct concurrent_table *table = thread->table;
+  struct stripe *stripe;
+  LIST bin;
+
+  enter(thread);
+  struct concurrent_bins *bins = lock_stripe(table, key, &stripe, &bin);
+
+  bool grow_now = false;
+  // No duplicates. We hold the lock, nothing changes under us.
+  if (!contains_element(bin, key)) {
+    struct link *link = slab_new_link(&thread->allocator, key, *bin);
+    if (link) {
+      // Readers see the whole link or none of it.
+      __atomic_store_n(bin, link, __ATOMIC_RELEASE);
+      // Atomic only because concurrent_count reads it without the lock.
+      size_t count = __atomic_fetch_add(&stripe->count, 1, __ATOMIC_RELAXED) + 1;
+      grow_now = count > table->max_load_factor * bins->size / CONCURRENT_STRIPES;
+    }
+  }
+
+  pthread_mutex_unlock(&stripe->lock);
+  leave(thread);
+
+  if (grow_now) grow(thread, bins);
+}
+
+bool
+concurrent_contains_key(struct concurrent_thread *thread, unsigned int key) {
+  enter(thread);
+  struct concurrent_bins *bins = __atomic_load_n(&thread->table->bins, __ATOMIC_ACQUIRE);
+  struct link *link = __atomic_load_n(&bins->bins[hash_bin_index(key, bins->mersenne_prime_power)], __ATOMIC_ACQUIRE);
+  while (link && link->key != key) link = __atomic_load_n(&link->next, __ATOMIC_ACQUIRE);
+  leave(thread);
+  return link != NULL;
+}
+
+void
+concurrent_delete_key(struct concurrent_thread *thread, unsigned int key) {
+  struct stripe *stripe;
+  LIST bin;
+
+  enter(thread);
+  lock_stripe(thread->table, key, &stripe, &bin);
+
+  if ((bin = find_key(bin, key))) {
+    struct link *link = *bin;
+    // Readers already on the link can keep going, its ->next stays as it is until it's reused.
+    __atomic_store_n(bin, link->next, __ATOMIC_RELEASE);
+    __atomic_fetch_sub(&stripe->count, 1, __ATOMIC_RELAXED);
+    retire(thread, link);
+  }
+
+  pthread_mutex_unlock(&stripe->lock);
+  leave(thread);
+}
+
+size_t
+concurrent_count(struct concurrent_table *table) {
+  size_t count = 0;
+  for (size_t i = 0; i < CONCURRENT_STRIPES; ++i) count += __atomic_load_n(&table->stripes[i].count, __ATOMIC_RELAXED);
+  return count;
+}
@@ -0,0 +1,120 @@
+#ifndef CONCURRENT_TABLE_H
+#define CONCURRENT_TABLE_H
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+// Same links and slabs as the single threaded chaining table.
+#include "hash_table.h"
+
+/*
+ * Chaining that many threads can use at once.
+ *
+ * Writers lock a stripe: bin i belongs to stripe i % CONCURRENT_STRIPES, and every stripe's lock sits on its own cache
+ * line so two writers on different stripes never touch the same line. Lookups don't lock anything, they just walk the
+ * chain. Writers only ever change a chain by swinging one pointer (the bin or a ->next) with a release store, so a
+ * reader always sees a valid chain, just maybe not the latest one.
+ *
+ * The catch is a deleted link: a reader can still be standing on it, so it can't go back to the allocator straight
+ * away. That's what the epochs are for (epoch based reclamation). Every operation announces the global epoch it started
+ * in, and the epoch only moves on once every thread inside an operation has announced the current one. A link that gets
+ * unlinked while its thread is in epoch e is reused once the global epoch is at e + 3, by then every thread that could
+ * have seen it has finished.
+ *
+ * Growing works like the chaining table (past max_load_factor, to the next Mersenne power) but all at once: the thread
+ * that notices takes every stripe lock, copies the chains into new links in new bins, publishes the new bins and waits
+ * out the readers still on the old ones before reusing them. Each stripe counts its own keys, so nobody fights over a
+ * shared counter, and a stripe going over its share of the load factor is what triggers it.
+ *
+ * Every thread gets its own handle from join_table (and gives it back with leave_table), that's where its epoch, its
+ * links and its deleted links live. At most CONCURRENT_MAX_THREADS handles at a time. Key 0 can't be inserted, same
+ * as hash_table.c.
+ */
+
+#ifndef CONCURRENT_STRIPES
+#define CONCURRENT_STRIPES 1024
+#endif
+#define CONCURRENT_MAX_THREADS 128
+// Deleted links waiting for their epoch, one list per epoch mod this.
+#define LIMBO_LISTS 4
+// Deletes between a thread's attempts to move the epoch on.
+#define DELETES_PER_ADVANCE 64
+
+struct stripe {
+  _Alignas(64) pthread_mutex_t lock;
+  // Keys in this stripe's bins.
+  size_t count;
+};
+
+// One per handle. (epoch << 1) | 1 while the thread is inside an operation, 0 otherwise.
+struct epoch_record {
+  _Alignas(64) uint64_t state;
+};
+
+// Bins and their size in one allocation, so readers get both with one load.
+struct concurrent_bins {
+  unsigned int size;
+  uint8_t mersenne_prime_power;
+  struct link *bins[];
+};
+
+struct concurrent_table {
+  struct concurrent_bins *bins;
+  double max_load_factor;
+  _Alignas(64) uint64_t epoch;
+  struct stripe stripes[CONCURRENT_STRIPES];
+  struct epoch_record records[CONCURRENT_MAX_THREADS];
+  // Guards everything below.
+  pthread_mutex_t lock;
+  bool joined[CONCURRENT_MAX_THREADS];
+  // Slabs of the threads that left, their links are still in the table.
+  struct slab *slabs;
+};
+
+struct limbo {
+  uint64_t epoch;
+  struct link **links;
+  size_t count;
+  size_t capacity;
+};
+
+struct concurrent_thread {
+  struct concurrent_table *table;
+  struct epoch_record *record;
+  // The last global epoch this thread has seen.
+  uint64_t epoch;
+  struct slab_allocator allocator;
+  struct limbo limbo[LIMBO_LISTS];
+  size_t deletes;
+};
+
+struct concurrent_table *
+new_concurrent_table(uint8_t mersenne_prime_power);
+
+// Every thread has to have left by now.
+void
+delete_concurrent_table(struct concurrent_table *table);
+
+// NULL if CONCURRENT_MAX_THREADS threads have joined already, or malloc failed.
+struct concurrent_thread *
+join_table(struct concurrent_table *table);
+
+void
+leave_table(struct concurrent_thread *thread);
+
+void
+concurrent_insert_key(struct concurrent_thread *thread, unsigned int key);
+
+bool
+concurrent_contains_key(struct concurrent_thread *thread, unsigned int key);
+
+void
+concurrent_delete_key(struct concurrent_thread *thread, unsigned int key);
+
+// Sums up the stripes, only exact while no one's inserting or deleting.
+size_t
+concurrent_count(struct concurrent_table *table);
+
+#endif
@@ -0,0 +1,226 @@
+#include "cuckoo.h"
+
+#include <string.h>
+
+#include "hash_table_helper.h"
+
+#if defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+/*
+ * Returns a bitmask with bit i set if bucket->keys[i] == key. Pass DEFAULT_KEY to get the empty slots.
+ */
+static inline unsigned int
+bucket_match(const struct bucket *bucket, unsigned int key) {
+#if defined(__SSE2__)
+  __m128i eq = _mm_cmpeq_epi32(_mm_load_si128((const __m128i *)bucket), _mm_set1_epi32((int)key));
+  return (unsigned int)_mm_movemask_ps(_mm_castsi128_ps(eq));
+#else
+  unsigned int mask = 0;
+  for (int i = 0; i < SLOTS_PER_BUCKET; i++) {
+    mask |= (unsigned int)(bucket->keys[i] == key) << i;
+  }
+  return mask;
+#endif
+}
+
+static inline size_t
+first_bucket(const struct hash_table *table, unsigned int key) {
+  return hash_bin_index(key, table->bucket_power);
+}
+
+// The second choice has to be independent of the first, and hash_bin_index on its own only looks at key mod 2^s - 1.
+// Multiply-shift first (the high half of the product depends on every bit of the key), then the same Mersenne fold.
+static inline size_t
+second_bucket(const struct hash_table *table, unsigned int key) {
+  return hash_bin_index(((uint64_t)key * 0x9E3779B97F4A7C15ULL) >> 32, table->bucket_power);
+}
+
+static inline size_t
+other_bucket(const struct hash_table *table, unsigned int key, size_t bucket) {
+  size_t first = first_bucket(table, key);
+  return first == bucket ? second_bucket(table, key) : first;
+}
+
+static inline uint64_t
+next_random(struct hash_table *table) {
+  uint64_t x = table->rng;
+  x ^= x << 13;
+  x ^= x >> 7;
+  x ^= x << 17;
+  return table->rng = x;
+}
+
+static struct bucket *
+new_buckets(size_t size) {
+  // Cache line aligned, so with 4 buckets per line none of them straddles two. aligned_alloc wants a multiple of the
+  // alignment.
+  size_t bytes = (size * sizeof(struct bucket) + 63) & ~(size_t)63;
+  struct bucket *buckets = aligned_alloc(64, bytes);
+  // All zeroes, every slot is DEFAULT_KEY.
+  if (buckets) memset(buckets, 0, bytes);
+  return buckets;
+}
+
+// Takes the first empty slot in bucket, if there is one.
+static inline bool
+try_put(struct bucket *bucket, unsigned int key) {
+  unsigned int empty = bucket_match(bucket, DEFAULT_KEY);
+  if (!empty) return false;
+  bucket->keys[__builtin_ctz(empty)] = key;
+  return true;
+}
+
+/*
+ * Puts key (which isn't in the table) into one of its buckets, kicking other keys around if both are full. Returns
+ * false and leaves the table exactly as it was if that took more than MAX_KICKS.
+ */
+static bool
+place(struct hash_table *table, unsigned int key) {
+  size_t index = first_bucket(table, key);
+  if (try_put(&table->buckets[index], key)) return true;
+  size_t second = second_bucket(table, key);
+  if (try_put(&table->buckets[second], key)) return true;
+
+  // Both full. Remember where every kick happened so a walk that goes nowhere can be undone.
+  struct {
+    size_t bucket;
+    unsigned int slot;
+  } path[MAX_KICKS];
+  if (next_random(table) & 1) index = second;
+
+  unsigned int carry = key;
+  for (int kicks = 0; kicks < MAX_KICKS; kicks++) {
+    unsigned int slot = (unsigned int)(next_random(table) >> 32) % SLOTS_PER_BUCKET;
+    unsigned int *victim = &table->buckets[index].keys[slot];
+    unsigned int kicked = *victim;
+    *victim = carry;
+    carry = kicked;
+    path[kicks].bucket = index;
+    path[kicks].slot = slot;
+#ifdef WITH_METRICS
+    table->collisions++;
+#endif
+
+    index = other_bucket(table, carry, index);
+    if (try_put(&table->buckets[index], carry)) return true;
+  }
+
+  // Walk it back, every kicked key goes back where it was and we end up carrying key again.
+  for (int kicks = MAX_KICKS - 1; kicks >= 0; kicks--) {
+    unsigned int *victim = &table->buckets[path[kicks].bucket].keys[path[kicks].slot];
+    unsigned int kicked = *victim;
+    *victim = carry;
+    carry = kicked;
+  }
+  return false;
+}
+
+// Moves everything into 2^bucket_power - 1 buckets, going bigger still if the keys don't fit.
+static bool
+rehash(struct hash_table *table, uint8_t bucket_power) {
+  for (; bucket_power <= MAX_BUCKET_POWER; bucket_power++) {
+    struct hash_table bigger = *table;
+    bigger.bucket_power = bucket_power;
+    bigger.size = (1ULL << bucket_power) - 1;
+    bigger.buckets = new_buckets(bigger.size);
+    if (!bigger.buckets) return false;
+
+    bool fits = true;
+    for (size_t i = 0; fits && i < table->size; i++) {
+      for (int j = 0; fits && j < SLOTS_PER_BUCKET; j++) {
+        unsigned int key = table->buckets[i].keys[j];
+        if (key != DEFAULT_KEY) fits = place(&bigger, key);
+      }
+    }
+
+    if (fits) {
+      free(table->buckets);
+#ifdef WITH_METRICS
+      bigger.rehashes++;
+#endif
+      *table = bigger;
+      return true;
+    }
+    free(bigger.buckets);
+  }
+  return false;
+}
+
+struct hash_table *
+empty_table(uint8_t mersenne_prime_power) {
+  struct hash_table *table = (struct hash_table *)malloc(sizeof *table);
+  // 4 slots per bucket, so 4x fewer buckets than bins.
+  uint8_t bucket_power = mersenne_prime_power > 3 ? mersenne_prime_power - 2 : 1;
+  size_t size = (1ULL << bucket_power) - 1;
+  struct bucket *buckets = new_buckets(size);
+
+  // Sadly malloc can fail.
+  if (!table || !buckets) goto error;
+
+  *table = (struct hash_table){
+      .buckets = buckets, .size = size, .bucket_power = bucket_power, .count = 0, .rng = 0x9E3779B97F4A7C15ULL};
+
+  return table;
+
+error:
+  free(table);
+  free(buckets);
+  return NULL;
+}
+
+void
+delete_table(struct hash_table *table) {
+  free(table->buckets);
+  free(table);
+}
+
+void
+insert_key(struct hash_table *table, unsigned int key) {
+  if (key == DEFAULT_KEY || contains_key(table, key)) return;
+
+  while (!place(table, key)) {
+    // Out of luck at this size (or malloc failed and it stays out).
+    if (table->bucket_power == MAX_BUCKET_POWER || !rehash(table, table->bucket_power + 1)) return;
+  }
+  table->count++;
+}
+
+bool
+contains_key(struct hash_table *table, unsigned int key) {
+  if (key == DEFAULT_KEY) return false;
+  // Both buckets are known up front, so the two loads don't wait on each other.
+  const struct bucket *first = &table->buckets[first_bucket(table, key)];
+  const struct bucket *second = &table->buckets[second_bucket(table, key)];
+  return (bucket_match(first, key) | bucket_match(second, key)) != 0;
+}
+
+void
+delete_key(struct hash_table *table, unsigned int key) {
+  if (key == DEFAULT_KEY) return;
+
+  struct bucket *buckets[2] = {&table->buckets[first_bucket(table, key)], &table->buckets[second_bucket(table, key)]};
+  for (int i = 0; i < 2; i++) {
+    unsigned int match = bucket_match(buckets[i], key);
+    if (match) {
+      buckets[i]->keys[__builtin_ctz(match)] = DEFAULT_KEY;
+      table->count--;
+      return;
+    }
+  }
+}
+
+#ifdef WITH_METRICS
+#include <stdio.h>
+void
+print_metrics(struct hash_table *table) {
+  size_t slots = table->size * SLOTS_PER_BUCKET;
+  printf("Total stats:\n");
+  printf("       Count: %zu\n", table->count);
+  printf("       Slots: %zu (%zu buckets, 2^%u - 1)\n", slots, table->size, table->bucket_power);
+  printf(" Load factor: %.3f\n", (double)table->count / slots);
+  printf("       Kicks: %zu\n", table->collisions);
+  printf("    Rehashes: %zu\n", table->rehashes);
+}
+#endif
@@ -0,0 +1,68 @@
+#ifndef CUCKOO_H
+#define CUCKOO_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+/*
+ * Bucketized cuckoo hashing, 2 choices, 4 ways.
+ *
+ * Every key has exactly two buckets it can be in: hash_bin_index(key) and hash_bin_index of a multiply-shift hash of
+ * it. A bucket is 4 keys (16 bytes, buckets never straddle a cache line) so a lookup is at most two cache lines, no
+ * matter how full the table is. No probe sequences, no tombstones, deleting just clears the slot.
+ *
+ * Inserting into two full buckets kicks a random key out of one of them into its *other* bucket, which might kick out
+ * another key, and so on (a random walk). With 2 choices and 4 ways that finds room until the table is ~98% full, so
+ * running at 0.95 is fine. If the walk goes on for MAX_KICKS it gets undone and the table grows to the next Mersenne
+ * power, nothing is ever lost halfway.
+ *
+ * empty_table(s) gives 2^(s-2) - 1 buckets, i.e. about as many slots as open_addressing.c's 2^s - 1 bins.
+ *
+ * Empty slots hold DEFAULT_KEY, same as hash_table.h, so 0 can't be inserted.
+ */
+
+#define DEFAULT_KEY (unsigned int)0
+#define SLOTS_PER_BUCKET 4
+#define MAX_KICKS 500
+#define MAX_BUCKET_POWER 30
+
+struct bucket {
+  _Alignas(16) unsigned int keys[SLOTS_PER_BUCKET];
+};
+
+_Static_assert(64 % sizeof(struct bucket) == 0, "buckets shouldn't straddle cache lines");
+
+struct hash_table {
+  struct bucket *buckets;
+  // Number of buckets, 2^bucket_power - 1.
+  size_t size;
+  uint8_t bucket_power;
+  size_t count;
+  // For picking which key to kick out.
+  uint64_t rng;
+#ifdef WITH_METRICS
+  // Keys kicked out of their bucket.
+  size_t collisions;
+  size_t rehashes;
+#endif
+};
+
+struct hash_table *
+empty_table(uint8_t mersenne_prime_power);
+void
+delete_table(struct hash_table *table);
+
+void
+insert_key(struct hash_table *table, unsigned int key);
+bool
+contains_key(struct hash_table *table, unsigned int key);
+void
+delete_key(struct hash_table *table, unsigned int key);
+
+#ifdef WITH_METRICS
+void
+print_metrics(struct hash_table *table);
+#endif
+
+#endif
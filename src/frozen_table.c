@@ -0,0 +1,195 @@
+#include "frozen_table.h"
+
+#include <limits.h>
+#include <string.h>
+#include <sys/mman.h>
+#include "hash_table_helper.h"
+#include "table_alloc.h"
+
+static inline size_t
+frozen_bytes(uint64_t size, uint64_t count) {
+  return (size + 1 + count) * sizeof(uint32_t);
+}
+
+static inline uint64_t
+frozen_bin(const struct frozen_table *table, unsigned int key) {
+  return reduce_index(hash_key(&table->hasher, key), table->index_mode, table->mersenne_prime_power, table->size);
+}
+
+struct frozen_table *
+freeze_table(const struct hash_table *table) {
+  struct frozen_table *frozen = malloc(sizeof *frozen);
+  uint32_t *offsets = table_alloc(frozen_bytes(table->size, table->count));
+  // Sadly malloc can fail.
+  if (!frozen || !offsets) goto error;
+
+  *frozen = (struct frozen_table){
+      .size = table->size,
+      .mersenne_prime_power = table->mersenne_prime_power,
+      .index_mode = table->index_mode,
+      .count = table->count,
+      .offsets = offsets,
+      .keys = offsets + table->size + 1,
+      .mapping = NULL,
+      .mapping_length = 0,
+      .hasher = table->hasher,
+  };
+
+  /*
+   * A counting sort by bin, in place: count every bin's keys into offsets[bin], turn the counts into where each bin
+   * ends, then put every key at --offsets[bin]. Once they're all in, offsets[bin] is back at where the bin starts.
+   *
+   * Keys in the new bins are already in the bin they'll be in, only the old bins left to migrate need hashing.
+   */
+  for (unsigned int i = 0; i < table->size; ++i)
+    for (struct link *link = table->bins[i]; link; link = link->next) offsets[i]++;
+  if (table->old_bins)
+    for (unsigned int i = table->migrated; i < table->old_size; ++i)
+      for (struct link *link = table->old_bins[i]; link; link = link->next) offsets[frozen_bin(frozen, link->key)]++;
+
+  uint32_t end = 0;
+  for (unsigned int i = 0; i < table->size; ++i) offsets[i] = end += offsets[i];
+  offsets[table->size] = end;
+
+  for (unsigned int i = 0; i < table->size; ++i)
+    for (struct link *link = table->bins[i]; link; link = link->next) frozen->keys[--offsets[i]] = link->key;
+  if (table->old_bins)
+    for (unsigned int i = table->migrated; i < table->old_size; ++i)
+      for (struct link *link = table->old_bins[i]; link; link = link->next)
+        frozen->keys[--offsets[frozen_bin(frozen, link->key)]] = link->key;
+  return frozen;
+
+error:
+  free(frozen);
+  table_free(offsets, frozen_bytes(table->size, table->count));
+  return NULL;
+}
+
+void
+delete_frozen_table(struct frozen_table *table) {
+  if (table->mapping)
+    munmap(table->mapping, table->mapping_length);
+  else
+    table_free(table->offsets, frozen_bytes(table->size, table->count));
+  free(table);
+}
+
+bool
+frozen_contains_key(const struct frozen_table *table, unsigned int key) {
+  uint64_t bin = frozen_bin(table, key);
+  for (uint32_t i = table->offsets[bin], end = table->offsets[bin + 1]; i < end; ++i)
+    if (table->keys[i] == key) return true;
+  return false;
+}
+
+/*
+ * Three stages per key, each PREFETCH_DISTANCE keys behind the one before: work out the bin and prefetch its offsets,
+ * then read the offsets (in cache by now) and prefetch the bin's keys, then scan them. A bin's keys are a handful of
+ * neighbours, one cache line most of the time, so unlike the chains there's nothing left to wait for after that.
+ */
+void
+frozen_contains_keys(const struct frozen_table *table, const unsigned int *keys, size_t n, uint64_t *out_bitmap) {
+  memset(out_bitmap, 0, (n + 63) / 64 * sizeof *out_bitmap);
+
+  uint64_t bins[2 * PREFETCH_DISTANCE];
+  for (size_t i = 0; i < n + 2 * PREFETCH_DISTANCE; ++i) {
+    // Oldest first, the newest one reuses its slot in bins.
+    if (i >= 2 * PREFETCH_DISTANCE) {
+      size_t j = i - 2 * PREFETCH_DISTANCE;
+      uint64_t bin = bins[j % (2 * PREFETCH_DISTANCE)];
+      for (uint32_t k = table->offsets[bin], end = table->offsets[bin + 1]; k < end; ++k) {
+        if (table->keys[k] == keys[j]) {
+          out_bitmap[j / 64] |= 1ULL << (j % 64);
+          break;
+        }
+      }
+    }
+    if (i >= PREFETCH_DISTANCE && i - PREFETCH_DISTANCE < n)
+      __builtin_prefetch(table->keys + table->offsets[bins[(i - PREFETCH_DISTANCE) % (2 * PREFETCH_DISTANCE)]]);
+    if (i < n) {
+      uint64_t bin = frozen_bin(table, keys[i]);
+      bins[i % (2 * PREFETCH_DISTANCE)] = bin;
+      __builtin_prefetch(table->offsets + bin);
+    }
+  }
+}
+
+/*
+ * Snapshots, see frozen_table.h.
+ */
+bool
+save_frozen_table(const struct frozen_table *table, const char *path) {
+  size_t length = frozen_bytes(table->size, table->count);
+  struct frozen_snapshot_header header = {
+      .magic = FROZEN_SNAPSHOT_MAGIC,
+      .version = FROZEN_SNAPSHOT_VERSION,
+      .mersenne_prime_power = table->mersenne_prime_power,
+      .index_mode = table->index_mode,
+      .hash_function = table->hasher.function,
+      .reserved = 0,
+      .seed = table->hasher.seed,
+      .size = table->size,
+      .count = table->count,
+      .checksum = snapshot_checksum(table->offsets, length),
+  };
+  return write_snapshot(path, &header, sizeof header, table->offsets, length);
+}
+
+static bool
+frozen_header_ok(const struct frozen_snapshot_header *header, size_t length) {
+  if (header->magic != FROZEN_SNAPSHOT_MAGIC || header->version != FROZEN_SNAPSHOT_VERSION) return false;
+  if (header->index_mode > INDEX_FASTRANGE || header->hash_function > HASH_TABULATION ||
+      header->mersenne_prime_power > MAX_MERSENNE_PRIME_POWER)
+    return false;
+  // Fastrange tables have whatever size they were made with, the others exactly what their power says.
+  uint64_t size = header->size;
+  if (!size || size > UINT_MAX || size > (1ULL << header->mersenne_prime_power) ||
+      (header->index_mode != INDEX_FASTRANGE && size != index_bins(header->index_mode, header->mersenne_prime_power)))
+    return false;
+  if (header->count > UINT32_MAX) return false;
+  if (length != SNAPSHOT_HEADER_SIZE + frozen_bytes(size, header->count)) return false;
+  // The first and last offset, two pages at most. That catches offsets that don't go with these keys at all. One in the
+  // middle going wrong can still send a lookup past the keys, and finding it means reading every offset, which is what
+  // verify_frozen_snapshot is for.
+  const uint32_t *offsets = (const uint32_t *)((const char *)header + SNAPSHOT_HEADER_SIZE);
+  return offsets[0] == 0 && offsets[size] == header->count;
+}
+
+struct frozen_table *
+map_frozen_table(const char *path) {
+  size_t length;
+  void *mapping = map_snapshot(path, false, &length);
+  if (!mapping) return NULL;
+
+  const struct frozen_snapshot_header *header = mapping;
+  struct frozen_table *table = NULL;
+  if (!frozen_header_ok(header, length)) goto error;
+  table = malloc(sizeof *table);
+  // Sadly malloc can fail.
+  if (!table) goto error;
+
+  uint32_t *offsets = (uint32_t *)((char *)mapping + SNAPSHOT_HEADER_SIZE);
+  *table = (struct frozen_table){
+      .size = header->size,
+      .mersenne_prime_power = header->mersenne_prime_power,
+      .index_mode = (enum index_mode)header->index_mode,
+      .count = header->count,
+      .offsets = offsets,
+      .keys = offsets + header->size + 1,
+      .mapping = mapping,
+      .mapping_length = length,
+  };
+  init_hasher(&table->hasher, (enum hash_function)header->hash_function, header->seed);
+  return table;
+
+error:
+  munmap(mapping, length);
+  return NULL;
+}
+
+bool
+verify_frozen_snapshot(const struct frozen_table *table) {
+  if (!table->mapping) return false;
+  const struct frozen_snapshot_header *header = table->mapping;
+  return snapshot_checksum(table->offsets, frozen_bytes(table->size, table->count)) == header->checksum;
+}
@@ -0,0 +1,93 @@
+#ifndef FROZEN_TABLE_H
+#define FROZEN_TABLE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "hash_table.h"
+#include "hash_table_helper.h"
+#include "snapshot.h"
+
+/*
+ * A chaining table that's done changing, frozen into two flat arrays (CSR, compressed sparse row, like sparse matrices
+ * are stored):
+ *
+ *   offsets  size + 1 of them, one per bin and one past the end.
+ *   keys     count of them, sorted by bin. Bin i's keys are keys[offsets[i]] up to (not including) keys[offsets[i + 1]].
+ *
+ * A lookup reads two neighbouring offsets and scans a few neighbouring keys, instead of a bin pointer and then a link
+ * per key wherever malloc (or the slab) put it. That's 4 bytes per bin and 4 bytes per key, against 8 per bin and 16
+ * per key for the chains.
+ *
+ * Same bins, hash function and index reduction as the table it came from. Nothing can be inserted or deleted, freeze
+ * the table again for that.
+ */
+struct frozen_table {
+  unsigned int size;
+  uint8_t mersenne_prime_power;
+  enum index_mode index_mode;
+  size_t count;
+  // keys comes right after offsets, in the same allocation (or mapping), so the two go to a file in one write.
+  uint32_t *offsets;
+  unsigned int *keys;
+  // Only set for a table from map_frozen_table, the whole file. offsets and keys are in there, read only.
+  void *mapping;
+  size_t mapping_length;
+  // Last, the tabulation tables are 4 KB and would push everything else apart.
+  struct hasher hasher;
+};
+
+// A frozen copy of table, which isn't changed (a resize going on is fine, both sets of bins get copied). NULL if
+// there wasn't enough memory.
+struct frozen_table *
+freeze_table(const struct hash_table *table);
+
+void
+delete_frozen_table(struct frozen_table *table);
+
+bool
+frozen_contains_key(const struct frozen_table *table, unsigned int key);
+
+// Same as contains_keys in hash_table.h: bit i of out_bitmap for keys[i]. Offsets are prefetched 2 * PREFETCH_DISTANCE
+// keys ahead and keys PREFETCH_DISTANCE ahead.
+void
+frozen_contains_keys(const struct frozen_table *table, const unsigned int *keys, size_t n, uint64_t *out_bitmap);
+
+/*
+ * Snapshots, the same idea as for open addressing (see snapshot.h): a header, then offsets and keys as they are in
+ * memory, so map_frozen_table just points the table at them.
+ */
+// "CSRSNAPS" on a little endian machine.
+#define FROZEN_SNAPSHOT_MAGIC 0x5350414e53525343ULL
+#define FROZEN_SNAPSHOT_VERSION 1
+
+struct frozen_snapshot_header {
+  uint64_t magic;
+  uint32_t version;
+  uint8_t mersenne_prime_power;
+  uint8_t index_mode;
+  uint8_t hash_function;
+  uint8_t reserved;
+  uint64_t seed;
+  uint64_t size;
+  uint64_t count;
+  // snapshot_checksum of offsets and keys.
+  uint64_t checksum;
+};
+
+// False if anything went wrong, errno says what.
+bool
+save_frozen_table(const struct frozen_table *table, const char *path);
+
+// A frozen table mapped straight from the snapshot at path, delete_frozen_table unmaps it. NULL if the file isn't a
+// frozen snapshot this build can read, is cut short, or its offsets don't end at count. The checksum isn't checked,
+// verify_frozen_snapshot does that.
+struct frozen_table *
+map_frozen_table(const char *path);
+
+// True if table's offsets and keys still add up to the checksum in the snapshot it was mapped from.
+bool
+verify_frozen_snapshot(const struct frozen_table *table);
+
+#endif
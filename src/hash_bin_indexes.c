@@ -0,0 +1,94 @@
+#include "hash_bin_indexes.h"
+
+#include "hash_table_helper.h"
+
+/*
+ * Same fold as hash_bin_index, y = (y >> s) + (y & p) until y <= p, just on a vector of keys. A fold never makes y
+ * bigger (and leaves it alone once it's <= p), so we keep folding every lane until none is above p. For s >= 16 that's
+ * at most two folds. 32 bit lanes are enough, y only ever goes down from the key.
+ */
+
+static void
+hash_bin_indexes_scalar(const uint32_t *keys, uint32_t *indexes, size_t n, uint8_t s) {
+  for (size_t i = 0; i < n; i++) indexes[i] = (uint32_t)hash_bin_index(keys[i], s);
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+
+__attribute__((target("avx2"))) static void
+hash_bin_indexes_avx2(const uint32_t *keys, uint32_t *indexes, size_t n, uint8_t s) {
+  const uint32_t p = (uint32_t)((1ULL << s) - 1);
+  const __m256i mask = _mm256_set1_epi32((int)p);
+  const __m128i shift = _mm_cvtsi32_si128(s);
+  // No unsigned compare in AVX2, flipping the sign bit on both sides turns it into a signed one.
+  const __m256i sign = _mm256_set1_epi32(INT32_MIN);
+  const __m256i biased_mask = _mm256_xor_si256(mask, sign);
+
+  size_t i = 0;
+  for (; i + 8 <= n; i += 8) {
+    __m256i y = _mm256_loadu_si256((const __m256i *)(keys + i));
+    for (;;) {
+      y = _mm256_add_epi32(_mm256_srl_epi32(y, shift), _mm256_and_si256(y, mask));
+      __m256i above = _mm256_cmpgt_epi32(_mm256_xor_si256(y, sign), biased_mask);
+      if (_mm256_testz_si256(above, above)) break;
+    }
+    // y == p is bin 0.
+    y = _mm256_andnot_si256(_mm256_cmpeq_epi32(y, mask), y);
+    _mm256_storeu_si256((__m256i *)(indexes + i), y);
+  }
+  hash_bin_indexes_scalar(keys + i, indexes + i, n - i, s);
+}
+
+__attribute__((target("avx512f"))) static void
+hash_bin_indexes_avx512(const uint32_t *keys, uint32_t *indexes, size_t n, uint8_t s) {
+  const uint32_t p = (uint32_t)((1ULL << s) - 1);
+  const __m512i mask = _mm512_set1_epi32((int)p);
+  const __m128i shift = _mm_cvtsi32_si128(s);
+
+  size_t i = 0;
+  for (; i + 16 <= n; i += 16) {
+    __m512i y = _mm512_loadu_si512(keys + i);
+    do {
+      y = _mm512_add_epi32(_mm512_srl_epi32(y, shift), _mm512_and_si512(y, mask));
+    } while (_mm512_cmpgt_epu32_mask(y, mask));
+    // y == p is bin 0, zero those lanes.
+    y = _mm512_maskz_mov_epi32(_mm512_cmpneq_epu32_mask(y, mask), y);
+    _mm512_storeu_si512(indexes + i, y);
+  }
+  hash_bin_indexes_scalar(keys + i, indexes + i, n - i, s);
+}
+#endif
+
+typedef void (*hash_bin_indexes_fn)(const uint32_t *, uint32_t *, size_t, uint8_t);
+
+static hash_bin_indexes_fn kernel;
+static const char *kernel_name;
+
+// Before main, so every thread sees the same kernel from the start and nobody has to check whether it's picked yet.
+// __builtin_cpu_init is needed since this might run before libgcc's own constructor.
+__attribute__((constructor)) static void
+pick_kernel(void) {
+  kernel = hash_bin_indexes_scalar;
+  kernel_name = "Scalar";
+#if defined(__x86_64__) || defined(__i386__)
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx512f")) {
+    kernel = hash_bin_indexes_avx512;
+    kernel_name = "AVX-512";
+  } else if (__builtin_cpu_supports("avx2")) {
+    kernel = hash_bin_indexes_avx2;
+    kernel_name = "AVX2";
+  }
+#endif
+}
+
+void
+hash_bin_indexes(const uint32_t *keys, uint32_t *indexes, size_t n, uint8_t s) {
+  kernel(keys, indexes, n, s);
+}
+
+const char *
+hash_bin_indexes_kernel(void) {
+  return kernel_name;
+}
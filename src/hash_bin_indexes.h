@@ -0,0 +1,20 @@
+#ifndef HASH_BIN_INDEXES_H
+#define HASH_BIN_INDEXES_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * hash_bin_index for a whole array of 32 bit keys at once: indexes[i] = hash_bin_index(keys[i], s), bit for bit, for
+ * 1 <= s <= 32. With AVX-512 that's 16 keys per instruction, with AVX2 8, otherwise it's the scalar loop. Which one
+ * gets used is decided once, when the program starts, by asking the CPU (so the binary doesn't need -march=native to
+ * get them). keys and indexes may be the same array.
+ */
+void
+hash_bin_indexes(const uint32_t *keys, uint32_t *indexes, size_t n, uint8_t s);
+
+// "AVX-512", "AVX2" or "Scalar", whatever hash_bin_indexes ends up using on this machine.
+const char *
+hash_bin_indexes_kernel(void);
+
+#endif
@@ -1,58 +1,145 @@
 #include "hash_table.h"
 
 #include <assert.h>
+#include <limits.h>
 #include <stdbool.h>
 #include <stdlib.h>
+#include <string.h>
 #include "hash_table_helper.h"
+#include "table_alloc.h"
 
 struct hash_table *
 new_table(uint8_t mersenne_prime_power, unsigned int size) {
-  struct hash_table *table = (struct hash_table *)malloc(sizeof *table);
-  if (!table) goto error;
+  return new_table_with_index(mersenne_prime_power, size, INDEX_MERSENNE);
+}
 
-  table->bins = malloc(size * sizeof *table->bins);
-  table->size = size;
-  table->mersenne_prime_power = mersenne_prime_power;
+struct hash_table *
+new_table_with_index(uint8_t mersenne_prime_power, unsigned int size, enum index_mode index_mode) {
+  struct hash_table *table = (struct hash_table *)malloc(sizeof *table);
+  // An empty bin is a NULL chain, all zero bytes, so the bins come zeroed from table_alloc and need no init loop.
+  LIST bins = table_alloc((size_t)size * sizeof *bins);
 
   // Sadly malloc can fail.
-  if (!table->bins) goto error;
+  if (!table || !bins) goto error;
 
-  for (LIST bin = table->bins; bin < table->bins + table->size; bin++) {
-      *bin = NULL;
-  }
+  table->bins = bins;
+  table->size = size;
+  table->mersenne_prime_power = mersenne_prime_power;
+  table->index_mode = index_mode;
+  table->count = 0;
+  table->max_load_factor = DEFAULT_MAX_LOAD_FACTOR;
+  init_hasher(&table->hasher, HASH_IDENTITY, 0);
+  table->old_bins = NULL;
+  table->old_size = 0;
+  table->old_mersenne_prime_power = 0;
+  table->migrated = 0;
+  init_slab_allocator(&table->allocator);
 
 #ifdef WITH_METRICS
   table->collisions = 0;
-  table->count = 0;
 #endif
 
   return table;
 
 error:
-for (LIST bin = table->bins; bin < table->bins + table->size; bin++) {
-    free_list(bin);
-}
   free(table);
+  table_free(bins, (size_t)size * sizeof *bins);
   return NULL;
 }
 
 void
 delete_table(struct hash_table *table) {
-  free(table->bins);
+  // All the links live in the slabs, so there's no need to walk the bins.
+  free_slabs(&table->allocator);
+  table_free(table->old_bins, (size_t)table->old_size * sizeof *table->old_bins);
+  table_free(table->bins, (size_t)table->size * sizeof *table->bins);
   free(table);
 }
 
+// Moves up to n old bins over to the new ones, and drops the old bins once they're all moved.
+static void
+migrate_bins(struct hash_table *table, unsigned int n) {
+  if (!table->old_bins) return;
+
+  for (; n && table->migrated < table->old_size; n--, table->migrated++) {
+    LIST old_bin = table->old_bins + table->migrated;
+    while (*old_bin) {
+      struct link *link = *old_bin;
+      *old_bin = link->next;
+
+      LIST bin = table->bins + reduce_index(hash_key(&table->hasher, link->key), table->index_mode,
+                                            table->mersenne_prime_power, table->size);
+      link->next = *bin;
+      *bin = link;
+    }
+  }
+
+  if (table->migrated == table->old_size) {
+    table_free(table->old_bins, (size_t)table->old_size * sizeof *table->old_bins);
+    table->old_bins = NULL;
+  }
+}
+
+static void
+start_resize(struct hash_table *table) {
+  // Only one resize at a time. With a sane load factor the previous one is long done by now, otherwise finish it.
+  migrate_bins(table, UINT_MAX);
+
+  uint8_t power = table->mersenne_prime_power + 1;
+  // Twice as many bins for fastrange, whatever the size was.
+  uint64_t next_size =
+      table->index_mode == INDEX_FASTRANGE ? 2ULL * table->size : index_bins(table->index_mode, power);
+  // 2^32 power of two bins don't fit in an unsigned int, stay where we are.
+  if (next_size > UINT_MAX) return;
+  unsigned int size = (unsigned int)next_size;
+  // Zeroed without touching every new bin up front, see table_alloc.h.
+  LIST bins = table_alloc((size_t)size * sizeof *bins);
+  // Not being able to grow isn't fatal, the chains just get longer.
+  if (!bins) return;
+
+  table->old_bins = table->bins;
+  table->old_size = table->size;
+  table->old_mersenne_prime_power = table->mersenne_prime_power;
+  table->migrated = 0;
+
+  table->bins = bins;
+  table->size = size;
+  table->mersenne_prime_power = power;
+}
+
+
+bool
+set_hash_function(struct hash_table *table, enum hash_function function, uint64_t seed) {
+  // Every key would have to move.
+  if (table->count || table->old_bins) return false;
+  init_hasher(&table->hasher, function, seed);
+  return true;
+}
+
+// Same hash for the old and the new bins, only the reduction differs.
+static inline LIST
+get_bin_for_hash(struct hash_table *table, uint64_t hash) {
+  if (table->old_bins) {
+    uint64_t index = reduce_index(hash, table->index_mode, table->old_mersenne_prime_power, table->old_size);
+    if (index >= table->migrated) return table->old_bins + index;
+  }
+  return (table->bins) + reduce_index(hash, table->index_mode, table->mersenne_prime_power, table->size);
+}
+
 LIST
 get_bin_for_key(struct hash_table *table, unsigned int key) {
-  return (table->bins) + hash_bin_index(key, table->mersenne_prime_power);
+  return get_bin_for_hash(table, hash_key(&table->hasher, key));
 }
 
-void
-insert_key(struct hash_table *table, unsigned int key) {
+// insert_key and delete_key with the hash already worked out, for the batches further down.
+static inline void
+insert_hashed(struct hash_table *table, unsigned int key, uint64_t hash) {
     // TODO: Think of something better to do here.
     if (key == DEFAULT_KEY) return;
 
-  LIST bin = get_bin_for_key(table, key);
+  migrate_bins(table, MIGRATE_BINS_PER_OP);
+
+  LIST bin = get_bin_for_hash(table, hash);
 
   // No duplicates
   if (!contains_element(bin, key)) {
@@ -60,12 +147,22 @@ insert_key(struct hash_table *table, unsigned int key) {
       if (*bin) {
           table->collisions++;
       }
-      table->count++;
 #endif
-      add_element(bin, key);
+      slab_add_element(&table->allocator, bin, key);
+      table->count++;
+
+      if (table->count > table->max_load_factor * table->size &&
+          table->mersenne_prime_power < MAX_MERSENNE_PRIME_POWER) {
+          start_resize(table);
+      }
   }
 }
 
+void
+insert_key(struct hash_table *table, unsigned int key) {
+  insert_hashed(table, key, hash_key(&table->hasher, key));
+}
+
 bool
 contains_key(struct hash_table *table, unsigned int key) {
   // Well we don't need to check for default key cause we don't let people insert it.
@@ -73,13 +170,122 @@ contains_key(struct hash_table *table, unsigned int key) {
   return contains_element(get_bin_for_key(table, key), key);
 }
 
+static inline void
+delete_hashed(struct hash_table *table, unsigned int key, uint64_t hash) {
+    migrate_bins(table, MIGRATE_BINS_PER_OP);
+
+    // slab_delete_element already searches the bin, no need to walk it twice.
+    if (slab_delete_element(&table->allocator, get_bin_for_hash(table, hash), key)) {
+        table->count--;
+    }
+}
+
 void
 delete_key(struct hash_table *table, unsigned int key) {
-    LIST bin = get_bin_for_key(table, key);
+  delete_hashed(table, key, hash_key(&table->hasher, key));
+}
+
+/*
+ * Batches.
+ *
+ * Inserts and deletes hash the key PREFETCH_DISTANCE keys ahead and prefetch its bin, so the bin misses overlap. The
+ * chain behind the bin is still walked one miss at a time, but at the usual load factor that's a link or two.
+ *
+ * Lookups don't change the table, so those go further (AMAC, asynchronous memory access chaining): LOOKUPS_IN_FLIGHT
+ * lookups are walked at the same time, round robin, one step each. A step only touches memory that was prefetched
+ * the last time round (the bin, then every link), and prefetches whatever it needs next before moving on to the next
+ * lookup. A lookup that's done makes room for the next key. So chain walks overlap too, not just the bins.
+ */
+static inline uint64_t
+prefetch_bin(struct hash_table *table, unsigned int key) {
+  uint64_t hash = hash_key(&table->hasher, key);
+  __builtin_prefetch(get_bin_for_hash(table, hash), 1);
+  return hash;
+}
+
+#define FOR_EACH_PREFETCHED(table, keys, n, op)                                                                        \
+  do {                                                                                                                 \
+    uint64_t hashes[PREFETCH_DISTANCE];                                                                                \
+    for (size_t i = 0; i < (n) && i < PREFETCH_DISTANCE; ++i) hashes[i] = prefetch_bin(table, (keys)[i]);              \
+    for (size_t i = 0; i < (n); ++i) {                                                                                 \
+      uint64_t hash = hashes[i % PREFETCH_DISTANCE];                                                                   \
+      if (i + PREFETCH_DISTANCE < (n))                                                                                 \
+        hashes[i % PREFETCH_DISTANCE] = prefetch_bin(table, (keys)[i + PREFETCH_DISTANCE]);                            \
+      op(table, (keys)[i], hash);                                                                                      \
+    }                                                                                                                  \
+  } while (0)
+
+void
+insert_keys(struct hash_table *table, const unsigned int *keys, size_t n) {
+  FOR_EACH_PREFETCHED(table, keys, n, insert_hashed);
+}
+
+void
+delete_keys(struct hash_table *table, const unsigned int *keys, size_t n) {
+  FOR_EACH_PREFETCHED(table, keys, n, delete_hashed);
+}
+
+struct lookup {
+  // Which key, n for a slot with nothing left to do.
+  size_t i;
+  unsigned int key;
+  // Set until the bin has been read, after that link is the next link to compare with (prefetched already).
+  LIST bin;
+  struct link *link;
+};
+
+static inline void
+start_lookup(struct hash_table *table, struct lookup *lookup, const unsigned int *keys, size_t i) {
+  lookup->i = i;
+  lookup->key = keys[i];
+  lookup->bin = get_bin_for_key(table, keys[i]);
+  lookup->link = NULL;
+  __builtin_prefetch(lookup->bin);
+}
+
+void
+contains_keys(struct hash_table *table, const unsigned int *keys, size_t n, uint64_t *out_bitmap) {
+  memset(out_bitmap, 0, (n + 63) / 64 * sizeof *out_bitmap);
 
-    if (contains_element(bin, key)) {
-        delete_element(bin, key);
+  struct lookup lookups[LOOKUPS_IN_FLIGHT];
+  size_t next = 0, active = 0;
+  for (size_t s = 0; s < LOOKUPS_IN_FLIGHT; ++s) {
+    if (next < n) {
+      start_lookup(table, &lookups[s], keys, next++);
+      active++;
+    } else {
+      lookups[s].i = n;
     }
+  }
+
+  for (size_t s = 0; active; s = (s + 1) % LOOKUPS_IN_FLIGHT) {
+    struct lookup *lookup = &lookups[s];
+    if (lookup->i == n) continue;
+
+    bool found = false;
+    if (lookup->bin) {
+      lookup->link = *lookup->bin;
+      lookup->bin = NULL;
+    } else if (lookup->link->key == lookup->key) {
+      found = true;
+    } else {
+      lookup->link = lookup->link->next;
+    }
+
+    // Not there yet, come back for it once the link is in.
+    if (!found && lookup->link) {
+      __builtin_prefetch(lookup->link);
+      continue;
+    }
+
+    if (found) out_bitmap[lookup->i / 64] |= 1ULL << (lookup->i % 64);
+    if (next < n) {
+      start_lookup(table, lookup, keys, next++);
+    } else {
+      lookup->i = n;
+      active--;
+    }
+  }
 }
 
 #ifdef WITH_METRICS
@@ -89,5 +295,9 @@ print_metrics(struct hash_table *table) {
     printf("Total stats:\n");
     printf("Count      : %zu\n", table->count);
     printf("Collisions : %zu\n", table->collisions);
+    if (table->index_mode == INDEX_MERSENNE)
+        printf("Bins       : %u (2^%u - 1)\n", table->size, table->mersenne_prime_power);
+    else
+        printf("Bins       : %u (%s)\n", table->size, index_mode_name(table->index_mode));
 }
 #endif
@@ -3,8 +3,11 @@
 
 #include <assert.h>
 #include <stdbool.h>
+#include <stdint.h>
 #include <stdlib.h>
 
+#include "hash_table_helper.h"
+
 /*
  * What should the API look like for a hash table?
  * 1. Constructor  - Creates and initializes the table.
@@ -37,14 +40,69 @@ typedef struct link **LIST;
 
 #define EMPTY_LIST &((struct link *){NULL})
 
+/*
+ * malloc'ing one 16 byte link per insert is what makes chaining slow (see benchmarks/walkthrough.md). On top of the
+ * call itself, every chunk comes with its own header, so you get two links per cache line at best and they're
+ * scattered all over the heap.
+ *
+ * So the table carves its links out of big slabs instead. A slab is 64KB, cache line aligned, with the links packed
+ * back to back (4 per cache line, no headers). Links that get deleted go on a free list and are handed out again before
+ * we touch the slab, and delete_table just throws all the slabs away in one go.
+ */
+#define LINKS_PER_SLAB 4095
+
+struct slab {
+  _Alignas(64) struct link links[LINKS_PER_SLAB];
+  struct slab *next;
+};
+
+struct slab_allocator {
+  // Every slab we've carved links out of, newest first.
+  struct slab *slabs;
+  // Links given back by slab_free_head, chained through their ->next.
+  struct link *free_links;
+  // How many links of the newest slab have been handed out.
+  size_t used;
+};
+
+/*
+ * Resizing.
+ *
+ * Once count / size goes over max_load_factor the table moves to the next Mersenne power. Doing that in one go means
+ * one unlucky insert pays for rehashing every key, so instead we keep the old bins around and move a few of them over
+ * on every insert/delete. Old bins below `migrated` have been moved, the rest are still where they were, so a key
+ * lives in exactly one place: its old bin if that hasn't been migrated yet, otherwise its new bin.
+ *
+ * Moving a bin is just relinking its links, nothing gets allocated or freed. Lookups don't migrate anything, so
+ * contains_key stays read only.
+ */
+#define DEFAULT_MAX_LOAD_FACTOR 1.0
+#define MAX_MERSENNE_PRIME_POWER 32
+// Old bins moved per insert/delete. As long as this is >= 1 / max_load_factor the migration is done before the next
+// resize is due. Building with -DMIGRATE_BINS_PER_OP=UINT_MAX gets you the stop-the-world rehash for comparison.
+#ifndef MIGRATE_BINS_PER_OP
+#define MIGRATE_BINS_PER_OP 4
+#endif
+
 struct hash_table {
   unsigned int size;
+  // s, see hash_table_helper.h. 2^s - 1 bins unless the table was made with another index mode.
   uint8_t mersenne_prime_power;
+  enum index_mode index_mode;
+  size_t count;
+  double max_load_factor;
 #ifdef WITH_METRICS
   size_t collisions;
-  size_t count;
 #endif
   LIST bins;
+  // Only set while a resize is in progress.
+  LIST old_bins;
+  unsigned int old_size;
+  uint8_t old_mersenne_prime_power;
+  unsigned int migrated;
+  struct slab_allocator allocator;
+  // Last, the tabulation tables are 4 KB and would push everything else apart.
+  struct hasher hasher;
 };
 
 static inline void
@@ -108,12 +166,80 @@ delete_element(LIST list, unsigned int key) {
   }
 }
 
+static inline void
+init_slab_allocator(struct slab_allocator *allocator) {
+  *allocator = (struct slab_allocator){.slabs = NULL, .free_links = NULL, .used = LINKS_PER_SLAB};
+}
+
+static inline void
+free_slabs(struct slab_allocator *allocator) {
+  while (allocator->slabs) {
+    struct slab *next = allocator->slabs->next;
+    free(allocator->slabs);
+    allocator->slabs = next;
+  }
+  init_slab_allocator(allocator);
+}
+
+static inline struct link *
+slab_new_link(struct slab_allocator *allocator, unsigned int key, struct link *next) {
+  struct link *link = allocator->free_links;
+  if (link) {
+    allocator->free_links = link->next;
+  } else {
+    if (allocator->used == LINKS_PER_SLAB) {
+      struct slab *slab = aligned_alloc(_Alignof(struct slab), sizeof *slab);
+      if (!slab) return NULL;
+      slab->next = allocator->slabs;
+      allocator->slabs = slab;
+      allocator->used = 0;
+    }
+    link = &allocator->slabs->links[allocator->used++];
+  }
+  *link = (struct link){.key = key, .next = next};
+  return link;
+}
+
+// Same as free_head, but the link goes back on the allocator's free list instead of to free().
+static inline void
+slab_free_head(struct slab_allocator *allocator, LIST list) {
+  struct link *head = *list;
+  *list = head->next;
+  head->next = allocator->free_links;
+  allocator->free_links = head;
+}
+
+static inline void
+slab_add_element(struct slab_allocator *allocator, LIST list, unsigned int key) {
+  struct link *link = slab_new_link(allocator, key, *list);
+  if (link) *list = link;
+}
+
+static inline bool
+slab_delete_element(struct slab_allocator *allocator, LIST list, unsigned int key) {
+  if ((list = find_key(list, key))) {
+    slab_free_head(allocator, list);
+    return true;
+  }
+  return false;
+}
+
 struct hash_table *
 new_table(uint8_t mersenne_prime_power, unsigned int size);
 
+// Same, with keys reduced to a bin by index_mode instead (see hash_table_helper.h). size has to match it: 2^s bins for
+// INDEX_FIBONACCI, anything up to 2^s for INDEX_FASTRANGE. Growing doubles the size in every mode.
+struct hash_table *
+new_table_with_index(uint8_t mersenne_prime_power, unsigned int size, enum index_mode index_mode);
+
 void
 delete_table(struct hash_table *table);
 
+// What keys go through ahead of hash_bin_index (see hash_table_helper.h), HASH_IDENTITY by default. Only works while the
+// table is empty, returns false otherwise.
+bool
+set_hash_function(struct hash_table *table, enum hash_function function, uint64_t seed);
+
 LIST
 get_bin_for_key(struct hash_table *table, unsigned int key);
 
@@ -126,6 +252,38 @@ contains_key(struct hash_table *table, unsigned int key);
 void
 delete_key(struct hash_table *table, unsigned int key);
 
+/*
+ * The same, n keys at a time, with the memory accesses of neighbouring keys overlapped (see hash_table.c). Meant for
+ * tables way bigger than the cache. contains_keys sets bit i of out_bitmap (room for n bits, 64 per word) if keys[i] is
+ * in the table and clears it otherwise.
+ */
+#ifndef PREFETCH_DISTANCE
+#define PREFETCH_DISTANCE 16
+#endif
+#ifndef LOOKUPS_IN_FLIGHT
+#define LOOKUPS_IN_FLIGHT 8
+#endif
+
+void
+insert_keys(struct hash_table *table, const unsigned int *keys, size_t n);
+
+void
+contains_keys(struct hash_table *table, const unsigned int *keys, size_t n, uint64_t *out_bitmap);
+
+void
+delete_keys(struct hash_table *table, const unsigned int *keys, size_t n);
+
+/*
+ * A new table holding keys (duplicates are fine), built by threads threads at once. The keys are split by bin, so every
+ * thread links its own range of bins from its own slab allocator and nobody waits for anybody. At least
+ * 2^mersenne_prime_power - 1 bins, more if that's too few for n keys. Same table as inserting them one by one, apart
+ * from the order within a chain.
+ *
+ * It's in hash_table_bulk.c, link that and radix_partition.c with -pthread to use it.
+ */
+struct hash_table *
+build_table(uint8_t mersenne_prime_power, const unsigned int *keys, size_t n, int threads);
+
 #ifdef WITH_METRICS
 void
 print_metrics(struct hash_table *table);
@@ -0,0 +1,90 @@
+#include "hash_table.h"
+
+#include <stdlib.h>
+
+#include "radix_partition.h"
+
+// Every thread links from its own slabs, one cache line each so the counters don't bounce around.
+struct bulk_thread {
+  _Alignas(64) struct slab_allocator allocator;
+  size_t count;
+};
+
+struct bulk_build {
+  struct hash_table *table;
+  struct bulk_thread *threads;
+};
+
+static size_t
+fill_bins(void *arg, int thread, size_t begin, size_t end, unsigned int *keys, size_t n) {
+  (void)begin, (void)end;
+  struct bulk_build *build = arg;
+  struct hash_table *table = build->table;
+  struct bulk_thread *own = &build->threads[thread];
+  size_t left = 0;
+
+  for (size_t i = 0; i < n; ++i) {
+    unsigned int key = keys[i];
+    if (key == DEFAULT_KEY) continue;
+    LIST bin = table->bins + hash_bin_index(hash_key(&table->hasher, key), table->mersenne_prime_power);
+    if (contains_element(bin, key)) continue;
+    struct link *link = slab_new_link(&own->allocator, key, *bin);
+    // Sadly malloc can fail. Leave it for insert_keys, maybe there's room by then.
+    if (!link) {
+      keys[left++] = key;
+      continue;
+    }
+    *bin = link;
+    own->count++;
+  }
+  return left;
+}
+
+struct hash_table *
+build_table(uint8_t mersenne_prime_power, const unsigned int *keys, size_t n, int threads) {
+  if (threads < 1) threads = 1;
+  // Room for every key without going over the load factor, duplicates or not.
+  while (mersenne_prime_power < MAX_MERSENNE_PRIME_POWER &&
+         n > DEFAULT_MAX_LOAD_FACTOR * ((1ULL << mersenne_prime_power) - 1))
+    mersenne_prime_power++;
+
+  struct bulk_build build = {
+      .table = new_table(mersenne_prime_power, (1ULL << mersenne_prime_power) - 1),
+      .threads = aligned_alloc(_Alignof(struct bulk_thread), threads * sizeof *build.threads),
+  };
+  unsigned int *leftovers = NULL;
+  // Sadly malloc can fail.
+  if (!build.table || !build.threads) goto error;
+  for (int t = 0; t < threads; ++t) {
+    init_slab_allocator(&build.threads[t].allocator);
+    build.threads[t].count = 0;
+  }
+
+  size_t left = fill_partitioned(keys, n, &build.table->hasher, mersenne_prime_power, threads, fill_bins, &build,
+                                 &leftovers);
+
+  // The table owns every thread's slabs from here on, even if it didn't work out. The newest one of each is probably
+  // only partly used, that's a few KB per thread, and the table starts a fresh slab of its own for its next link.
+  struct slab_allocator *allocator = &build.table->allocator;
+  for (int t = 0; t < threads; ++t) {
+    struct slab *slabs = build.threads[t].allocator.slabs;
+    if (!slabs) continue;
+    struct slab *last = slabs;
+    while (last->next) last = last->next;
+    last->next = allocator->slabs;
+    allocator->slabs = slabs;
+    allocator->used = LINKS_PER_SLAB;
+    build.table->count += build.threads[t].count;
+  }
+  if (left == SIZE_MAX) goto error;
+  insert_keys(build.table, leftovers, left);
+
+  free(leftovers);
+  free(build.threads);
+  return build.table;
+
+error:
+  if (build.table) delete_table(build.table);
+  free(build.threads);
+  return NULL;
+}
@@ -1,6 +1,7 @@
 #ifndef HASH_TABLE_HELPER
 #define HASH_TABLE_HELPER
 
+#include <stdint.h>
 #include <stdlib.h>
 
 // s can only be so big if we want to store it :shrug:
@@ -8,7 +9,160 @@ static inline uint64_t
 hash_bin_index(uint64_t x, uint8_t s) {
   uint64_t p = (1ULL << s) - 1;
   uint64_t y = (x >> s) + (x & p);
-  return (y >= p) ? y - p : y;
+  // One fold is enough when x has at most 2s bits (32 bit keys with s >= 16). Smaller tables need a couple more, and
+  // for x = 2^2s - 1 a single fold followed by y - p would give back p itself, one past the last bin.
+  while (y > p) y = (y >> s) + (y & p);
+  return (y == p) ? 0 : y;
+}
+
+/*
+ * Other ways to get from a hash to a bin, for when 2^s - 1 bins isn't what you want.
+ *
+ *   INDEX_MERSENNE   2^s - 1 bins, hash_bin_index. The default everywhere.
+ *   INDEX_FIBONACCI  2^s bins. Multiply by 2^64 / phi and keep the top s bits (Knuth's Fibonacci hashing). Just
+ *                    masking off the low bits would throw the high ones away, the multiply mixes them in first.
+ *   INDEX_FASTRANGE  Any number of bins. (low 32 bits of hash * size) >> 32, Lemire's multiply-high range reduction.
+ *                    That's the high bits of the hash though, so small keys with HASH_IDENTITY all land in bin 0. Use
+ *                    it with keys that are random already, or with a real hash function in front.
+ *
+ * A table keeps s either way: the bins are 2^s - 1, 2^s, or at most 2^s for INDEX_FASTRANGE, and growing means s + 1
+ * (which doubles a fastrange table's size).
+ */
+enum index_mode {
+  INDEX_MERSENNE,
+  INDEX_FIBONACCI,
+  INDEX_FASTRANGE,
+};
+
+#define FIBONACCI_MULTIPLIER 0x9E3779B97F4A7C15ULL
+
+static inline uint64_t
+reduce_index(uint64_t hash, enum index_mode mode, uint8_t s, uint64_t size) {
+  switch (mode) {
+  case INDEX_MERSENNE:
+    return hash_bin_index(hash, s);
+  case INDEX_FIBONACCI:
+    // A shift by 64 is undefined, and a single bin is bin 0 anyway.
+    return s ? (hash * FIBONACCI_MULTIPLIER) >> (64 - s) : 0;
+  case INDEX_FASTRANGE:
+    // size <= 2^32, so this fits in 64 bits.
+    return ((uint64_t)(uint32_t)hash * size) >> 32;
+  }
+  return hash_bin_index(hash, s);
+}
+
+// How many bins s means: 2^s - 1 for Mersenne, 2^s for the others (the most a fastrange table at s can have).
+static inline uint64_t
+index_bins(enum index_mode mode, uint8_t s) {
+  return mode == INDEX_MERSENNE ? (1ULL << s) - 1 : 1ULL << s;
+}
+
+// The smallest s with room for size bins.
+static inline uint8_t
+index_power(enum index_mode mode, uint64_t size) {
+  uint8_t s = 0;
+  while (index_bins(mode, s) < size) s++;
+  return s;
+}
+
+static inline const char *
+index_mode_name(enum index_mode mode) {
+  switch (mode) {
+  case INDEX_FIBONACCI:
+    return "Fibonacci";
+  case INDEX_FASTRANGE:
+    return "Fastrange";
+  default:
+    return "Mersenne";
+  }
+}
+
+/*
+ * Hashing ahead of hash_bin_index.
+ *
+ * On its own hash_bin_index is key mod 2^s - 1, so keys with structure in them (pointers, strided IDs, multiples of
+ * 2^s - 1...) pile up in a few bins, see docs/Hash Keys, Indices, and Collissions.md. A table can run its keys through
+ * one of these first:
+ *
+ *   HASH_IDENTITY        the key as is, what every table did so far.
+ *   HASH_MULTIPLY_SHIFT  the top 32 bits of a * key, a a random odd 64 bit number. One multiply.
+ *   HASH_UNIVERSAL       (a * key + b) mod 2^61 - 1, a and b random. Universal, so no key set is bad for every seed, and
+ *                        2^61 - 1 is a Mersenne prime too, so it's the same shift and add trick as hash_bin_index.
+ *   HASH_TABULATION      one random 32 bit word per key byte, xor'd together. 3-independent, 4 KB of tables.
+ *
+ * The hash doesn't depend on the table size, so a resizing table can hash once and hash_bin_index it for both sizes.
+ */
+enum hash_function {
+  HASH_IDENTITY,
+  HASH_MULTIPLY_SHIFT,
+  HASH_UNIVERSAL,
+  HASH_TABULATION,
+};
+
+#define MERSENNE_61 ((1ULL << 61) - 1)
+
+struct hasher {
+  enum hash_function function;
+  // What it was made from, enough to make the same one again (see save_table).
+  uint64_t seed;
+  uint64_t a;
+  uint64_t b;
+  uint32_t tabulation[4][256];
+};
+
+// Turns one seed into as many random words as we need.
+static inline uint64_t
+splitmix64(uint64_t *state) {
+  uint64_t z = (*state += 0x9E3779B97F4A7C15ULL);
+  z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+  z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+  return z ^ (z >> 31);
+}
+
+static inline void
+init_hasher(struct hasher *hasher, enum hash_function function, uint64_t seed) {
+  hasher->function = function;
+  hasher->seed = seed;
+  hasher->a = 0;
+  hasher->b = 0;
+
+  switch (function) {
+  case HASH_MULTIPLY_SHIFT:
+    hasher->a = splitmix64(&seed) | 1;
+    break;
+  case HASH_UNIVERSAL:
+    // a in [1, 2^61 - 1), b in [0, 2^61 - 1). Close enough to uniform.
+    hasher->a = splitmix64(&seed) % (MERSENNE_61 - 1) + 1;
+    hasher->b = splitmix64(&seed) % MERSENNE_61;
+    break;
+  case HASH_TABULATION:
+    for (int i = 0; i < 4; i++) {
+      for (int j = 0; j < 256; j++) hasher->tabulation[i][j] = (uint32_t)splitmix64(&seed);
+    }
+    break;
+  default:
+    break;
+  }
+}
+
+static inline uint64_t
+hash_key(const struct hasher *hasher, uint32_t key) {
+  switch (hasher->function) {
+  case HASH_IDENTITY:
+    return key;
+  case HASH_MULTIPLY_SHIFT:
+    return (hasher->a * key) >> 32;
+  case HASH_UNIVERSAL: {
+    // a < 2^61 and key < 2^32, so this fits in 128 bits with room to spare.
+    unsigned __int128 x = (unsigned __int128)hasher->a * key + hasher->b;
+    uint64_t y = (uint64_t)(x & MERSENNE_61) + (uint64_t)(x >> 61);
+    return y >= MERSENNE_61 ? y - MERSENNE_61 : y;
+  }
+  case HASH_TABULATION:
+    return hasher->tabulation[0][key & 0xFF] ^ hasher->tabulation[1][(key >> 8) & 0xFF] ^
+           hasher->tabulation[2][(key >> 16) & 0xFF] ^ hasher->tabulation[3][key >> 24];
+  }
+  return key;
 }
 
 #endif
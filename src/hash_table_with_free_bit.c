@@ -1,38 +1,240 @@
 #include "hash_table_with_free_bit.h"
 
 #include <stdlib.h>
+#include <string.h>
+
+#include "hash_table_helper.h"
+
+#define BITS_PER_WORD 64
+
+static inline size_t
+bitmap_words(size_t size) {
+  return (size + BITS_PER_WORD - 1) / BITS_PER_WORD;
+}
+
+static inline bool
+test_bit(const uint64_t *bitmap, size_t index) {
+  return (bitmap[index / BITS_PER_WORD] >> (index % BITS_PER_WORD)) & 1;
+}
+
+static inline void
+set_bit(uint64_t *bitmap, size_t index) {
+  bitmap[index / BITS_PER_WORD] |= 1ULL << (index % BITS_PER_WORD);
+}
+
+static inline void
+clear_bit(uint64_t *bitmap, size_t index) {
+  bitmap[index / BITS_PER_WORD] &= ~(1ULL << (index % BITS_PER_WORD));
+}
+
+// The bits of word w that are actual bins, 2^s - 1 is never a multiple of 64 so the last word is only partly used.
+static inline uint64_t
+valid_bits(const struct hash_table_with_free_bit *table, size_t w) {
+  size_t tail = table->size % BITS_PER_WORD;
+  return (tail && w == bitmap_words(table->size) - 1) ? (1ULL << tail) - 1 : ~0ULL;
+}
+
+/*
+ * Walks key's cluster, from its home bin up to the first free bin, a word of bitmap at a time. Returns the bin holding
+ * key, or table->size if it isn't there. If reusable isn't NULL it gets the first free or deleted bin on the way, i.e.
+ * where key should go (table->size if there's no such bin).
+ */
+static size_t
+find_bin(struct hash_table_with_free_bit *table, unsigned int key, size_t *reusable) {
+  size_t size = table->size, words = bitmap_words(size);
+  size_t home = hash_bin_index(key, table->mersenne_prime_power);
+  size_t w = home / BITS_PER_WORD;
+  uint64_t from = ~0ULL << (home % BITS_PER_WORD);
+  if (reusable) *reusable = size;
+
+  // Most keys sit in their home bin, check that before doing any masking. Bits first, keys of bins never used are
+  // whatever malloc left there.
+  if (!reusable && test_bit(table->used, home) && !test_bit(table->deleted, home) && table->keys[home] == key)
+    return home;
+
+  // words + 1 since the home word comes around again at the end, for the bins before home.
+  for (size_t n = 0; n <= words; ++n) {
+    uint64_t valid = from & valid_bits(table, w);
+    uint64_t used = table->used[w];
+    uint64_t free = ~used & valid;
+    // The cluster stops at the first free bin (if there's one in this word).
+    uint64_t cluster = free ? valid & ((free & -free) - 1) : valid;
+    uint64_t tombstones = cluster & table->deleted[w];
+
+    // Only compare keys with bins that actually hold one.
+    for (uint64_t live = cluster & used & ~tombstones; live; live &= live - 1) {
+      size_t index = w * BITS_PER_WORD + __builtin_ctzll(live);
+      if (table->keys[index] == key) return index;
+#ifdef WITH_METRICS
+      // It's occupied by someone else -> Collision
+      if (reusable) table->collisions++;
+#endif
+    }
+
+    if (reusable && *reusable == size && (free | tombstones))
+      *reusable = w * BITS_PER_WORD + __builtin_ctzll(free | tombstones);
+    if (free) break;
+
+    from = ~0ULL;
+    w = (w + 1 == words) ? 0 : w + 1;
+  }
+  return size;
+}
+
+// Puts key, which isn't in there, into the first free bin from its home bin on. For bins without any tombstones.
+static void
+place_new_key(struct hash_table_with_free_bit *table, unsigned int *keys, uint64_t *used, unsigned int key) {
+  size_t words = bitmap_words(table->size);
+  size_t home = hash_bin_index(key, table->mersenne_prime_power);
+  size_t w = home / BITS_PER_WORD;
+  uint64_t from = ~0ULL << (home % BITS_PER_WORD);
+
+  for (size_t n = 0; n <= words; ++n) {
+    uint64_t free = ~used[w] & from & valid_bits(table, w);
+    if (free) {
+      size_t index = w * BITS_PER_WORD + __builtin_ctzll(free);
+      set_bit(used, index);
+      keys[index] = key;
+      return;
+    }
+    from = ~0ULL;
+    w = (w + 1 == words) ? 0 : w + 1;
+  }
+}
+
+// Rebuilds the table at the same size, without the tombstones.
+static void
+drop_tombstones(struct hash_table_with_free_bit *table) {
+  unsigned int *keys = (unsigned int *)malloc((size_t)table->size * sizeof *keys);
+  uint64_t *used = (uint64_t *)calloc(bitmap_words(table->size), sizeof *used);
+  if (!keys || !used) {
+    // Keep going with the tombstones, it's only slower.
+    free(keys);
+    free(used);
+    return;
+  }
+
+  for (size_t w = 0; w < bitmap_words(table->size); ++w) {
+    for (uint64_t live = table->used[w] & ~table->deleted[w]; live; live &= live - 1)
+      place_new_key(table, keys, used, table->keys[w * BITS_PER_WORD + __builtin_ctzll(live)]);
+  }
+
+  free(table->keys);
+  free(table->used);
+  table->keys = keys;
+  table->used = used;
+  // No tombstones left, the deleted bitmap can stay, it just needs clearing.
+  memset(table->deleted, 0, bitmap_words(table->size) * sizeof *table->deleted);
+  table->tombstones = 0;
+#ifdef WITH_METRICS
+  table->rehashes++;
+#endif
+}
 
 struct hash_table_with_free_bit *
 new_table_with_free_bit(uint8_t mersenne_prime_power, unsigned int size) {
   struct hash_table_with_free_bit *table = (struct hash_table_with_free_bit *)malloc(sizeof *table);
-  struct bin *bins = (struct bin *)malloc(size * sizeof *bins);
+  // The keys don't need clearing, a bin's key only means something once its used bit is set.
+  unsigned int *keys = (unsigned int *)malloc((size_t)size * sizeof *keys);
+  uint64_t *used = (uint64_t *)calloc(bitmap_words(size), sizeof *used);
+  uint64_t *deleted = (uint64_t *)calloc(bitmap_words(size), sizeof *deleted);
 
   // Sadly malloc can fail.
-  // TODO: Look into if goto is a good fit for error handling here.
-  if (!table || !bins) goto error;
-
-  *table = (struct hash_table_with_free_bit){.size = size, .bins = bins, .mersenne_prime_power = mersenne_prime_power};
+  if (!table || !keys || !used || !deleted) goto error;
 
-  struct bin *beg = table->bins, *end = beg + size;
-  for (struct bin *bin = beg; bin != end; ++bin) {
-    bin->is_free = 1;
-  }
+  *table = (struct hash_table_with_free_bit){.size = size,
+                                             .mersenne_prime_power = mersenne_prime_power,
+                                             .count = 0,
+                                             .tombstones = 0,
+                                             .keys = keys,
+                                             .used = used,
+                                             .deleted = deleted};
 
   return table;
 
 error:
   free(table);
-  free(bins);
+  free(keys);
+  free(used);
+  free(deleted);
   return NULL;
 }
 
 void
 delete_table_with_free_bit(struct hash_table_with_free_bit *table) {
-  free(table->bins);
+  free(table->keys);
+  free(table->used);
+  free(table->deleted);
   free(table);
 }
 
-struct bin *
+size_t
 hash_bin_with_free_bit(struct hash_table_with_free_bit *table, unsigned int key) {
-  return (table->bins) + hash_bin_index(key, table->mersenne_prime_power);
+  return hash_bin_index(key, table->mersenne_prime_power);
+}
+
+void
+insert_key_with_free_bit(struct hash_table_with_free_bit *table, unsigned int key) {
+  size_t index;
+  // Already in there, or nowhere to put it.
+  if (find_bin(table, key, &index) != table->size || index == table->size) return;
+
+  if (test_bit(table->deleted, index)) {
+    clear_bit(table->deleted, index);
+    table->tombstones--;
+  } else if (table->tombstones && (table->count + table->tombstones + 1) * 8 > (size_t)table->size * 7) {
+    // About to use up one more free bin with too many tombstones around, clean them up first. Same rule as
+    // swiss_table.c. The key isn't in the table, so it can go straight into its new spot.
+    drop_tombstones(table);
+    place_new_key(table, table->keys, table->used, key);
+    table->count++;
+    return;
+  }
+  set_bit(table->used, index);
+  table->keys[index] = key;
+  table->count++;
+}
+
+bool
+contains_key_with_free_bit(struct hash_table_with_free_bit *table, unsigned int key) {
+  return find_bin(table, key, NULL) != table->size;
+}
+
+void
+delete_key_with_free_bit(struct hash_table_with_free_bit *table, unsigned int key) {
+  size_t index = find_bin(table, key, NULL);
+  if (index == table->size) return;
+  table->count--;
+
+  size_t next = (index + 1 == table->size) ? 0 : index + 1;
+  if (test_bit(table->used, next)) {
+    // Keys after this one might have probed past it, leave a tombstone.
+    set_bit(table->deleted, index);
+    table->tombstones++;
+    return;
+  }
+
+  // The cluster ends right here, so no probe ever needs to get past this bin. It can go straight back to free, and so
+  // can any tombstones right before it.
+  clear_bit(table->used, index);
+  for (;;) {
+    index = (index == 0) ? table->size - 1 : index - 1;
+    if (!test_bit(table->deleted, index)) break;
+    clear_bit(table->deleted, index);
+    clear_bit(table->used, index);
+    table->tombstones--;
+  }
+}
+
+#ifdef WITH_METRICS
+#include <stdio.h>
+void
+print_metrics_with_free_bit(struct hash_table_with_free_bit *table) {
+  printf("Total stats:\n");
+  printf("     Count: %zu\n", table->count);
+  printf("Collisions: %zu\n", table->collisions);
+  printf("Tombstones: %zu\n", table->tombstones);
+  printf("  Rehashes: %zu\n", table->rehashes);
+  printf("      Bins: %u (2^%u - 1)\n", table->size, table->mersenne_prime_power);
 }
+#endif
@@ -1,18 +1,40 @@
 #ifndef HASH_TABLE_WITH_FREE_BIT_H
 #define HASH_TABLE_WITH_FREE_BIT_H
 
+#include <stdbool.h>
 #include <stdint.h>
 #include <stdlib.h>
 
-struct bin {
-  unsigned int is_free : 1;
-  unsigned int key;
-};
+/*
+ * Open addressing (linear probing) with the free/deleted bits pulled out of the bins.
+ *
+ * A struct bin with a 1 bit is_free next to the key gets padded to 8 bytes, so half the table is padding. Here the bins
+ * are bare keys and the state lives in two bitmaps, one bit per bin each:
+ *
+ *   used     the bin holds a key, or held one (a tombstone)
+ *   deleted  the bin is a tombstone
+ *
+ * That's 4.25 bytes per bin instead of 8, 2^31 bins are ~9 GB instead of 16.
+ *
+ * It also means probing doesn't have to look at the bins one at a time. A 64 bit word of `used` tells us where the
+ * cluster we're walking ends (first zero bit, ctz), and used & ~deleted which bins in it are worth comparing keys with.
+ *
+ * Fixed size, like the original. Tombstones get cleaned up the way swiss_table.c does it: deletes at the end of a
+ * cluster go straight back to free, and once keys + tombstones would take up 7/8 of the bins the table is rebuilt.
+ */
 
 struct hash_table_with_free_bit {
   unsigned int size;
   uint8_t mersenne_prime_power;
-  struct bin *bins;
+  size_t count;
+  size_t tombstones;
+  unsigned int *keys;
+  uint64_t *used;
+  uint64_t *deleted;
+#ifdef WITH_METRICS
+  size_t collisions;
+  size_t rehashes;
+#endif
 };
 
 struct hash_table_with_free_bit *
@@ -21,7 +43,23 @@ new_table_with_free_bit(uint8_t mersenne_prime_power, unsigned int size);
 void
 delete_table_with_free_bit(struct hash_table_with_free_bit *table);
 
-struct bin *
+// The home bin of key.
+size_t
 hash_bin_with_free_bit(struct hash_table_with_free_bit *table, unsigned int key);
 
+// Nothing happens if there's no room left.
+void
+insert_key_with_free_bit(struct hash_table_with_free_bit *table, unsigned int key);
+
+bool
+contains_key_with_free_bit(struct hash_table_with_free_bit *table, unsigned int key);
+
+void
+delete_key_with_free_bit(struct hash_table_with_free_bit *table, unsigned int key);
+
+#ifdef WITH_METRICS
+void
+print_metrics_with_free_bit(struct hash_table_with_free_bit *table);
+#endif
+
 #endif
@@ -7,6 +7,9 @@
 /*
  * Well seems like the **prev version is not used in the actual hash table implementation. It's just a norma one.
  * This was a good aside nonetheless.
+ *
+ * Update: hlist_table.h uses it after all. Since a node knows where the pointer pointing at it lives, a node can be
+ * unlinked in O(1) without searching the bin for it first.
  */
 
 /*
@@ -70,6 +73,14 @@ struct hlist_node {
 // Given a pointer to the hlist_head set's the hlist_head->first to NULL.
 #define INIT_HLIST_HEAD(ptr) ((ptr)->first = NULL)
 
+// Given a pointer to a member of a struct, get back a pointer to the struct itself.
+#define container_of(ptr, type, member) ((type*)((char*)(ptr) - offsetof(type, member)))
+// Given a pointer to an embedded hlist_node, get back the struct it's embedded in.
+#define hlist_entry(ptr, type, member) container_of(ptr, type, member)
+
+// Walk every node of the list, pos being the current node.
+#define hlist_for_each(pos, head) for ((pos) = (head)->first; (pos); (pos) = (pos)->next)
+
 // Initialize an empty hlist_node.
 static inline void
 INIT_HLIST_NODE(struct hlist_node* n) {
@@ -84,6 +95,13 @@ hlist_empty(const struct hlist_head* h) {
   return !h->first;
 };
 
+// Returns whether the node is on a list or not. Only meaningful for nodes that were initialized with INIT_HLIST_NODE
+// or removed with hlist_delete_node_init.
+static inline int
+hlist_unhashed(const struct hlist_node* n) {
+  return !n->pprev;
+}
+
 // Deletes the given node from the list leaving it's pointers unchanged.
 static inline void
 hlist_delete_node(struct hlist_node* n) {
@@ -0,0 +1,75 @@
+#include "hlist_table.h"
+
+#include <stdlib.h>
+
+#include "hash_table_helper.h"
+
+struct hlist_table *
+new_hlist_table(uint8_t mersenne_prime_power, ptrdiff_t key_offset) {
+  size_t size = (1ULL << mersenne_prime_power) - 1;
+  struct hlist_table *table = (struct hlist_table *)malloc(sizeof *table);
+  struct hlist_head *bins = (struct hlist_head *)malloc(size * sizeof *bins);
+
+  // Sadly malloc can fail.
+  if (!table || !bins) goto error;
+
+  *table = (struct hlist_table){
+      .bins = bins, .size = size, .mersenne_prime_power = mersenne_prime_power, .key_offset = key_offset, .count = 0};
+
+  for (struct hlist_head *bin = bins; bin != bins + size; ++bin) {
+    INIT_HLIST_HEAD(bin);
+  }
+
+  return table;
+
+error:
+  free(table);
+  free(bins);
+  return NULL;
+}
+
+void
+delete_hlist_table(struct hlist_table *table) {
+  free(table->bins);
+  free(table);
+}
+
+struct hlist_head *
+hlist_table_bin(struct hlist_table *table, unsigned int key) {
+  return table->bins + hash_bin_index(key, table->mersenne_prime_power);
+}
+
+struct hlist_node *
+hlist_table_find(struct hlist_table *table, unsigned int key) {
+  struct hlist_node *node;
+  hlist_for_each(node, hlist_table_bin(table, key)) {
+    if (hlist_node_key(table, node) == key) return node;
+  }
+  return NULL;
+}
+
+bool
+hlist_table_contains(struct hlist_table *table, unsigned int key) {
+  return hlist_table_find(table, key) != NULL;
+}
+
+bool
+hlist_table_insert(struct hlist_table *table, struct hlist_node *node) {
+  unsigned int key = hlist_node_key(table, node);
+
+  // No duplicates
+  if (hlist_table_contains(table, key)) return false;
+
+  hlist_add_head(node, hlist_table_bin(table, key));
+  table->count++;
+  return true;
+}
+
+void
+hlist_table_remove(struct hlist_table *table, struct hlist_node *node) {
+  // Not in the table (removed already, or rejected by hlist_table_insert), same as hlist_del_init in Linux.
+  if (hlist_unhashed(node)) return;
+  // pprev already points at whatever points to us, no need to find the bin, let alone search it.
+  hlist_delete_node_init(node);
+  table->count--;
+}
@@ -0,0 +1,75 @@
+#ifndef HLIST_TABLE_H
+#define HLIST_TABLE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "hlist.h"
+
+/*
+ * A chained hash table where the bins are hlist_heads and the nodes are hlist_nodes embedded in the caller's own
+ * records, the way the Linux kernel does it.
+ *
+ * struct record {
+ *   unsigned int key;
+ *   ...
+ *   struct hlist_node node;
+ * };
+ *
+ * The table never allocates anything past the bins, the records can live wherever the caller wants (a pool, an
+ * array, the stack...). The flip side is that the caller owns them, so deleting the table doesn't free any records.
+ *
+ * Since a node knows the pointer pointing at it (pprev), removing a record we already have in hand is O(1), no
+ * searching the bin like delete_key in hash_table.c has to.
+ *
+ * The table needs to get from a node to its key, so it's told where the key is relative to the node once, at creation.
+ * Use HLIST_KEY_OFFSET for that.
+ */
+
+#define HLIST_KEY_OFFSET(type, key_member, node_member) \
+  ((ptrdiff_t)offsetof(type, key_member) - (ptrdiff_t)offsetof(type, node_member))
+
+struct hlist_table {
+  struct hlist_head *bins;
+  size_t size;
+  uint8_t mersenne_prime_power;
+  // Where the key lives relative to the hlist_node, see HLIST_KEY_OFFSET.
+  ptrdiff_t key_offset;
+  size_t count;
+};
+
+static inline unsigned int
+hlist_node_key(const struct hlist_table *table, const struct hlist_node *node) {
+  return *(const unsigned int *)((const char *)node + table->key_offset);
+}
+
+struct hlist_table *
+new_hlist_table(uint8_t mersenne_prime_power, ptrdiff_t key_offset);
+
+// Frees the bins only, the records belong to the caller.
+void
+delete_hlist_table(struct hlist_table *table);
+
+struct hlist_head *
+hlist_table_bin(struct hlist_table *table, unsigned int key);
+
+// Returns the node of the record with the given key, NULL if there's none.
+struct hlist_node *
+hlist_table_find(struct hlist_table *table, unsigned int key);
+
+bool
+hlist_table_contains(struct hlist_table *table, unsigned int key);
+
+// Links the record in. Returns false (and leaves the node alone) if a record with the same key is already in there.
+bool
+hlist_table_insert(struct hlist_table *table, struct hlist_node *node);
+
+// Unlinks the record in O(1). The node is re-initialized, so it can be inserted again later. A node that isn't in the
+// table (removed already, or rejected by hlist_table_insert) is left alone, as long as it was set up with
+// INIT_HLIST_NODE.
+void
+hlist_table_remove(struct hlist_table *table, struct hlist_node *node);
+
+#endif
@@ -0,0 +1,245 @@
+#include "key_stream.h"
+
+#include <errno.h>
+#include <limits.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+struct key_chunk {
+  char *data;
+  size_t length;
+  // Filled by the reader and not handed back by the parser yet.
+  bool full;
+};
+
+struct key_stream {
+  int fd;
+  enum key_format format;
+  pthread_t reader;
+  pthread_mutex_t lock;
+  pthread_cond_t changed;
+  // Both sides go 0, 1, 0, 1, ... so the parser always knows which one comes next.
+  struct key_chunk chunks[2];
+  // No more chunks coming: the reader hit the end or a read error, or the parser hit bad input.
+  bool done;
+  // Set by close_key_stream, the reader stops as soon as it can.
+  bool stop;
+  int error;
+
+  // Parser only from here on.
+  bool broken;
+  int current;
+  size_t position;
+  bool have_chunk;
+  // A number can go on from the end of one chunk into the next.
+  uint64_t number;
+  bool in_number;
+  size_t bytes;
+};
+
+// Fills chunk up to KEY_STREAM_CHUNK bytes, short only at the end. Returns false on a read error.
+static bool
+fill_chunk(struct key_stream *stream, struct key_chunk *chunk, bool *end) {
+  chunk->length = 0;
+  while (chunk->length < KEY_STREAM_CHUNK) {
+    ssize_t n = read(stream->fd, chunk->data + chunk->length, KEY_STREAM_CHUNK - chunk->length);
+    if (n < 0) {
+      if (errno == EINTR) continue;
+      return false;
+    }
+    if (n == 0) {
+      *end = true;
+      break;
+    }
+    chunk->length += (size_t)n;
+  }
+  return true;
+}
+
+static void *
+read_chunks(void *arg) {
+  struct key_stream *stream = arg;
+  for (int i = 0;; i ^= 1) {
+    struct key_chunk *chunk = &stream->chunks[i];
+    pthread_mutex_lock(&stream->lock);
+    while (chunk->full && !stream->stop) pthread_cond_wait(&stream->changed, &stream->lock);
+    bool stop = stream->stop;
+    pthread_mutex_unlock(&stream->lock);
+    if (stop) break;
+
+    // No lock while reading, the parser doesn't touch a chunk that isn't full.
+    bool end = false;
+    int error = fill_chunk(stream, chunk, &end) ? 0 : errno;
+
+    pthread_mutex_lock(&stream->lock);
+    if (chunk->length) chunk->full = true;
+    if (end || error) {
+      stream->done = true;
+      // Don't lose an EINVAL from the parser.
+      if (error) stream->error = error;
+    }
+    pthread_cond_broadcast(&stream->changed);
+    pthread_mutex_unlock(&stream->lock);
+    if (end || error) break;
+  }
+  return NULL;
+}
+
+struct key_stream *
+open_key_stream(int fd, enum key_format format) {
+  struct key_stream *stream = calloc(1, sizeof *stream);
+  // Sadly malloc can fail.
+  if (!stream) return NULL;
+  stream->fd = fd;
+  stream->format = format;
+  stream->chunks[0].data = malloc(KEY_STREAM_CHUNK);
+  stream->chunks[1].data = malloc(KEY_STREAM_CHUNK);
+  if (!stream->chunks[0].data || !stream->chunks[1].data) goto error;
+
+  pthread_mutex_init(&stream->lock, NULL);
+  pthread_cond_init(&stream->changed, NULL);
+  if (pthread_create(&stream->reader, NULL, read_chunks, stream) != 0) {
+    pthread_cond_destroy(&stream->changed);
+    pthread_mutex_destroy(&stream->lock);
+    goto error;
+  }
+  return stream;
+
+error:
+  free(stream->chunks[0].data);
+  free(stream->chunks[1].data);
+  free(stream);
+  return NULL;
+}
+
+void
+close_key_stream(struct key_stream *stream) {
+  pthread_mutex_lock(&stream->lock);
+  stream->stop = true;
+  pthread_cond_broadcast(&stream->changed);
+  pthread_mutex_unlock(&stream->lock);
+  pthread_join(stream->reader, NULL);
+
+  pthread_cond_destroy(&stream->changed);
+  pthread_mutex_destroy(&stream->lock);
+  free(stream->chunks[0].data);
+  free(stream->chunks[1].data);
+  free(stream);
+}
+
+// Waits for the next chunk. False once there are no more.
+static bool
+take_chunk(struct key_stream *stream) {
+  struct key_chunk *chunk = &stream->chunks[stream->current];
+  pthread_mutex_lock(&stream->lock);
+  while (!chunk->full && !stream->done) pthread_cond_wait(&stream->changed, &stream->lock);
+  bool full = chunk->full;
+  pthread_mutex_unlock(&stream->lock);
+
+  stream->have_chunk = full;
+  stream->position = 0;
+  return full;
+}
+
+static void
+give_back_chunk(struct key_stream *stream) {
+  // The reader can start filling it again as soon as it's back.
+  stream->bytes += stream->chunks[stream->current].length;
+  pthread_mutex_lock(&stream->lock);
+  stream->chunks[stream->current].full = false;
+  pthread_cond_broadcast(&stream->changed);
+  pthread_mutex_unlock(&stream->lock);
+  stream->current ^= 1;
+  stream->have_chunk = false;
+}
+
+// Something that isn't a key. Ends the stream like a read error would.
+static void
+bad_input(struct key_stream *stream) {
+  pthread_mutex_lock(&stream->lock);
+  if (!stream->error) stream->error = EINVAL;
+  stream->done = true;
+  pthread_mutex_unlock(&stream->lock);
+  stream->broken = true;
+  stream->have_chunk = false;
+  stream->in_number = false;
+}
+
+// Parses keys out of the current chunk from position on, up to max of them. Returns how many.
+static size_t
+parse_binary(struct key_stream *stream, const struct key_chunk *chunk, unsigned int *keys, size_t max) {
+  size_t n = (chunk->length - stream->position) / sizeof *keys;
+  if (n > max) n = max;
+  memcpy(keys, chunk->data + stream->position, n * sizeof *keys);
+  stream->position += n * sizeof *keys;
+  // Only the last chunk can be short, and it can't end halfway into a key.
+  if (stream->position + sizeof *keys > chunk->length && stream->position != chunk->length) bad_input(stream);
+  return n;
+}
+
+static size_t
+parse_text(struct key_stream *stream, const struct key_chunk *chunk, unsigned int *keys, size_t max) {
+  size_t n = 0;
+  const char *data = chunk->data;
+  size_t position = stream->position;
+  uint64_t number = stream->number;
+  bool in_number = stream->in_number;
+
+  for (; position < chunk->length && n < max; ++position) {
+    char c = data[position];
+    if (c >= '0' && c <= '9') {
+      number = number * 10 + (uint64_t)(c - '0');
+      in_number = true;
+      if (number > UINT_MAX) goto bad;
+    } else if (c == '\n' || c == ' ' || c == '\r' || c == '\t') {
+      if (in_number) keys[n++] = (unsigned int)number;
+      number = 0;
+      in_number = false;
+    } else {
+      goto bad;
+    }
+  }
+  stream->position = position;
+  stream->number = number;
+  stream->in_number = in_number;
+  return n;
+
+bad:
+  bad_input(stream);
+  return n;
+}
+
+size_t
+next_keys(struct key_stream *stream, unsigned int *keys, size_t max) {
+  size_t n = 0;
+  while (n < max && !stream->broken) {
+    if (!stream->have_chunk && !take_chunk(stream)) {
+      // The last number doesn't need a newline after it.
+      if (stream->in_number) keys[n++] = (unsigned int)stream->number;
+      stream->in_number = false;
+      break;
+    }
+    const struct key_chunk *chunk = &stream->chunks[stream->current];
+    if (stream->format == KEYS_BINARY)
+      n += parse_binary(stream, chunk, keys + n, max - n);
+    else
+      n += parse_text(stream, chunk, keys + n, max - n);
+    if (stream->have_chunk && stream->position == chunk->length) give_back_chunk(stream);
+  }
+  return n;
+}
+
+int
+key_stream_error(struct key_stream *stream) {
+  pthread_mutex_lock(&stream->lock);
+  int error = stream->error;
+  pthread_mutex_unlock(&stream->lock);
+  return error;
+}
+
+size_t
+key_stream_bytes(const struct key_stream *stream) {
+  return stream->bytes;
+}
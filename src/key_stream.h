@@ -0,0 +1,55 @@
+#ifndef KEY_STREAM_H
+#define KEY_STREAM_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Keys from a file descriptor (a file, a pipe, stdin), read in chunks of KEY_STREAM_CHUNK bytes by a thread of their
+ * own. There are two chunks: while the caller parses one and inserts its keys, the reader is already filling the
+ * other, so the parsing and hashing overlap with the reads. The reader waits once both chunks are full, so memory stays
+ * at two chunks however big the input is.
+ *
+ * Formats:
+ *
+ *   KEYS_BINARY  4 bytes per key, in this machine's byte order. What fwrite'ing an unsigned int array gives you.
+ *   KEYS_TEXT    Decimal numbers up to 2^32 - 1, one per line. Any whitespace separates them.
+ *
+ * Anything else (a stray character, a number that doesn't fit, a binary file that isn't a multiple of 4 bytes) stops
+ * the stream, key_stream_error says why.
+ */
+
+// Bytes per chunk, a multiple of 4.
+#ifndef KEY_STREAM_CHUNK
+#define KEY_STREAM_CHUNK (1 << 20)
+#endif
+
+enum key_format {
+  KEYS_BINARY,
+  KEYS_TEXT,
+};
+
+struct key_stream;
+
+// Starts reading fd. The stream doesn't close fd. NULL if there wasn't enough memory or the thread couldn't start.
+struct key_stream *
+open_key_stream(int fd, enum key_format format);
+
+// Stops the reader and frees everything. A reader stuck in read() on a pipe has to get something (or EOF) first.
+void
+close_key_stream(struct key_stream *stream);
+
+// Parses up to max keys into keys. Returns how many, less than max only once the stream is over (or broken).
+size_t
+next_keys(struct key_stream *stream, unsigned int *keys, size_t max);
+
+// 0, an errno from read(), or EINVAL for input that isn't in the format.
+int
+key_stream_error(struct key_stream *stream);
+
+// Bytes of input parsed so far, counted a chunk at a time.
+size_t
+key_stream_bytes(const struct key_stream *stream);
+
+#endif
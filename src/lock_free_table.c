@@ -0,0 +1,290 @@
+#include "lock_free_table.h"
+
+#include <sched.h>
+#include <string.h>
+
+#include "hash_table_helper.h"
+#include "table_alloc.h"
+
+// REVIVED is INSERTED into a tombstone.
+enum claim { INSERTED, REVIVED, PRESENT, FROZEN, TOO_FAR };
+
+static inline size_t
+slots_bytes(size_t size) {
+  return sizeof(struct lock_free_slots) + size * sizeof(struct lock_free_slot);
+}
+
+static struct lock_free_slots *
+new_slots(uint8_t mersenne_prime_power) {
+  size_t size = (1ULL << mersenne_prime_power) - 1;
+  // Zeroed: every key is DEFAULT_KEY, every state 0, next NULL.
+  struct lock_free_slots *slots = table_alloc(slots_bytes(size));
+  if (!slots) return NULL;
+  slots->size = size;
+  slots->mersenne_prime_power = mersenne_prime_power;
+  return slots;
+}
+
+static void
+free_slots(struct lock_free_slots *slots) {
+  table_free(slots, slots_bytes(slots->size));
+}
+
+struct lock_free_table *
+new_lock_free_table(uint8_t mersenne_prime_power) {
+  struct lock_free_table *table = aligned_alloc(_Alignof(struct lock_free_table), sizeof *table);
+  struct lock_free_slots *slots = new_slots(mersenne_prime_power);
+  // Sadly malloc can fail.
+  if (!table || !slots) goto error;
+
+  memset(table, 0, sizeof *table);
+  atomic_init(&table->slots, slots);
+  return table;
+
+error:
+  free(table);
+  if (slots) free_slots(slots);
+  return NULL;
+}
+
+void
+delete_lock_free_table(struct lock_free_table *table) {
+  struct lock_free_slots *slots = atomic_load(&table->slots);
+  // A copy nobody finished, can only happen if a thread went away in the middle of one.
+  struct lock_free_slots *next = atomic_load(&slots->next);
+  if (next) free_slots(next);
+  free_slots(slots);
+  free(table);
+}
+
+/*
+ * Counting threads in and out.
+ */
+
+static atomic_uint next_shard;
+static _Thread_local int thread_shard = -1;
+
+static inline struct lock_free_shard *
+enter(struct lock_free_table *table) {
+  if (thread_shard < 0) thread_shard = atomic_fetch_add(&next_shard, 1) % LOCK_FREE_SHARDS;
+  struct lock_free_shard *shard = &table->shards[thread_shard];
+  // seq_cst, it has to be visible before we load the slots pointer.
+  atomic_fetch_add(&shard->entered, 1);
+  return shard;
+}
+
+static inline void
+leave(struct lock_free_shard *shard) {
+  atomic_fetch_add_explicit(&shard->left, 1, memory_order_release);
+}
+
+// Returns once everyone who was inside an operation when this was called has left it. Call it outside of one.
+static void
+wait_for_readers(struct lock_free_table *table) {
+  for (size_t i = 0; i < LOCK_FREE_SHARDS; ++i) {
+    size_t entered = atomic_load(&table->shards[i].entered);
+    while (atomic_load(&table->shards[i].left) < entered) sched_yield();
+  }
+}
+
+static int64_t
+sum_tombstones(struct lock_free_table *table) {
+  int64_t tombstones = 0;
+  for (size_t i = 0; i < LOCK_FREE_SHARDS; ++i)
+    tombstones += atomic_load_explicit(&table->shards[i].tombstones, memory_order_relaxed);
+  return tombstones;
+}
+
+size_t
+lock_free_count(struct lock_free_table *table) {
+  int64_t count = 0;
+  for (size_t i = 0; i < LOCK_FREE_SHARDS; ++i)
+    count += atomic_load_explicit(&table->shards[i].count, memory_order_relaxed);
+  return count > 0 ? (size_t)count : 0;
+}
+
+/*
+ * Slots.
+ */
+
+static inline size_t
+next_index(const struct lock_free_slots *slots, size_t index) {
+  return ++index == slots->size ? 0 : index;
+}
+
+// Claims key's slot (or finds it) within limit probes and makes it live.
+static enum claim
+claim_slot(struct lock_free_slots *slots, unsigned int key, size_t limit) {
+  size_t index = hash_bin_index(key, slots->mersenne_prime_power);
+  for (size_t probes = 0; probes < limit; ++probes, index = next_index(slots, index)) {
+    struct lock_free_slot *slot = &slots->slots[index];
+    uint32_t found = atomic_load_explicit(&slot->key, memory_order_acquire);
+    bool claimed = found == DEFAULT_KEY && atomic_compare_exchange_strong(&slot->key, &found, key);
+    // Someone else's key (maybe just now), keep going.
+    if (!claimed && found != key) continue;
+
+    // 0 is a key nobody has made live yet, maybe whoever claimed it is still on the way. Don't return before it's live,
+    // or our own lookup right after could miss it. Whoever makes it live inserted it, and only a real tombstone counts
+    // as REVIVED, so count and tombstones stay right.
+    uint32_t state = atomic_load_explicit(&slot->state, memory_order_acquire);
+    for (;;) {
+      if (state & SLOT_FROZEN) return FROZEN;
+      if (state & SLOT_LIVE) return PRESENT;
+      uint32_t was = state;
+      if (atomic_compare_exchange_weak(&slot->state, &state, SLOT_LIVE)) return was ? REVIVED : INSERTED;
+    }
+  }
+  return TOO_FAR;
+}
+
+// The slot holding key, or NULL. Keys never move within the same slots, so whatever's found stays key's slot.
+static struct lock_free_slot *
+find_slot(struct lock_free_slots *slots, unsigned int key) {
+  size_t index = hash_bin_index(key, slots->mersenne_prime_power);
+  for (size_t probes = 0; probes < slots->size; ++probes, index = next_index(slots, index)) {
+    uint32_t found = atomic_load_explicit(&slots->slots[index].key, memory_order_acquire);
+    if (found == key) return &slots->slots[index];
+    if (found == DEFAULT_KEY) return NULL;
+  }
+  return NULL;
+}
+
+/*
+ * Rehashing.
+ */
+
+// Only migrating threads write to the new slots, and they all copy different keys, so nobody ever finds their key
+// there already.
+static void
+copy_key(struct lock_free_slots *slots, unsigned int key) {
+  size_t index = hash_bin_index(key, slots->mersenne_prime_power);
+  for (;; index = next_index(slots, index)) {
+    uint32_t empty = DEFAULT_KEY;
+    if (atomic_compare_exchange_strong(&slots->slots[index].key, &empty, key)) break;
+  }
+  atomic_store_explicit(&slots->slots[index].state, SLOT_LIVE, memory_order_release);
+}
+
+static void
+migrate_chunk(struct lock_free_slots *old, struct lock_free_slots *next, size_t chunk) {
+  size_t end = (chunk + 1) * LOCK_FREE_MIGRATE_CHUNK;
+  if (end > old->size) end = old->size;
+  for (size_t i = chunk * LOCK_FREE_MIGRATE_CHUNK; i < end; ++i) {
+    // From here on the slot says what it says, writes to it fail.
+    uint32_t state = atomic_fetch_or(&old->slots[i].state, SLOT_FROZEN);
+    if (state & SLOT_LIVE) copy_key(next, atomic_load_explicit(&old->slots[i].key, memory_order_acquire));
+  }
+}
+
+// Copies chunks until there are none left, then waits for the others to finish theirs. Returns true if it was this
+// thread that switched the table over, then it's up to it to free the old slots.
+static bool
+help_migrate(struct lock_free_table *table, struct lock_free_slots *old) {
+  struct lock_free_slots *next = atomic_load(&old->next);
+  size_t chunks = (old->size + LOCK_FREE_MIGRATE_CHUNK - 1) / LOCK_FREE_MIGRATE_CHUNK;
+
+  for (size_t chunk; (chunk = atomic_fetch_add(&old->chunks_claimed, 1)) < chunks;) {
+    migrate_chunk(old, next, chunk);
+    atomic_fetch_add(&old->chunks_done, 1);
+  }
+  while (atomic_load(&old->chunks_done) < chunks) sched_yield();
+
+  // No tombstones in there, and nobody can delete anything in them before they take over. Set before they do, so no
+  // one ever sees the slots without it.
+  int64_t unset = -1;
+  atomic_compare_exchange_strong(&next->tombstone_base, &unset, sum_tombstones(table));
+  return atomic_compare_exchange_strong(&table->slots, &old, next);
+}
+
+// Returns false if there's nothing a rehash would fix.
+static bool
+start_rehash(struct lock_free_table *table, struct lock_free_slots *old) {
+  if (atomic_load(&old->next)) return true;
+
+  // Grow if over a third of the slots are live. Linear probing gets runs longer than LOCK_FREE_REPROBE_LIMIT somewhere
+  // around half full, so a third leaves room before the next rehash.
+  uint8_t power = old->mersenne_prime_power;
+  if (3 * lock_free_count(table) > old->size && power < LOCK_FREE_MAX_POWER) {
+    power++;
+  } else if (sum_tombstones(table) - atomic_load(&old->tombstone_base) < LOCK_FREE_MAX_TOMBSTONE_FACTOR * old->size) {
+    // Otherwise only once there are enough tombstones, same as open_addressing.c. A long run of live keys (like a range
+    // of consecutive ones, see hash_bin_index) is just as long in new slots, and copying everything again every few
+    // inserts would be way worse than walking it.
+    return false;
+  }
+
+  struct lock_free_slots *next = new_slots(power);
+  // Not being able to rehash isn't fatal, probes just get longer.
+  if (!next) return false;
+  // Whoever's done copying first sets it.
+  atomic_init(&next->tombstone_base, -1);
+  struct lock_free_slots *expected = NULL;
+  // Someone else got here first.
+  if (!atomic_compare_exchange_strong(&old->next, &expected, next)) free_slots(next);
+  return true;
+}
+
+// The slots to change the table in, helping out with a rehash first if one is going on.
+static struct lock_free_slots *
+current_slots(struct lock_free_table *table, struct lock_free_shard **shard) {
+  for (;;) {
+    struct lock_free_slots *slots = atomic_load(&table->slots);
+    if (!atomic_load(&slots->next)) return slots;
+
+    if (help_migrate(table, slots)) {
+      // Ours to free, once everyone is done with them. Which includes us.
+      leave(*shard);
+      wait_for_readers(table);
+      free_slots(slots);
+      *shard = enter(table);
+    }
+  }
+}
+
+void
+lock_free_insert_key(struct lock_free_table *table, unsigned int key) {
+  if (key == DEFAULT_KEY) return;
+
+  struct lock_free_shard *shard = enter(table);
+  for (;;) {
+    struct lock_free_slots *slots = current_slots(table, &shard);
+    enum claim claim = claim_slot(slots, key, LOCK_FREE_REPROBE_LIMIT);
+    if (claim == TOO_FAR && !start_rehash(table, slots)) claim = claim_slot(slots, key, slots->size);
+
+    if (claim == INSERTED || claim == REVIVED) atomic_fetch_add_explicit(&shard->count, 1, memory_order_relaxed);
+    if (claim == REVIVED) atomic_fetch_sub_explicit(&shard->tombstones, 1, memory_order_relaxed);
+    // Frozen or too far with a rehash on the way, try again in the new slots. Too far without one means the table is
+    // full, nothing to be done then :shrug:
+    if (claim != FROZEN && !(claim == TOO_FAR && atomic_load(&slots->next))) break;
+  }
+  leave(shard);
+}
+
+bool
+lock_free_contains_key(struct lock_free_table *table, unsigned int key) {
+  struct lock_free_shard *shard = enter(table);
+  // A frozen slot is as good as any, nothing changes it until the copy is done.
+  struct lock_free_slot *slot = find_slot(atomic_load(&table->slots), key);
+  bool found = slot && (atomic_load_explicit(&slot->state, memory_order_acquire) & SLOT_LIVE);
+  leave(shard);
+  return found;
+}
+
+void
+lock_free_delete_key(struct lock_free_table *table, unsigned int key) {
+  struct lock_free_shard *shard = enter(table);
+  for (;;) {
+    struct lock_free_slot *slot = find_slot(current_slots(table, &shard), key);
+    if (!slot) break;
+
+    uint32_t state = SLOT_LIVE;
+    if (atomic_compare_exchange_strong(&slot->state, &state, SLOT_DELETED)) {
+      atomic_fetch_sub_explicit(&shard->count, 1, memory_order_relaxed);
+      atomic_fetch_add_explicit(&shard->tombstones, 1, memory_order_relaxed);
+      break;
+    }
+    // Already deleted, fine. Frozen, try again in the new slots.
+    if (!(state & SLOT_FROZEN)) break;
+  }
+  leave(shard);
+}
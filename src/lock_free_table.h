@@ -0,0 +1,109 @@
+#ifndef LOCK_FREE_TABLE_H
+#define LOCK_FREE_TABLE_H
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+/*
+ * Open addressing that many threads can use without any locks.
+ *
+ * A slot is a key and a state. The key starts out as DEFAULT_KEY (0, same as hash_table.h) and is claimed with a
+ * compare and swap, after which it never changes. Whether the key is in the table is the SLOT_LIVE bit of the state.
+ * Deleting swaps it for SLOT_DELETED and the slot stays a tombstone: the key is still there for probing past, and
+ * inserting the key again swaps the bits back. Two threads inserting the same key walk the same probe sequence, so they
+ * end up at the same slot. Whichever of them swaps the state from 0 to SLOT_LIVE first inserted it, the other finds
+ * it present. That needn't be the one that claimed the key, neither returns before the key is live.
+ *
+ * Lookups are a plain walk, no compare and swap, no lock.
+ *
+ * Tombstones only go away when the slots get copied into new ones (a rehash), which also happens to be how the table
+ * grows. An insert that walks further than LOCK_FREE_REPROBE_LIMIT slots starts one: to the next power if more than a
+ * third of the slots are live, otherwise the same size without the tombstones once they're past
+ * LOCK_FREE_MAX_TOMBSTONE_FACTOR of the slots. The copy is cooperative. Every thread that wants to change the table
+ * while it's going on claims chunks of LOCK_FREE_MIGRATE_CHUNK old slots and copies them before doing what it came for
+ * in the new slots. Copying a slot freezes it first (SLOT_FROZEN), so a write that comes too late fails its compare
+ * and swap and moves on. Lookups never help, frozen slots still say what they said. That's the one place a thread can
+ * end up waiting on another: nobody writes to the new slots until every chunk is in.
+ *
+ * Unlike open_addressing.c, an insert can't reuse another key's tombstone (a lookup for that key could be walking past
+ * it). With random keys that's fine, but churning through consecutive keys (one long run with identity
+ * hash_bin_index) means walking all of its tombstones until the next rehash.
+ *
+ * The old slots can't be freed while someone is still reading them. Every operation counts itself in and out on one
+ * of LOCK_FREE_SHARDS counters (one per thread, until there are more threads than that), each on its own cache line,
+ * and whoever switches the table over waits until everyone who was in has come out.
+ *
+ * Key 0 can't be inserted.
+ */
+
+// Same as hash_table.h, without pulling in its struct hash_table.
+#ifndef DEFAULT_KEY
+#define DEFAULT_KEY (unsigned int)0
+#endif
+
+#define LOCK_FREE_REPROBE_LIMIT 64
+// Same as open_addressing.h's DEFAULT_MAX_TOMBSTONE_FACTOR.
+#define LOCK_FREE_MAX_TOMBSTONE_FACTOR 0.2
+#define LOCK_FREE_MIGRATE_CHUNK 4096
+#define LOCK_FREE_SHARDS 64
+#define LOCK_FREE_MAX_POWER 32
+
+#define SLOT_LIVE 1u
+#define SLOT_FROZEN 2u
+#define SLOT_DELETED 4u
+
+struct lock_free_slot {
+  _Atomic uint32_t key;
+  _Atomic uint32_t state;
+};
+
+struct lock_free_slots {
+  size_t size;
+  uint8_t mersenne_prime_power;
+  // Set while the slots are being copied into these.
+  _Atomic(struct lock_free_slots *) next;
+  atomic_size_t chunks_claimed;
+  atomic_size_t chunks_done;
+  // The shards' tombstone count when these slots took over, the tombstones in here are what it went up by since. -1
+  // until the copy into them is done.
+  _Atomic int64_t tombstone_base;
+  struct lock_free_slot slots[];
+};
+
+struct lock_free_shard {
+  // Operations that started and finished on this shard, one thread's own line unless there are a lot of threads.
+  _Alignas(64) atomic_size_t entered;
+  atomic_size_t left;
+  // Inserts minus deletes done by those, summed up for the live count. Same for tombstones.
+  _Atomic int64_t count;
+  _Atomic int64_t tombstones;
+};
+
+struct lock_free_table {
+  _Atomic(struct lock_free_slots *) slots;
+  struct lock_free_shard shards[LOCK_FREE_SHARDS];
+};
+
+struct lock_free_table *
+new_lock_free_table(uint8_t mersenne_prime_power);
+
+// Nobody else can be using the table by now.
+void
+delete_lock_free_table(struct lock_free_table *table);
+
+void
+lock_free_insert_key(struct lock_free_table *table, unsigned int key);
+
+bool
+lock_free_contains_key(struct lock_free_table *table, unsigned int key);
+
+void
+lock_free_delete_key(struct lock_free_table *table, unsigned int key);
+
+// Only exact while no one's inserting or deleting.
+size_t
+lock_free_count(struct lock_free_table *table);
+
+#endif
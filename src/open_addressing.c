@@ -1,59 +1,433 @@
 #include "open_addressing.h"
+#include <stdint.h>
+#include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/mman.h>
 #include "hash_table_helper.h"
+#include "table_alloc.h"
+
+/*
+ * Probing strategies. Each one is a bit of per key setup, done once before the loop, and a step from probe i to probe
+ * i + 1. No % in the loop, indexes stay below size by subtracting it (a step is never more than size).
+ *
+ * - Linear: home, home + 1, home + 2, ...
+ * - Triangular: home, home + 1, home + 3, home + 6, ... (quadratic, i(i + 1) / 2).
+ * - Double hashing: home, home + step, home + 2 step, ... with step from a second (multiply-shift) hash of the key.
+ *
+ * Triangular only hits every bin for power of two sizes (INDEX_FIBONACCI), and double hashing only when step and size
+ * are coprime (always the case when 2^s - 1 is prime, but 2^20 - 1 = 3 * 5^2 * 11 * 31 * 41, and for power of two
+ * sizes the step is made odd). So those two get a second pass over all the bins, in order, after their own size probes.
+ * Inserts and lookups both follow it, so keys that land there are found again. It only comes up when everything the
+ * strategy can reach is taken, i.e. tiny or completely full tables.
+ */
+#define LINEAR_SETUP(hash, size, s)
+#define LINEAR_NEXT(index, i, size) index = (index + 1 == size) ? 0 : index + 1
+#define LINEAR_COVERS_ALL_BINS 1
+
+#define TRIANGULAR_SETUP(hash, size, s)
+#define TRIANGULAR_NEXT(index, i, size)                                                                              \
+    do {                                                                                                             \
+        index += i + 1;                                                                                              \
+        if (index >= size) index -= size;                                                                            \
+    } while (0)
+#define TRIANGULAR_COVERS_ALL_BINS 0
+
+#define DOUBLE_HASHING_SETUP(hash, size, s)                                                                          \
+    size_t step = reduce_index(((uint64_t)(hash) * 0x9E3779B97F4A7C15ULL) >> 32, mode, s, size);                     \
+    if (mode == INDEX_FIBONACCI) step |= 1;                                                                          \
+    if (!step) step = 1;
+#define DOUBLE_HASHING_NEXT(index, i, size)                                                                          \
+    do {                                                                                                             \
+        index += step;                                                                                               \
+        if (index >= size) index -= size;                                                                            \
+    } while (0)
+#define DOUBLE_HASHING_COVERS_ALL_BINS 0
+
+#ifdef WITH_METRICS
+#define COUNT_COLLISION(table) (table)->collisions++
+#else
+#define COUNT_COLLISION(table)
+#endif
+
+// Loop bodies for the probe loops below, they return from the generated function.
+#define FIND_BIN_STEP(index)                                                                                         \
+    {                                                                                                                \
+        const struct bin *bin = &bins[index];                                                                        \
+        if (!bin->is_used) return size;                                                                              \
+        if (!bin->is_deleted && bin->key == key) return index;                                                       \
+    }
+
+#define PROBE_FOR_INSERT_STEP(index)                                                                                 \
+    {                                                                                                                \
+        struct bin *bin = &table->table[index];                                                                      \
+        if (!bin->is_used) return target == size ? index : target;                                                   \
+        if (bin->is_deleted) {                                                                                       \
+            /* Reuse the first tombstone, but keep going, the key might still be further along. */                   \
+            if (target == size) target = index;                                                                      \
+        } else if (bin->key == key) {                                                                                \
+            *found = true;                                                                                           \
+            return index;                                                                                            \
+        } else {                                                                                                     \
+            /* It's occupied by someone else -> Collision */                                                         \
+            COUNT_COLLISION(table);                                                                                  \
+        }                                                                                                            \
+    }
+
+/*
+ * Generates the two probe loops for a strategy:
+ *
+ * Both take key and its hash_key, hashed once by the caller since it's the same for the old and the new bins.
+ *
+ * find_bin_<name> returns the index of the bin holding key, or size if it's not in there.
+ *
+ * probe_for_insert_<name> walks key's probe sequence in the current bins. If the key is there, returns its bin and sets
+ * *found. Otherwise returns the first free or deleted bin, i.e. where the key should go (table->size if there's no
+ * such bin).
+ */
+#define DEFINE_PROBING(name, PREFIX)                                                                                 \
+    static inline size_t find_bin_##name(const struct bin *bins, size_t size, uint8_t s, enum index_mode mode,       \
+                                         unsigned int key, uint64_t hash)                                            \
+    {                                                                                                                \
+        PREFIX##_SETUP(hash, size, s)                                                                                \
+        size_t index = reduce_index(hash, mode, s, size);                                                            \
+        for (size_t i = 0; i < size; ++i) {                                                                          \
+            FIND_BIN_STEP(index)                                                                                     \
+            PREFIX##_NEXT(index, i, size);                                                                           \
+        }                                                                                                            \
+        if (!PREFIX##_COVERS_ALL_BINS) {                                                                             \
+            for (index = 0; index < size; ++index) FIND_BIN_STEP(index)                                              \
+        }                                                                                                            \
+        return size;                                                                                                 \
+    }                                                                                                                \
+                                                                                                                     \
+    static inline size_t probe_for_insert_##name(struct hash_table *table, size_t size, uint8_t s,                  \
+                                                 enum index_mode mode, unsigned int key, uint64_t hash, bool *found) \
+    {                                                                                                                \
+        size_t target = size;                                                                                        \
+        *found = false;                                                                                              \
+        PREFIX##_SETUP(hash, size, s)                                                                                \
+        size_t index = reduce_index(hash, mode, s, size);                                                            \
+        for (size_t i = 0; i < size; ++i) {                                                                          \
+            PROBE_FOR_INSERT_STEP(index)                                                                             \
+            PREFIX##_NEXT(index, i, size);                                                                           \
+        }                                                                                                            \
+        if (!PREFIX##_COVERS_ALL_BINS) {                                                                             \
+            for (index = 0; index < size; ++index) PROBE_FOR_INSERT_STEP(index)                                      \
+        }                                                                                                            \
+        return target;                                                                                               \
+    }
 
-// Define this if you want to use LINEAR_PROBING, otherwise DOUBLE_HASHING
-#define LINEAR_PROBING
+DEFINE_PROBING(linear, LINEAR)
+DEFINE_PROBING(triangular, TRIANGULAR)
+DEFINE_PROBING(double_hashing, DOUBLE_HASHING)
 
+/*
+ * Which loops a table uses, picked whenever its size changes (see pick_ops). The generic ones take everything from
+ * their arguments and switch on the probing strategy once per call.
+ */
+struct probe_ops {
+    size_t (*find_bin)(const struct bin *bins, size_t size, uint8_t s, enum index_mode mode, enum probing probing,
+                       unsigned int key, uint64_t hash);
+    size_t (*probe_for_insert)(struct hash_table *table, unsigned int key, uint64_t hash, bool *found);
+};
 
-#ifdef LINEAR_PROBING
-// Linear probing with Mersenne Prime Modulo
-// Index = (k + i) % M
-static unsigned int
-p(unsigned int k, unsigned int i, uint8_t s)
+static size_t
+find_bin_generic(const struct bin *bins, size_t size, uint8_t s, enum index_mode mode, enum probing probing,
+                 unsigned int key, uint64_t hash)
 {
-    return (unsigned int)hash_bin_index(k + i, s);
+    switch (probing) {
+    case PROBE_TRIANGULAR:
+        return find_bin_triangular(bins, size, s, mode, key, hash);
+    case PROBE_DOUBLE_HASHING:
+        return find_bin_double_hashing(bins, size, s, mode, key, hash);
+    default:
+        return find_bin_linear(bins, size, s, mode, key, hash);
+    }
 }
-#else
-// Double hashing with Mersenne Prime Modulo
-// Index = (h1(k) + i * h2(k)) % M
-static unsigned int
-p(unsigned int k, unsigned int i, uint8_t s)
-{
-    unsigned int h1 = k;
-    unsigned int h2 = (k << 1) | 1;
-    // We can use the property that (a + b) % M = ((a % M) + (b % M)) % M
-    // But hash_bin_index takes any uint64_t and mods it by (2^s - 1).
-    // So we can just pass the sum/product directly if it fits in 64 bits.
-    // However, h1 + i*h2 can overflow 32-bit int, but fits in 64-bit easily.
-    return (unsigned int)hash_bin_index((uint64_t)h1 + (uint64_t)i * h2, s);
+
+static size_t
+probe_for_insert_generic(struct hash_table *table, unsigned int key, uint64_t hash, bool *found)
+{
+    size_t size = table->size;
+    uint8_t s = table->mersenne_prime_power;
+    enum index_mode mode = table->index_mode;
+    switch (table->probing) {
+    case PROBE_TRIANGULAR:
+        return probe_for_insert_triangular(table, size, s, mode, key, hash, found);
+    case PROBE_DOUBLE_HASHING:
+        return probe_for_insert_double_hashing(table, size, s, mode, key, hash, found);
+    default:
+        return probe_for_insert_linear(table, size, s, mode, key, hash, found);
+    }
 }
+
+static const struct probe_ops generic_ops = {find_bin_generic, probe_for_insert_generic};
+
+/*
+ * The common case, Mersenne sizes with linear probing, gets a copy of both loops for every power from 16 to 32, with s
+ * and the size as constants. hash_bin_index's shift and mask become immediates and the wraparound compares against a
+ * constant instead of a register. Build with -DWITHOUT_SPECIALIZED_POWERS to always use the generic loops.
+ */
+#define MIN_SPECIALIZED_POWER 16
+#define MAX_SPECIALIZED_POWER 32
+
+#define SPECIALIZE_POWER(S)                                                                                          \
+    static size_t find_bin_mersenne_##S(const struct bin *bins, size_t size, uint8_t s, enum index_mode mode,        \
+                                        enum probing probing, unsigned int key, uint64_t hash)                       \
+    {                                                                                                                \
+        (void)size, (void)s, (void)mode, (void)probing;                                                              \
+        return find_bin_linear(bins, (1ULL << S) - 1, S, INDEX_MERSENNE, key, hash);                                 \
+    }                                                                                                                \
+                                                                                                                     \
+    static size_t probe_for_insert_mersenne_##S(struct hash_table *table, unsigned int key, uint64_t hash,           \
+                                                bool *found)                                                         \
+    {                                                                                                                \
+        return probe_for_insert_linear(table, (1ULL << S) - 1, S, INDEX_MERSENNE, key, hash, found);                 \
+    }
+
+#define POWER_OPS(S) [S - MIN_SPECIALIZED_POWER] = {find_bin_mersenne_##S, probe_for_insert_mersenne_##S}
+
+#ifndef WITHOUT_SPECIALIZED_POWERS
+SPECIALIZE_POWER(16)
+SPECIALIZE_POWER(17)
+SPECIALIZE_POWER(18)
+SPECIALIZE_POWER(19)
+SPECIALIZE_POWER(20)
+SPECIALIZE_POWER(21)
+SPECIALIZE_POWER(22)
+SPECIALIZE_POWER(23)
+SPECIALIZE_POWER(24)
+SPECIALIZE_POWER(25)
+SPECIALIZE_POWER(26)
+SPECIALIZE_POWER(27)
+SPECIALIZE_POWER(28)
+SPECIALIZE_POWER(29)
+SPECIALIZE_POWER(30)
+SPECIALIZE_POWER(31)
+SPECIALIZE_POWER(32)
+
+static const struct probe_ops specialized_ops[] = {
+    POWER_OPS(16), POWER_OPS(17), POWER_OPS(18), POWER_OPS(19), POWER_OPS(20), POWER_OPS(21),
+    POWER_OPS(22), POWER_OPS(23), POWER_OPS(24), POWER_OPS(25), POWER_OPS(26), POWER_OPS(27),
+    POWER_OPS(28), POWER_OPS(29), POWER_OPS(30), POWER_OPS(31), POWER_OPS(32),
+};
 #endif
 
+static const struct probe_ops *
+pick_ops(enum index_mode mode, enum probing probing, uint8_t power)
+{
+#ifndef WITHOUT_SPECIALIZED_POWERS
+    if (mode == INDEX_MERSENNE && probing == PROBE_LINEAR && power >= MIN_SPECIALIZED_POWER &&
+        power <= MAX_SPECIALIZED_POWER)
+        return &specialized_ops[power - MIN_SPECIALIZED_POWER];
+#else
+    (void)mode, (void)probing, (void)power;
+#endif
+    return &generic_ops;
+}
+
+static inline size_t
+find_bin(struct hash_table *table, unsigned int key, uint64_t hash)
+{
+    return table->ops->find_bin(table->table, table->size, table->mersenne_prime_power, table->index_mode,
+                                table->probing, key, hash);
+}
+
+// Only while resizing. Returns old_size if key isn't in the old bins.
+static inline size_t
+find_old_bin(struct hash_table *table, unsigned int key, uint64_t hash)
+{
+    return table->old_ops->find_bin(table->old_table, table->old_size, table->old_mersenne_prime_power,
+                                    table->index_mode, table->probing, key, hash);
+}
+
+static inline size_t
+probe_for_insert(struct hash_table *table, unsigned int key, uint64_t hash, bool *found)
+{
+    return table->ops->probe_for_insert(table, key, hash, found);
+}
+
+static inline void
+fill_bin(struct hash_table *table, size_t index, unsigned int key)
+{
+    struct bin *bin = & table->table[index];
+    if (bin->is_deleted) table->tombstones--;
+    bin->is_used = true;
+    bin->is_deleted = false;
+    bin->key = key;
+}
+
+// Bins come from table_alloc, except a mapped table's, which are in the snapshot file until the first resize.
+static void
+free_bins(struct hash_table *table, struct bin *bins, size_t size)
+{
+    if (table->mapping && (char *)bins == (char *)table->mapping + SNAPSHOT_HEADER_SIZE) {
+        munmap(table->mapping, table->mapping_length);
+        table->mapping = NULL;
+    } else {
+        table_free(bins, size * sizeof(struct bin));
+    }
+}
+
+// Moves up to n old bins over to the new ones, and drops the old bins once they're all moved.
+static void
+migrate_bins(struct hash_table *table, size_t n)
+{
+    for (; n && table->migrated < table->old_size; n--, table->migrated++) {
+        struct bin *bin = & table->old_table[table->migrated];
+        if (!bin->is_used || bin->is_deleted) continue;
+
+        // A key is never in both tables, so no need to check for duplicates.
+        bool found;
+        size_t index = probe_for_insert(table, bin->key, hash_key(&table->hasher, bin->key), &found);
+        fill_bin(table, index, bin->key);
+        // Keys that haven't been moved yet might probe through this bin, so it has to stay "used".
+        bin->is_deleted = true;
+    }
+
+    if (table->migrated == table->old_size) {
+        free_bins(table, table->old_table, table->old_size);
+        table->old_table = NULL;
+    }
+}
+
+static void
+update_thresholds(struct hash_table *table)
+{
+    table->grow_at = (size_t)(table->max_load_factor * table->size);
+    table->cleanup_at = (size_t)(table->max_tombstone_factor * table->size);
+}
+
+// How many bins the table has at power. A fastrange table keeps the size it was created with, doubled or halved.
+static size_t
+bins_at_power(const struct hash_table *table, uint8_t power)
+{
+    if (table->index_mode != INDEX_FASTRANGE) return index_bins(table->index_mode, power);
+    uint8_t s = table->mersenne_prime_power;
+    return power >= s ? table->size << (power - s) : table->size >> (s - power);
+}
+
+// Starts moving everything into the bins for power (2^power - 1 of them for Mersenne). Same power as now just gets rid
+// of the tombstones.
+static bool
+start_resize(struct hash_table *table, uint8_t power)
+{
+    // One resize at a time. With sane factors the previous one is long done by now, otherwise finish it.
+    if (table->old_table) migrate_bins(table, SIZE_MAX);
+    // With a max_load_factor >= 1 the keys alone can outgrow the bins at power, they all have to fit.
+    while (power < MAX_MERSENNE_PRIME_POWER && table->count >= bins_at_power(table, power)) power++;
+
+    size_t size = bins_at_power(table, power);
+    // All zeroes is a free bin, see table_alloc.h.
+    struct bin *bins = (struct bin *)table_alloc(size * sizeof(struct bin));
+    if (!bins) return false;
+
+    table->old_table = table->table;
+    table->old_size = table->size;
+    table->old_mersenne_prime_power = table->mersenne_prime_power;
+    table->old_ops = table->ops;
+    table->migrated = 0;
+
+    table->table = bins;
+    table->size = size;
+    table->mersenne_prime_power = power;
+    table->ops = pick_ops(table->index_mode, table->probing, power);
+    table->tombstones = 0;
+    update_thresholds(table);
+    return true;
+}
+
+static void
+resize(struct hash_table *table)
+{
+    if (table->count > table->grow_at && table->mersenne_prime_power < MAX_MERSENNE_PRIME_POWER) {
+        start_resize(table, table->mersenne_prime_power + 1);
+    } else if (!table->old_table &&
+               (table->tombstones > table->cleanup_at || table->count + table->tombstones > table->grow_at)) {
+        // Probes go through tombstones like any other key, so they count towards the load factor too.
+        start_resize(table, table->mersenne_prime_power);
+    }
+}
+
+// The checks are on every insert/delete, keep them cheap and out of line only when there's work to do.
+static inline void
+maybe_resize(struct hash_table *table)
+{
+    if (table->count + table->tombstones > table->grow_at || table->tombstones > table->cleanup_at) resize(table);
+}
+
+static inline void
+maybe_migrate(struct hash_table *table)
+{
+    if (table->old_table) migrate_bins(table, MIGRATE_BINS_PER_OP);
+}
+
+void
+set_load_factors(struct hash_table *table, double max_load_factor, double max_tombstone_factor)
+{
+    table->max_load_factor = max_load_factor;
+    table->max_tombstone_factor = max_tombstone_factor;
+    update_thresholds(table);
+}
+
+bool
+set_hash_function(struct hash_table *table, enum hash_function function, uint64_t seed)
+{
+    // Every key would have to move.
+    if (table->count || table->old_table) return false;
+    init_hasher(&table->hasher, function, seed);
+    return true;
+}
+
 struct hash_table *
 empty_table(uint8_t mersenne_prime_power)
 {
-    struct hash_table *table =
-        (struct hash_table*)malloc(sizeof(struct hash_table));
+    return empty_table_with_probing(mersenne_prime_power, DEFAULT_PROBING);
+}
 
+struct hash_table *
+empty_table_with_probing(uint8_t mersenne_prime_power, enum probing probing)
+{
     // Size M = 2^s - 1
     // We use 1ULL to ensure 64-bit shift, though size_t might be 32-bit (unlikely on modern systems but safe)
-    size_t size = (1ULL << mersenne_prime_power) - 1;
+    return empty_table_with_index((1ULL << mersenne_prime_power) - 1, INDEX_MERSENNE, probing);
+}
+
+struct hash_table *
+empty_table_with_index(size_t size, enum index_mode index_mode, enum probing probing)
+{
+    // Fastrange reduces 32 bits of hash, so that's as big as it gets. The others round up to their next size.
+    if (!size || size > (1ULL << MAX_MERSENNE_PRIME_POWER)) return NULL;
+    uint8_t mersenne_prime_power = index_power(index_mode, size);
+    if (index_mode != INDEX_FASTRANGE) size = index_bins(index_mode, mersenne_prime_power);
+
+    struct hash_table *table =
+        (struct hash_table*)malloc(sizeof(struct hash_table));
+
+    // All zeroes is a free bin, and fresh pages from the OS are zero already. No init pass, see table_alloc.h.
+    struct bin *bins = (struct bin *)table_alloc(size * sizeof(struct bin));
 
-    table->table = (struct bin *)malloc(size * sizeof(struct bin));
-    for (size_t i = 0; i < size; ++i) {
-        struct bin *bin = & table->table[i];
-        bin->is_free = true;
-        bin->is_deleted = false;
+    // Sadly malloc can fail.
+    if (!table || !bins) {
+        free(table);
+        table_free(bins, size * sizeof(struct bin));
+        return NULL;
     }
-    table->size = size;
-    table->mersenne_prime_power = mersenne_prime_power;
 
-#ifdef WITH_METRICS
-    table->collisions = 0;
-    table->count = 0;
-#endif
+    *table = (struct hash_table){
+        .table = bins,
+        .size = size,
+        .mersenne_prime_power = mersenne_prime_power,
+        .index_mode = index_mode,
+        .probing = probing,
+        .ops = pick_ops(index_mode, probing, mersenne_prime_power),
+        .count = 0,
+        .tombstones = 0,
+        .old_table = NULL,
+    };
+    set_load_factors(table, DEFAULT_MAX_LOAD_FACTOR, DEFAULT_MAX_TOMBSTONE_FACTOR);
+    init_hasher(&table->hasher, HASH_IDENTITY, 0);
 
     return table;
 }
@@ -61,93 +435,264 @@ empty_table(uint8_t mersenne_prime_power)
 void
 delete_table(struct hash_table *table)
 {
-    free(table->table);
+    free_bins(table, table->old_table, table->old_size);
+    free_bins(table, table->table, table->size);
     free(table);
 }
 
-void
-insert_key(struct hash_table *table, unsigned int key)
+// The single key operations, with key's hash_key already worked out. Shared with the batches below.
+static inline void
+insert_hashed(struct hash_table *table, unsigned int key, uint64_t hash)
 {
-    unsigned int index;
-    struct bin *bin;
-    for (size_t i = 0; i < table->size; ++i) {
-        index = p(key, i, table->mersenne_prime_power);
-        bin = & table->table[index];
+    maybe_migrate(table);
 
-#ifdef WITH_METRICS
-        if (!bin->is_free && !bin->is_deleted && bin->key != key) {
-            // It's occupied by someone else -> Collision
-            table->collisions++;
-        }
-#endif
+    // Not moved over yet, but it's in there.
+    if (table->old_table && find_old_bin(table, key, hash) != table->old_size)
+        return;
+    // Every key has to fit into the new bins once they're all moved over, only a max_load_factor >= 1 gets this close.
+    // Finish moving while they still do, then it's the usual full table below.
+    if (table->old_table && table->count + 1 >= table->size)
+        migrate_bins(table, SIZE_MAX);
+
+    bool found;
+    size_t index = probe_for_insert(table, key, hash, &found);
+    if (found)
+        return;
 
-        if (bin->is_free || bin->is_deleted || bin->key == key)
-            break;
+    if (index == table->size) {
+        // No room at all, which only happens if max_load_factor was set to >= 1. Nothing to do but grow right now.
+        if (table->mersenne_prime_power == MAX_MERSENNE_PRIME_POWER ||
+            !start_resize(table, table->mersenne_prime_power + 1))
+            return;
+        migrate_bins(table, SIZE_MAX);
+        index = probe_for_insert(table, key, hash, &found);
     }
-    
-    // Check if we found a spot or if it's already there
-    // If it was deleted, we are reusing it.
-    // If it was free, we are using it.
-    // If it was same key, we update (no-op here).
-    
-#ifdef WITH_METRICS
-    if (bin->is_free || bin->is_deleted) {
-        // Only increment count if we are actually taking a new slot
-        // If it was already there (bin->key == key), don't increment.
-        // BUT wait, we broke loop.
-        // If bin->key == key and !is_deleted, it's a duplicate.
-        // If bin->is_deleted, we overwrite.
-        // If bin->is_free, we write.
-        table->count++;
-    } else if (bin->key == key) {
-        // Duplicate, do nothing to count
+
+    fill_bin(table, index, key);
+    table->count++;
+
+    maybe_resize(table);
+}
+
+static inline bool
+contains_hashed(struct hash_table *table, unsigned int key, uint64_t hash)
+{
+    if (find_bin(table, key, hash) != table->size)
+        return true;
+    return table->old_table &&
+           find_old_bin(table, key, hash) != table->old_size;
+}
+
+static inline void
+delete_hashed(struct hash_table *table, unsigned int key, uint64_t hash)
+{
+    maybe_migrate(table);
+
+    size_t index = find_bin(table, key, hash);
+    if (index != table->size) {
+        table->table[index].is_deleted = true;
+        table->tombstones++;
+        table->count--;
+        maybe_resize(table);
+        return;
     }
-#endif
 
-    bin->is_free = bin->is_deleted = false;
-    bin->key = key;
+    if (table->old_table) {
+        index = find_old_bin(table, key, hash);
+        if (index != table->old_size) {
+            // The old bins are going away anyway, no need to count the tombstone.
+            table->old_table[index].is_deleted = true;
+            table->count--;
+        }
+    }
+}
+
+void
+insert_key(struct hash_table *table, unsigned int key)
+{
+    insert_hashed(table, key, hash_key(&table->hasher, key));
 }
 
 bool
 contains_key(struct hash_table *table, unsigned int key)
 {
-    for (size_t i = 0; i < table->size; ++i) {
-        unsigned int index = p(key, i, table->mersenne_prime_power);
-        struct bin *bin = & table->table[index];
-        if (bin->is_free)
-            return false;
-        if (!bin->is_deleted && bin->key == key)
-            return true;
-    }
-    return false;
+    return contains_hashed(table, key, hash_key(&table->hasher, key));
 }
 
 void
 delete_key(struct hash_table *table, unsigned int key)
 {
-    for (size_t i = 0; i < table->size; ++i) {
-        unsigned int index = p(key, i, table->mersenne_prime_power);
-        struct bin *bin = & table->table[index];
-        if (bin->is_free) return;
-        if (bin->key == key) {
-            bin->is_deleted = true;
-#ifdef WITH_METRICS
-            table->count--; // Technically we should decrease count? 
-                            // User asked to track load factor, so yes.
-            // But main.c only does insertions, so delete might not be tested. 
-            // Keeping it consistent anyway.
-#endif
-            return;
-        }
+    delete_hashed(table, key, hash_key(&table->hasher, key));
+}
+
+/*
+ * Batches. Keys are hashed and their home bins prefetched PREFETCH_DISTANCE keys ahead of the one being worked on, so
+ * by the time we get to a key its bin is (hopefully) in cache already and the misses overlap instead of coming one
+ * after the other. Linear probing mostly stays within the home bin's cache line, so that one prefetch covers most of
+ * the probe. Same result as calling the single key functions in order: if a resize moves things around in the
+ * meantime, all we lose is a useless prefetch.
+ */
+static inline uint64_t
+prefetch_home(struct hash_table *table, unsigned int key, int for_write)
+{
+    uint64_t hash = hash_key(&table->hasher, key);
+    const struct bin *home = &table->table[reduce_index(hash, table->index_mode, table->mersenne_prime_power,
+                                                        table->size)];
+    if (for_write)
+        __builtin_prefetch(home, 1);
+    else
+        __builtin_prefetch(home, 0);
+    if (table->old_table) {
+        __builtin_prefetch(&table->old_table[reduce_index(hash, table->index_mode, table->old_mersenne_prime_power,
+                                                          table->old_size)]);
     }
+    return hash;
+}
+
+// Runs `op(table, keys[i], hash, i)` for every key, with the prefetching above.
+#define FOR_EACH_PREFETCHED(table, keys, n, for_write, op)                                                           \
+    do {                                                                                                             \
+        uint64_t hashes[PREFETCH_DISTANCE];                                                                          \
+        for (size_t i = 0; i < (n) && i < PREFETCH_DISTANCE; ++i)                                                    \
+            hashes[i] = prefetch_home(table, (keys)[i], for_write);                                                  \
+        for (size_t i = 0; i < (n); ++i) {                                                                           \
+            uint64_t hash = hashes[i % PREFETCH_DISTANCE];                                                           \
+            if (i + PREFETCH_DISTANCE < (n))                                                                         \
+                hashes[i % PREFETCH_DISTANCE] = prefetch_home(table, (keys)[i + PREFETCH_DISTANCE], for_write);      \
+            op(table, (keys)[i], hash, i);                                                                           \
+        }                                                                                                            \
+    } while (0)
+
+#define INSERT_OP(table, key, hash, i) insert_hashed(table, key, hash)
+#define DELETE_OP(table, key, hash, i) delete_hashed(table, key, hash)
+#define CONTAINS_OP(table, key, hash, i)                                                                             \
+    if (contains_hashed(table, key, hash)) out_bitmap[(i) / 64] |= 1ULL << ((i) % 64)
+
+void
+insert_keys(struct hash_table *table, const unsigned int *keys, size_t n)
+{
+    FOR_EACH_PREFETCHED(table, keys, n, 1, INSERT_OP);
+}
+
+void
+contains_keys(struct hash_table *table, const unsigned int *keys, size_t n, uint64_t *out_bitmap)
+{
+    memset(out_bitmap, 0, (n + 63) / 64 * sizeof *out_bitmap);
+    FOR_EACH_PREFETCHED(table, keys, n, 0, CONTAINS_OP);
+}
+
+void
+delete_keys(struct hash_table *table, const unsigned int *keys, size_t n)
+{
+    FOR_EACH_PREFETCHED(table, keys, n, 1, DELETE_OP);
+}
+
+/*
+ * Snapshots, see open_addressing.h.
+ */
+
+bool
+save_table(struct hash_table *table, const char *path)
+{
+    // The old bins would have to go in as well, easier to finish moving them.
+    if (table->old_table)
+        migrate_bins(table, SIZE_MAX);
+
+    struct snapshot_header header = {
+        .magic = SNAPSHOT_MAGIC,
+        .version = SNAPSHOT_VERSION,
+        .bin_size = sizeof(struct bin),
+        .mersenne_prime_power = table->mersenne_prime_power,
+        .index_mode = table->index_mode,
+        .probing = table->probing,
+        .hash_function = table->hasher.function,
+        .reserved = 0,
+        .seed = table->hasher.seed,
+        .size = table->size,
+        .count = table->count,
+        .tombstones = table->tombstones,
+        .checksum = snapshot_checksum(table->table, table->size * sizeof(struct bin)),
+    };
+    return write_snapshot(path, &header, sizeof header, table->table, table->size * sizeof(struct bin));
+}
+
+static bool
+snapshot_header_ok(const struct snapshot_header *header, size_t length)
+{
+    if (header->magic != SNAPSHOT_MAGIC || header->version != SNAPSHOT_VERSION ||
+        header->bin_size != sizeof(struct bin))
+        return false;
+    if (header->index_mode > INDEX_FASTRANGE || header->probing > PROBE_DOUBLE_HASHING ||
+        header->hash_function > HASH_TABULATION || header->mersenne_prime_power > MAX_MERSENNE_PRIME_POWER)
+        return false;
+    // Fastrange tables have whatever size they were made with, the others exactly what their power says.
+    uint64_t size = header->size;
+    if (!size || size > (1ULL << header->mersenne_prime_power) ||
+        (header->index_mode != INDEX_FASTRANGE && size != index_bins(header->index_mode, header->mersenne_prime_power)))
+        return false;
+    if (header->count + header->tombstones > size)
+        return false;
+    return length == SNAPSHOT_HEADER_SIZE + size * sizeof(struct bin);
+}
+
+struct hash_table *
+map_table(const char *path)
+{
+    size_t length;
+    void *mapping = map_snapshot(path, true, &length);
+    if (!mapping)
+        return NULL;
+
+    const struct snapshot_header *header = mapping;
+    struct hash_table *table = NULL;
+    if (!snapshot_header_ok(header, length))
+        goto error;
+    table = (struct hash_table *)malloc(sizeof *table);
+    // Sadly malloc can fail.
+    if (!table)
+        goto error;
+
+    *table = (struct hash_table){
+        .table = (struct bin *)((char *)mapping + SNAPSHOT_HEADER_SIZE),
+        .size = header->size,
+        .mersenne_prime_power = header->mersenne_prime_power,
+        .index_mode = (enum index_mode)header->index_mode,
+        .probing = (enum probing)header->probing,
+        .ops = pick_ops(header->index_mode, header->probing, header->mersenne_prime_power),
+        .count = header->count,
+        .tombstones = header->tombstones,
+        .old_table = NULL,
+        .mapping = mapping,
+        .mapping_length = length,
+    };
+    set_load_factors(table, DEFAULT_MAX_LOAD_FACTOR, DEFAULT_MAX_TOMBSTONE_FACTOR);
+    init_hasher(&table->hasher, (enum hash_function)header->hash_function, header->seed);
+    return table;
+
+error:
+    munmap(mapping, length);
+    return NULL;
+}
+
+bool
+verify_snapshot(const struct hash_table *table)
+{
+    if (!table->mapping)
+        return false;
+    const struct snapshot_header *header = table->mapping;
+    return snapshot_checksum(table->table, table->size * sizeof(struct bin)) == header->checksum;
 }
 
 #ifdef WITH_METRICS
-#include <stdio.h>
 void
 print_metrics(struct hash_table *table) {
     printf("Total stats:\n");
     printf("     Count: %zu\n", table->count);
     printf("Collisions: %zu\n", table->collisions);
+    printf("Tombstones: %zu\n", table->tombstones);
+    if (table->index_mode == INDEX_MERSENNE)
+        printf("      Bins: %zu (2^%u - 1)\n", table->size, table->mersenne_prime_power);
+    else
+        printf("      Bins: %zu (%s)\n", table->size, index_mode_name(table->index_mode));
 }
 #endif
@@ -2,29 +2,106 @@
 #define OPEN_ADDRESSING_H
 
 #include <stdbool.h>
+#include <stdint.h>
 #include <stdlib.h>
 
+#include "hash_table_helper.h"
+#include "snapshot.h"
+
+// All zeroes is a free bin, so a freshly calloc'd array needs no init pass.
 struct bin {
-  int is_free : 1;
-  int is_deleted : 1;
+  unsigned int is_used : 1;
+  unsigned int is_deleted : 1;
   unsigned int key;
 };
 
+/*
+ * Resizing.
+ *
+ * Once count / size goes over max_load_factor the table moves to the next Mersenne power, and once tombstones / size
+ * goes over max_tombstone_factor (or keys + tombstones go over max_load_factor) it's rebuilt at the same size without
+ * the tombstones. Either way the new bins are allocated up front but the keys are moved over a few old bins at a time
+ * (MIGRATE_BINS_PER_OP) on every insert/delete, so no single operation pays for the whole rehash. Until it's done a key
+ * is either in the old bins or the new ones, never both.
+ */
+#define DEFAULT_MAX_LOAD_FACTOR 0.9
+#define DEFAULT_MAX_TOMBSTONE_FACTOR 0.2
+#define MAX_MERSENNE_PRIME_POWER 32
+#ifndef MIGRATE_BINS_PER_OP
+#define MIGRATE_BINS_PER_OP 8
+#endif
+
+/*
+ * Probing strategies, picked per table with empty_table_with_probing. Each one has its own probe loop in
+ * open_addressing.c, so picking one doesn't cost anything per probe.
+ */
+enum probing {
+  PROBE_LINEAR,
+  PROBE_TRIANGULAR,
+  PROBE_DOUBLE_HASHING,
+};
+
+// What empty_table uses.
+#ifndef DEFAULT_PROBING
+#define DEFAULT_PROBING PROBE_LINEAR
+#endif
+
+// The probe loops a table uses, see open_addressing.c.
+struct probe_ops;
+
 struct hash_table {
   struct bin *table;
   size_t size;
+  // s, see hash_table_helper.h. 2^s - 1 bins unless the table was made with another index mode.
   uint8_t mersenne_prime_power;
+  enum index_mode index_mode;
+  enum probing probing;
+  // Picked for the current size, loops specialized for it if there are any.
+  const struct probe_ops *ops;
+  size_t count;
+  size_t tombstones;
+  // Set through set_load_factors, which also works out the two thresholds below for the current size.
+  double max_load_factor;
+  double max_tombstone_factor;
+  size_t grow_at;
+  size_t cleanup_at;
+  // Only set while a resize is in progress. Old bins below `migrated` have been moved over.
+  struct bin *old_table;
+  size_t old_size;
+  uint8_t old_mersenne_prime_power;
+  const struct probe_ops *old_ops;
+  size_t migrated;
+  // Only set for a table from map_table, the whole file, until its bins are resized away. The bins are in there,
+  // copy on write.
+  void *mapping;
+  size_t mapping_length;
 #ifdef WITH_METRICS
   size_t collisions;
-  size_t count;
 #endif
+  // Last, the tabulation tables are 4 KB and would push everything else apart.
+  struct hasher hasher;
 };
 
 struct hash_table *
 empty_table(uint8_t mersenne_prime_power);
+struct hash_table *
+empty_table_with_probing(uint8_t mersenne_prime_power, enum probing probing);
+// A table with (at least) size bins, reduced to a bin by index_mode (see hash_table_helper.h). INDEX_FASTRANGE gets
+// exactly size bins, up to 2^32. Growing doubles the size in every mode.
+struct hash_table *
+empty_table_with_index(size_t size, enum index_mode index_mode, enum probing probing);
 void
 delete_table(struct hash_table *table);
 
+// Passing max_load_factor >= 1 turns growing off (the table still grows once it's completely full).
+void
+set_load_factors(struct hash_table *table, double max_load_factor, double max_tombstone_factor);
+
+// What keys go through ahead of hash_bin_index (see hash_table_helper.h), HASH_IDENTITY by default. Only works while the
+// table is empty, returns false otherwise.
+bool
+set_hash_function(struct hash_table *table, enum hash_function function, uint64_t seed);
+
 void
 insert_key(struct hash_table *table, unsigned int key);
 bool
@@ -32,6 +109,88 @@ contains_key(struct hash_table *table, unsigned int key);
 void
 delete_key(struct hash_table *table, unsigned int key);
 
+/*
+ * The same, n keys at a time. Bins are prefetched PREFETCH_DISTANCE keys ahead, so on tables way bigger than the cache
+ * the misses overlap instead of being waited for one by one. contains_keys sets bit i of out_bitmap (room for n bits,
+ * 64 per word) if keys[i] is in the table and clears it otherwise.
+ */
+#ifndef PREFETCH_DISTANCE
+#define PREFETCH_DISTANCE 16
+#endif
+
+void
+insert_keys(struct hash_table *table, const unsigned int *keys, size_t n);
+void
+contains_keys(struct hash_table *table, const unsigned int *keys, size_t n, uint64_t *out_bitmap);
+void
+delete_keys(struct hash_table *table, const unsigned int *keys, size_t n);
+
+/*
+ * A new linear probing table holding keys (duplicates are fine), built by threads threads at once. The keys are split
+ * by the top bits of their bin, and every thread fills its own ranges of bins with no locking. A key whose run goes past
+ * the end of its range is left for the end and inserted as usual once all threads are done (that's also the run
+ * wrapping around from the last bin to the first), so lookups find everything just like after insert_key. At least
+ * 2^mersenne_prime_power - 1 bins, more if n keys would go over the max load factor.
+ *
+ * It's in open_addressing_bulk.c, link that and radix_partition.c with -pthread to use it.
+ */
+struct hash_table *
+build_table(uint8_t mersenne_prime_power, const unsigned int *keys, size_t n, int threads);
+
+/*
+ * Snapshots.
+ *
+ * A snapshot file (see snapshot.h) is a SNAPSHOT_HEADER_SIZE byte header followed by the bins exactly as they are in
+ * memory. The header has everything else needed to use the bins again: the power, the index mode and probing, the hash
+ * function and its seed, count and tombstones, and a checksum of the bins. The bins start on a page boundary, so
+ * map_table can mmap the file and point the table straight at them.
+ *
+ * Nothing gets converted, so a snapshot only opens on a machine with the same byte order and struct bin layout. The
+ * header has a magic number and sizeof(struct bin) to catch that, and a version to bump whenever the layout changes.
+ */
+// "OASNAPSH" on a little endian machine.
+#define SNAPSHOT_MAGIC 0x485350414e53414fULL
+#define SNAPSHOT_VERSION 1
+
+struct snapshot_header {
+  uint64_t magic;
+  uint32_t version;
+  uint32_t bin_size;
+  uint8_t mersenne_prime_power;
+  uint8_t index_mode;
+  uint8_t probing;
+  uint8_t hash_function;
+  uint32_t reserved;
+  uint64_t seed;
+  uint64_t size;
+  uint64_t count;
+  uint64_t tombstones;
+  // snapshot_checksum of the bins.
+  uint64_t checksum;
+};
+
+// Writes table to path. Finishes a resize first if one is going on. The file is written next to path and renamed
+// over it once it's complete, so path is never half written. False if anything went wrong, errno says what.
+bool
+save_table(struct hash_table *table, const char *path);
+
+/*
+ * A table for the snapshot at path, with its bins mapped straight from the file. There's no reading or converting
+ * anything, so it takes the same time for 10 keys as for a billion, and the pages come in from the page cache as
+ * lookups touch them. It's a table like any other: inserts and deletes copy the pages they touch (the file never
+ * changes), and the first resize moves the bins into memory and unmaps the file. delete_table unmaps it otherwise.
+ * NULL if the file isn't a snapshot this build can read, or is cut short.
+ *
+ * The checksum isn't checked, that would mean reading every page. verify_snapshot does that.
+ */
+struct hash_table *
+map_table(const char *path);
+
+// True if table's bins still add up to the checksum in the snapshot it was mapped from. Reads every bin. False once
+// anything was inserted or deleted, or the table was resized.
+bool
+verify_snapshot(const struct hash_table *table);
+
 #ifdef WITH_METRICS
 void
 print_metrics(struct hash_table *table);
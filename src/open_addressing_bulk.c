@@ -0,0 +1,78 @@
+#include "open_addressing.h"
+
+#include <stdlib.h>
+
+#include "radix_partition.h"
+
+// Keys placed by a thread, one cache line each.
+struct bulk_thread {
+  _Alignas(64) size_t count;
+};
+
+struct bulk_build {
+  struct hash_table *table;
+  struct bulk_thread *threads;
+};
+
+// Linear probing within [begin, end) only, a run that would go on past end is the caller's problem.
+static size_t
+fill_bins(void *arg, int thread, size_t begin, size_t end, unsigned int *keys, size_t n) {
+  (void)begin;
+  struct bulk_build *build = arg;
+  struct hash_table *table = build->table;
+  struct bin *bins = table->table;
+  size_t left = 0, count = 0;
+
+  for (size_t i = 0; i < n; ++i) {
+    unsigned int key = keys[i];
+    size_t index = hash_bin_index(hash_key(&table->hasher, key), table->mersenne_prime_power);
+    for (; index < end; ++index) {
+      if (!bins[index].is_used) {
+        bins[index] = (struct bin){.is_used = true, .key = key};
+        count++;
+        break;
+      }
+      if (bins[index].key == key) break;
+    }
+    // Off the end, the next range is someone else's. An earlier copy of the key that made it into a bin would have
+    // turned up on the way, so at worst it's left over twice and insert_keys sorts that out.
+    if (index == end) keys[left++] = key;
+  }
+  build->threads[thread].count += count;
+  return left;
+}
+
+struct hash_table *
+build_table(uint8_t mersenne_prime_power, const unsigned int *keys, size_t n, int threads) {
+  if (threads < 1) threads = 1;
+  // Room for every key without going over the load factor, duplicates or not.
+  while (mersenne_prime_power < MAX_MERSENNE_PRIME_POWER &&
+         n > DEFAULT_MAX_LOAD_FACTOR * ((1ULL << mersenne_prime_power) - 1))
+    mersenne_prime_power++;
+
+  struct bulk_build build = {
+      .table = empty_table_with_probing(mersenne_prime_power, PROBE_LINEAR),
+      .threads = aligned_alloc(_Alignof(struct bulk_thread), threads * sizeof *build.threads),
+  };
+  unsigned int *leftovers = NULL;
+  // Sadly malloc can fail.
+  if (!build.table || !build.threads) goto error;
+  for (int t = 0; t < threads; ++t) build.threads[t].count = 0;
+
+  size_t left = fill_partitioned(keys, n, &build.table->hasher, mersenne_prime_power, threads, fill_bins, &build,
+                                 &leftovers);
+  if (left == SIZE_MAX) goto error;
+  for (int t = 0; t < threads; ++t) build.table->count += build.threads[t].count;
+  // Not many, they're the keys that land right before the end of a range. insert_key walks into the next range (or
+  // around to bin 0) like it would have all along.
+  insert_keys(build.table, leftovers, left);
+
+  free(leftovers);
+  free(build.threads);
+  return build.table;
+
+error:
+  if (build.table) delete_table(build.table);
+  free(build.threads);
+  return NULL;
+}
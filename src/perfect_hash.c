@@ -0,0 +1,432 @@
+#include "perfect_hash.h"
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include "hash_table_helper.h"
+#include "radix_partition.h"
+
+/*
+ * Where a key goes with a pilot. All of the hash goes through a full mix together with the pilot, so two keys of a
+ * bucket land on independent slots for every pilot. Something cheaper like xor'ing in a hash of the pilot keeps the
+ * top bits of two hashes as close as they were, and fastrange only looks at the top bits: a bucket with two such keys
+ * needs a huge pilot, or never fits at all.
+ */
+static inline uint32_t
+slot_of(uint64_t hashed, uint64_t pilot, uint32_t slots) {
+  uint64_t x = hashed + pilot;
+  return (uint32_t)(((unsigned __int128)splitmix64(&x) * slots) >> 64);
+}
+
+// The few that don't fit in pilot_bits, by bucket.
+static uint64_t
+get_big_pilot(const struct perfect_hash *hash, uint64_t bucket) {
+  size_t low = 0, high = hash->num_big_pilots;
+  while (high - low > 1) {
+    size_t middle = (low + high) / 2;
+    if (hash->big_pilots[middle].bucket <= bucket)
+      low = middle;
+    else
+      high = middle;
+  }
+  return hash->big_pilots[low].pilot;
+}
+
+static inline uint64_t
+get_pilot(const struct perfect_hash *hash, uint64_t bucket) {
+  uint64_t bit = bucket * hash->pilot_bits, mask = (1ULL << hash->pilot_bits) - 1;
+  uint64_t word;
+  memcpy(&word, hash->pilots + bit / 8, sizeof word);
+  uint64_t pilot = (word >> (bit % 8)) & mask;
+  return pilot == mask ? get_big_pilot(hash, bucket) : pilot;
+}
+
+size_t
+perfect_hash_index(const struct perfect_hash *hash, unsigned int key) {
+  uint64_t hashed = hash_key(&hash->hasher, key);
+  uint64_t bucket = hash_bin_index(hashed, hash->mersenne_prime_power);
+  const struct perfect_hash_partition *partition = &hash->partitions[bucket >> hash->partition_shift];
+  uint32_t slot = slot_of(hashed, get_pilot(hash, bucket), partition->slots);
+  if (slot >= partition->keys) slot = hash->remap[partition->first_remap + slot - partition->keys];
+  return partition->first_key + slot;
+}
+
+bool
+perfect_hash_contains(const struct perfect_hash *hash, unsigned int key) {
+  size_t index = perfect_hash_index(hash, key);
+  return index < hash->count && hash->keys[index] == key;
+}
+
+size_t
+perfect_hash_metadata_bytes(const struct perfect_hash *hash) {
+  return hash->pilot_bytes + hash->num_big_pilots * sizeof *hash->big_pilots +
+         hash->remap_size * sizeof *hash->remap + hash->num_partitions * sizeof *hash->partitions;
+}
+
+void
+delete_perfect_hash(struct perfect_hash *hash) {
+  free(hash->partitions);
+  free(hash->pilots);
+  free(hash->big_pilots);
+  free(hash->remap);
+  free(hash->keys);
+  free(hash);
+}
+
+/*
+ * Building.
+ *
+ * The keys get split by partition with partition_keys (radix_partition.c). Then, with every thread taking every
+ * threads-th partition:
+ *
+ * 1. sort_partition sorts a partition's keys by bucket and drops duplicates, which leaves how many keys it has.
+ * 2. From those, where each partition's indexes and remap entries start. That's a prefix sum, on this thread.
+ * 3. place_partition finds every bucket its pilot, fills in the partition's remap entries and puts every key at its
+ *    index.
+ *
+ * Partitions never share a bucket, a slot or an index, so nothing is locked.
+ */
+struct build {
+  struct perfect_hash *hash;
+  int threads;
+  unsigned int *scratch;
+  size_t *starts;
+  uint64_t buckets;
+  // Pilots while they're still one per uint32_t.
+  uint32_t *pilots;
+  // Per partition, whether it didn't work out.
+  bool *too_big;
+  bool *no_memory;
+};
+
+static inline uint64_t
+bucket_begin(const struct build *build, size_t p) {
+  return (uint64_t)p << build->hash->partition_shift;
+}
+
+static inline uint64_t
+bucket_end(const struct build *build, size_t p) {
+  uint64_t end = (uint64_t)(p + 1) << build->hash->partition_shift;
+  return end < build->buckets ? end : build->buckets;
+}
+
+static inline uint64_t
+bucket_of(const struct perfect_hash *hash, uint64_t hashed) {
+  return hash_bin_index(hashed, hash->mersenne_prime_power);
+}
+
+static void
+sort_partition(struct build *build, size_t p) {
+  const struct perfect_hash *hash = build->hash;
+  unsigned int *keys = build->scratch + build->starts[p];
+  size_t n = build->starts[p + 1] - build->starts[p];
+  uint64_t begin = bucket_begin(build, p), buckets = bucket_end(build, p) - begin;
+
+  uint32_t *starts = calloc(buckets + 1, sizeof *starts);
+  uint32_t *local = malloc((n ? n : 1) * sizeof *local);
+  unsigned int *sorted = malloc((n ? n : 1) * sizeof *sorted);
+  // Sadly malloc can fail.
+  if (!starts || !local || !sorted) {
+    build->no_memory[p] = true;
+    goto done;
+  }
+
+  // A counting sort by bucket.
+  for (size_t i = 0; i < n; ++i) {
+    local[i] = (uint32_t)(bucket_of(hash, hash_key(&hash->hasher, keys[i])) - begin);
+    starts[local[i] + 1]++;
+  }
+  for (uint64_t b = 0; b < buckets; ++b) starts[b + 1] += starts[b];
+  for (size_t i = 0; i < n; ++i) sorted[starts[local[i]]++] = keys[i];
+
+  // starts[b] is where bucket b + 1 starts now. Equal keys are in the same bucket, and a bucket is a few keys, so
+  // comparing with the ones kept so far is quick.
+  size_t kept = 0, from = 0;
+  for (uint64_t b = 0; b < buckets; ++b) {
+    size_t bucket_kept = kept;
+    for (; from < starts[b]; ++from) {
+      unsigned int key = sorted[from];
+      bool duplicate = false;
+      for (size_t j = bucket_kept; j < kept && !duplicate; ++j) duplicate = keys[j] == key;
+      if (!duplicate) keys[kept++] = key;
+    }
+  }
+  build->hash->partitions[p].keys = (uint32_t)kept;
+
+done:
+  free(starts);
+  free(local);
+  free(sorted);
+}
+
+static void
+place_partition(struct build *build, size_t p) {
+  struct perfect_hash *hash = build->hash;
+  const struct perfect_hash_partition *partition = &hash->partitions[p];
+  const unsigned int *keys = build->scratch + build->starts[p];
+  size_t n = partition->keys;
+  uint32_t slots = partition->slots;
+  uint64_t begin = bucket_begin(build, p), buckets = bucket_end(build, p) - begin;
+
+  uint64_t *hashes = malloc((n ? n : 1) * sizeof *hashes);
+  uint32_t *starts = calloc(buckets + 1, sizeof *starts);
+  uint32_t *order = malloc(buckets * sizeof *order);
+  uint32_t *positions = malloc((n ? n : 1) * sizeof *positions);
+  uint64_t *taken = calloc((slots + 63) / 64, sizeof *taken);
+  uint32_t *by_size = NULL;
+  // Sadly malloc can fail.
+  if (!hashes || !starts || !order || !positions || !taken) goto no_memory;
+
+  // The keys are sorted by bucket already, just need to know where each bucket starts.
+  for (size_t i = 0; i < n; ++i) {
+    hashes[i] = hash_key(&hash->hasher, keys[i]);
+    starts[bucket_of(hash, hashes[i]) - begin + 1]++;
+  }
+  uint32_t biggest = 0;
+  for (uint64_t b = 0; b < buckets; ++b) {
+    if (starts[b + 1] > biggest) biggest = starts[b + 1];
+    starts[b + 1] += starts[b];
+  }
+
+  // Biggest buckets first, they're the hardest to fit. Another counting sort, by size this time.
+  by_size = calloc(biggest + 2, sizeof *by_size);
+  if (!by_size) goto no_memory;
+  for (uint64_t b = 0; b < buckets; ++b) by_size[biggest - (starts[b + 1] - starts[b]) + 1]++;
+  for (uint32_t size = 0; size <= biggest; ++size) by_size[size + 1] += by_size[size];
+  for (uint64_t b = 0; b < buckets; ++b) order[by_size[biggest - (starts[b + 1] - starts[b])]++] = (uint32_t)b;
+
+  for (uint64_t o = 0; o < buckets; ++o) {
+    uint32_t b = order[o], first = starts[b], size = starts[b + 1] - first;
+    // The rest are empty, their pilot stays 0.
+    if (!size) break;
+
+    uint32_t pilot = 0;
+    for (;; ++pilot) {
+      if (pilot > PERFECT_HASH_MAX_PILOT) {
+        build->too_big[p] = true;
+        goto done;
+      }
+      uint32_t i = 0;
+      for (; i < size; ++i) {
+        uint32_t slot = slot_of(hashes[first + i], pilot, slots);
+        if (taken[slot / 64] & (1ULL << (slot % 64))) break;
+        bool twice = false;
+        for (uint32_t j = 0; j < i && !twice; ++j) twice = positions[first + j] == slot;
+        if (twice) break;
+        positions[first + i] = slot;
+      }
+      if (i == size) break;
+    }
+    for (uint32_t i = 0; i < size; ++i) taken[positions[first + i] / 64] |= 1ULL << (positions[first + i] % 64);
+    build->pilots[begin + b] = pilot;
+  }
+
+  // Every slot taken from n on gets one of the free slots below n, in order. There are exactly as many of each.
+  uint32_t *remap = hash->remap + partition->first_remap;
+  uint32_t free_slot = 0;
+  for (uint32_t slot = (uint32_t)n; slot < slots; ++slot) {
+    remap[slot - n] = 0;
+    if (!(taken[slot / 64] & (1ULL << (slot % 64)))) continue;
+    while (taken[free_slot / 64] & (1ULL << (free_slot % 64))) free_slot++;
+    remap[slot - n] = free_slot++;
+  }
+  for (size_t i = 0; i < n; ++i) {
+    uint32_t slot = positions[i];
+    if (slot >= n) slot = remap[slot - n];
+    hash->keys[partition->first_key + slot] = keys[i];
+  }
+  goto done;
+
+no_memory:
+  build->no_memory[p] = true;
+done:
+  free(hashes);
+  free(starts);
+  free(order);
+  free(positions);
+  free(taken);
+  free(by_size);
+}
+
+struct build_thread {
+  struct build *build;
+  void (*work)(struct build *, size_t);
+  int id;
+};
+
+static void *
+run_thread(void *arg) {
+  struct build_thread *thread = arg;
+  struct build *build = thread->build;
+  for (size_t p = thread->id; p < build->hash->num_partitions; p += build->threads) thread->work(build, p);
+  return NULL;
+}
+
+// Same as run_threads in radix_partition.c: if a thread can't be started its share is done on this one.
+static void
+run_partitions(struct build *build, void (*work)(struct build *, size_t)) {
+  pthread_t ids[build->threads];
+  struct build_thread threads[build->threads];
+  bool started[build->threads];
+  for (int t = 0; t < build->threads; ++t) {
+    threads[t] = (struct build_thread){.build = build, .work = work, .id = t};
+    started[t] = t > 0 && pthread_create(&ids[t], NULL, run_thread, &threads[t]) == 0;
+  }
+  for (int t = 0; t < build->threads; ++t) {
+    if (!started[t]) run_thread(&threads[t]);
+  }
+  for (int t = 0; t < build->threads; ++t) {
+    if (started[t]) pthread_join(ids[t], NULL);
+  }
+}
+
+/*
+ * Most pilots are small, but a few of the buckets that come last need big ones, and making every pilot as wide as the
+ * biggest would cost more than all the others together. So pilots get pilot_bits, whatever makes the whole thing
+ * smallest, and the ones that don't fit (all ones in pilot_bits) go to big_pilots, sorted by bucket.
+ */
+static bool
+pack_pilots(struct perfect_hash *hash, const uint32_t *pilots, uint64_t buckets) {
+  size_t lengths[33] = {0};
+  for (uint64_t b = 0; b < buckets; ++b) {
+    int length = 0;
+    while (pilots[b] >> length) length++;
+    lengths[length]++;
+  }
+  // Close enough: a pilot of exactly 2^bits - 1 goes to big_pilots too, and isn't counted here.
+  uint64_t best = UINT64_MAX;
+  size_t above = buckets - lengths[0];
+  for (uint8_t bits = 1; bits <= 32; ++bits) {
+    above -= lengths[bits];
+    uint64_t size = buckets * bits + above * 8 * sizeof *hash->big_pilots;
+    if (size < best) {
+      best = size;
+      hash->pilot_bits = bits;
+    }
+  }
+
+  uint64_t mask = (1ULL << hash->pilot_bits) - 1;
+  size_t big = 0;
+  for (uint64_t b = 0; b < buckets; ++b) big += pilots[b] >= mask;
+  hash->pilot_bytes = (buckets * hash->pilot_bits + 7) / 8 + sizeof(uint64_t);
+  hash->pilots = calloc(hash->pilot_bytes, 1);
+  hash->big_pilots = malloc((big ? big : 1) * sizeof *hash->big_pilots);
+  // Sadly malloc can fail.
+  if (!hash->pilots || !hash->big_pilots) return false;
+
+  hash->num_big_pilots = 0;
+  for (uint64_t b = 0; b < buckets; ++b) {
+    uint64_t pilot = pilots[b];
+    if (pilot >= mask) {
+      hash->big_pilots[hash->num_big_pilots++] = (struct perfect_hash_big_pilot){.bucket = b, .pilot = pilot};
+      pilot = mask;
+    }
+    uint64_t bit = b * hash->pilot_bits, word;
+    memcpy(&word, hash->pilots + bit / 8, sizeof word);
+    word |= pilot << (bit % 8);
+    memcpy(hash->pilots + bit / 8, &word, sizeof word);
+  }
+  return true;
+}
+
+static bool
+any(const bool *flags, size_t n) {
+  for (size_t i = 0; i < n; ++i)
+    if (flags[i]) return true;
+  return false;
+}
+
+// One go at it with the hasher in hash. False if it didn't work out, *no_memory says whether it's worth trying again.
+static bool
+try_build(struct perfect_hash *hash, const unsigned int *keys, size_t n, int threads, bool *no_memory) {
+  size_t partitions = hash->num_partitions;
+  struct build build = {
+      .hash = hash,
+      .threads = threads,
+      .buckets = (1ULL << hash->mersenne_prime_power) - 1,
+      .starts = malloc((partitions + 1) * sizeof *build.starts),
+      .too_big = calloc(partitions, sizeof *build.too_big),
+      .no_memory = calloc(partitions, sizeof *build.no_memory),
+  };
+  build.pilots = calloc(build.buckets, sizeof *build.pilots);
+  bool built = false;
+  *no_memory = true;
+  if (!build.starts || !build.too_big || !build.no_memory || !build.pilots) goto done;
+  build.scratch = partition_keys(keys, n, &hash->hasher, hash->mersenne_prime_power, hash->partition_shift, threads,
+                                 build.starts);
+  if (!build.scratch) goto done;
+
+  run_partitions(&build, sort_partition);
+  if (any(build.no_memory, partitions)) goto done;
+
+  size_t first_key = 0, first_remap = 0;
+  for (size_t p = 0; p < partitions; ++p) {
+    struct perfect_hash_partition *partition = &hash->partitions[p];
+    partition->first_key = (uint32_t)first_key;
+    partition->slots = partition->keys + partition->keys / PERFECT_HASH_SPARE_SLOT_EVERY + 1;
+    partition->first_remap = (uint32_t)first_remap;
+    first_key += partition->keys;
+    first_remap += partition->slots - partition->keys;
+  }
+  hash->count = first_key;
+  hash->remap_size = first_remap;
+  hash->keys = malloc((first_key ? first_key : 1) * sizeof *hash->keys);
+  hash->remap = malloc(first_remap * sizeof *hash->remap);
+  if (!hash->keys || !hash->remap) goto done;
+
+  run_partitions(&build, place_partition);
+  if (any(build.no_memory, partitions)) goto done;
+  *no_memory = false;
+  if (any(build.too_big, partitions)) goto done;
+
+  if (!pack_pilots(hash, build.pilots, build.buckets)) {
+    *no_memory = true;
+    goto done;
+  }
+  built = true;
+
+done:
+  if (!built) {
+    free(hash->keys);
+    free(hash->remap);
+    hash->keys = NULL;
+    hash->remap = NULL;
+  }
+  free(build.scratch);
+  free(build.starts);
+  free(build.pilots);
+  free(build.too_big);
+  free(build.no_memory);
+  return built;
+}
+
+struct perfect_hash *
+build_perfect_hash(const unsigned int *keys, size_t n, int threads) {
+  if (threads < 1) threads = 1;
+  // At least 1, hash_bin_index never finishes with s = 0.
+  uint8_t s = index_power(INDEX_MERSENNE, n / PERFECT_HASH_KEYS_PER_BUCKET);
+  if (s < 1) s = 1;
+  // Partitions of around PERFECT_HASH_PARTITION_KEYS keys, and of at least 2^(s/2) buckets.
+  uint8_t bits = 0;
+  while ((n >> bits) > PERFECT_HASH_PARTITION_KEYS && bits < s / 2) bits++;
+
+  struct perfect_hash *hash = calloc(1, sizeof *hash);
+  // Sadly malloc can fail.
+  if (!hash) return NULL;
+  hash->mersenne_prime_power = s;
+  hash->partition_shift = s - bits;
+  hash->num_partitions = (size_t)1 << bits;
+  hash->partitions = calloc(hash->num_partitions, sizeof *hash->partitions);
+  if (!hash->partitions) goto error;
+
+  for (int attempt = 0; attempt < PERFECT_HASH_ATTEMPTS; ++attempt) {
+    init_hasher(&hash->hasher, HASH_UNIVERSAL, attempt);
+    bool no_memory;
+    if (try_build(hash, keys, n, threads, &no_memory)) return hash;
+    if (no_memory) break;
+  }
+
+error:
+  delete_perfect_hash(hash);
+  return NULL;
+}
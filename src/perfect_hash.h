@@ -0,0 +1,104 @@
+#ifndef PERFECT_HASH_H
+#define PERFECT_HASH_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "hash_table_helper.h"
+
+/*
+ * A minimal perfect hash for a key set that never changes: every key gets its own index in [0, count), no gaps, no
+ * collisions. Built the PTHash way (Pibiri and Trani, 2021):
+ *
+ * 1. Hash every key (HASH_UNIVERSAL, no two 32 bit keys collide) and hash_bin_index the hash into one of 2^s - 1
+ *    buckets, a handful of keys each.
+ * 2. Go through the buckets biggest first, and find each one a pilot: the first number p for which
+ *    slot(key) = fastrange(mix(hash + p), slots) puts every key of the bucket on a slot nobody has yet.
+ * 3. Store the pilots, most of them are small (see pack_pilots in perfect_hash.c).
+ *
+ * There are 1% more slots than keys, so the last buckets still find a free slot quickly. The keys that land on a slot
+ * past the last key are sent to one of the free slots further down with a small remap table, so the indexes come out
+ * minimal anyway.
+ *
+ * Buckets are split into partitions (ranges of 2^partition_shift buckets) with their own slots, so the partitions can
+ * be built by different threads, and every partition's slots fit in cache while it's built. A lookup is a read of the
+ * key's pilot, then of keys[index] to check it's really the key (anything not in the set gets some index too). The
+ * partitions are small enough to stay in cache.
+ *
+ * That's around 3 bits per key for pilots and remap, plus the 4 bytes per key of the keys themselves.
+ */
+
+// Keys per bucket. The buckets are 2^s - 1 with at least n / this many, so it ends up between half this and this.
+// Fewer keys per bucket builds faster but takes more bits per key. n counts duplicates, lots of them waste buckets.
+#ifndef PERFECT_HASH_KEYS_PER_BUCKET
+#define PERFECT_HASH_KEYS_PER_BUCKET 5
+#endif
+// One more slot for every this many keys.
+#define PERFECT_HASH_SPARE_SLOT_EVERY 100
+// Keys per partition, roughly.
+#define PERFECT_HASH_PARTITION_KEYS (1 << 16)
+// A bucket that needs a bigger pilot than this starts the build over with another seed, up to this many times.
+#define PERFECT_HASH_MAX_PILOT (1 << 20)
+#define PERFECT_HASH_ATTEMPTS 8
+
+struct perfect_hash_partition {
+  // Indexes first_key to first_key + keys - 1.
+  uint32_t first_key;
+  uint32_t keys;
+  // keys + keys / PERFECT_HASH_SPARE_SLOT_EVERY + 1. Slots from keys on are remapped.
+  uint32_t slots;
+  uint32_t first_remap;
+};
+
+struct perfect_hash_big_pilot {
+  uint32_t bucket;
+  uint32_t pilot;
+};
+
+struct perfect_hash {
+  size_t count;
+  // 2^s - 1 buckets.
+  uint8_t mersenne_prime_power;
+  // Bucket b is in partition b >> partition_shift.
+  uint8_t partition_shift;
+  uint8_t pilot_bits;
+  size_t num_partitions;
+  struct perfect_hash_partition *partitions;
+  // pilot_bits per bucket, back to back, with 8 bytes of padding at the end so a pilot is always one 8 byte read. All
+  // ones means the pilot is too big for that, and is in big_pilots instead.
+  uint8_t *pilots;
+  size_t pilot_bytes;
+  struct perfect_hash_big_pilot *big_pilots;
+  size_t num_big_pilots;
+  // The free slot below keys for every slot from keys on, partition after partition.
+  uint32_t *remap;
+  size_t remap_size;
+  // keys[index] is the key with that index.
+  unsigned int *keys;
+  struct hasher hasher;
+};
+
+/*
+ * A perfect hash for keys, built by threads threads. Duplicates are fine, count is the number of different keys. Link
+ * perfect_hash.c and radix_partition.c with -pthread. NULL if there wasn't enough memory, or (very unlikely)
+ * PERFECT_HASH_ATTEMPTS seeds in a row had a bucket that wouldn't fit.
+ */
+struct perfect_hash *
+build_perfect_hash(const unsigned int *keys, size_t n, int threads);
+
+void
+delete_perfect_hash(struct perfect_hash *hash);
+
+// key's index if it's one of the keys, some index or other (maybe count) if it isn't.
+size_t
+perfect_hash_index(const struct perfect_hash *hash, unsigned int key);
+
+bool
+perfect_hash_contains(const struct perfect_hash *hash, unsigned int key);
+
+// Pilots, remap and partitions, not counting the keys.
+size_t
+perfect_hash_metadata_bytes(const struct perfect_hash *hash);
+
+#endif
@@ -0,0 +1,239 @@
+#include "quotient_table.h"
+
+#include <stdlib.h>
+
+#include "hash_table_helper.h"
+#include "table_alloc.h"
+
+#define PSL_MASK 0x7Fu
+#define MAX_PSL PSL_MASK
+#define ALL_ONES_BIT 0x80u
+#define QUOTIENT_SHIFT 8
+
+static inline uint32_t
+get_slot(const struct hash_table *table, size_t index) {
+  return table->slot_bytes == 2 ? ((const uint16_t *)table->slots)[index] : ((const uint32_t *)table->slots)[index];
+}
+
+static inline void
+set_slot(struct hash_table *table, size_t index, uint32_t slot) {
+  if (table->slot_bytes == 2)
+    ((uint16_t *)table->slots)[index] = (uint16_t)slot;
+  else
+    ((uint32_t *)table->slots)[index] = slot;
+}
+
+static inline size_t
+next_index(const struct hash_table *table, size_t index) {
+  return ++index == table->size ? 0 : index;
+}
+
+// What key's slot looks like in its home bin (probe sequence length 0), and which bin that is. One bin further along,
+// it's the same plus one.
+static inline uint32_t
+home_slot(const struct hash_table *table, unsigned int key, size_t *home) {
+  uint8_t s = table->mersenne_prime_power;
+  uint64_t p = (1ULL << s) - 1;
+  // 64 bits, s can be 32.
+  uint32_t quotient = (uint32_t)((uint64_t)key >> s);
+  *home = hash_bin_index(key, s);
+  return (quotient << QUOTIENT_SHIFT) | ((key & p) == p ? ALL_ONES_BIT : 0) | 1;
+}
+
+// The other way around, for a slot sitting in bin index: its home bin gives us b back (see quotient_table.h).
+static unsigned int
+key_of(const struct hash_table *table, uint32_t slot, size_t index) {
+  uint8_t s = table->mersenne_prime_power;
+  uint64_t p = (1ULL << s) - 1;
+  size_t psl = (slot & PSL_MASK) - 1;
+  uint64_t home = index >= psl ? index - psl : index + table->size - psl;
+  uint64_t quotient = slot >> QUOTIENT_SHIFT;
+
+  uint64_t remainder;
+  if (slot & ALL_ONES_BIT) {
+    remainder = p;
+  } else {
+    // b = (home - a) mod 2^s - 1. a only goes over 2^s - 1 for small s.
+    uint64_t a = quotient % p;
+    remainder = home >= a ? home - a : home + p - a;
+  }
+  return (unsigned int)((quotient << s) | remainder);
+}
+
+static bool
+init_table(struct hash_table *table, uint8_t mersenne_prime_power) {
+  size_t size = (1ULL << mersenne_prime_power) - 1;
+  uint8_t slot_bytes = mersenne_prime_power >= NARROW_QUOTIENT_POWER ? 2 : 4;
+  // All zeroes is a free slot, see table_alloc.h.
+  void *slots = table_alloc(size * slot_bytes);
+  if (!slots) return false;
+
+  *table = (struct hash_table){
+      .slots = slots, .size = size, .count = 0, .mersenne_prime_power = mersenne_prime_power, .slot_bytes = slot_bytes};
+  return true;
+}
+
+struct hash_table *
+empty_table(uint8_t mersenne_prime_power) {
+  if (mersenne_prime_power < MIN_QUOTIENT_POWER) mersenne_prime_power = MIN_QUOTIENT_POWER;
+  if (mersenne_prime_power > MAX_QUOTIENT_POWER) return NULL;
+
+  struct hash_table *table = (struct hash_table *)malloc(sizeof *table);
+  // Sadly malloc can fail.
+  if (!table || !init_table(table, mersenne_prime_power)) {
+    free(table);
+    return NULL;
+  }
+  return table;
+}
+
+void
+delete_table(struct hash_table *table) {
+  table_free(table->slots, table->size * table->slot_bytes);
+  free(table);
+}
+
+// Moves every key into a table one power up. The keys have to be taken apart and put back together anyway, so it's
+// just a bunch of inserts into the bigger one (which can grow again itself if it has to).
+static bool
+grow(struct hash_table *table) {
+  if (table->mersenne_prime_power == MAX_QUOTIENT_POWER) return false;
+
+  struct hash_table bigger;
+  if (!init_table(&bigger, table->mersenne_prime_power + 1)) return false;
+#ifdef WITH_METRICS
+  bigger.collisions = table->collisions;
+  bigger.rehashes = table->rehashes + 1;
+#endif
+
+  for (size_t index = 0; index < table->size; ++index) {
+    uint32_t slot = get_slot(table, index);
+    if (slot & PSL_MASK) insert_key(&bigger, key_of(table, slot, index));
+  }
+  // The bigger one couldn't take them all (it had to grow too, and couldn't), keep what we've got.
+  if (bigger.count != table->count) {
+    table_free(bigger.slots, bigger.size * bigger.slot_bytes);
+    return false;
+  }
+
+  table_free(table->slots, table->size * table->slot_bytes);
+  *table = bigger;
+  return true;
+}
+
+// Whether the Robin Hood walk from index, carrying carry, ends at a free slot before it has to push whatever it's
+// carrying MAX_PSL bins from home. Same walk as insert_key, without writing anything. Once around without a free slot
+// means the table is full (it can't grow past MAX_QUOTIENT_POWER).
+static bool
+shift_fits(const struct hash_table *table, size_t index, uint32_t carry) {
+  for (size_t steps = 0; steps < table->size; ++steps, carry++, index = next_index(table, index)) {
+    uint32_t slot = get_slot(table, index);
+    if (!(slot & PSL_MASK)) return true;
+    if ((slot & PSL_MASK) < (carry & PSL_MASK)) carry = slot;
+    if ((carry & PSL_MASK) == MAX_PSL) return false;
+  }
+  return false;
+}
+
+// Returns the bin holding key, or table->size if it's not there.
+static size_t
+find_index(const struct hash_table *table, unsigned int key) {
+  size_t index;
+  uint32_t want = home_slot(table, key, &index);
+  for (;; want++, index = next_index(table, index)) {
+    uint32_t slot = get_slot(table, index);
+    if (slot == want) return index;
+    // Same early out as robin_hood.c, and nothing is ever further than MAX_PSL from home.
+    if ((slot & PSL_MASK) < (want & PSL_MASK) || (want & PSL_MASK) == MAX_PSL) return table->size;
+  }
+}
+
+void
+insert_key(struct hash_table *table, unsigned int key) {
+  size_t index;
+  uint32_t carry = home_slot(table, key, &index);
+
+  // Same walk as find_index, no duplicates.
+  for (;; carry++, index = next_index(table, index)) {
+    uint32_t slot = get_slot(table, index);
+    if (slot == carry) return;
+    if ((slot & PSL_MASK) < (carry & PSL_MASK)) break;
+    if ((carry & PSL_MASK) == MAX_PSL) {
+      // Can't go any further from home. Nothing's been moved yet, so just grow and try again.
+      if (grow(table)) insert_key(table, key);
+      return;
+    }
+#ifdef WITH_METRICS
+    table->collisions++;
+#endif
+  }
+
+  if (!shift_fits(table, index, carry)) {
+    // Some key we'd move along would end up too far from home. Grow and try again, and if we can't (at
+    // MAX_QUOTIENT_POWER, or malloc fails) the new key doesn't go in, same as above. Never one that's already in.
+    if (grow(table)) insert_key(table, key);
+    return;
+  }
+
+  // Take from the rich, like robin_hood.c. Slots carry their probe length in the low bits, so moving one bin on is +1.
+  for (;;) {
+    uint32_t slot = get_slot(table, index);
+    if (!(slot & PSL_MASK)) {
+      set_slot(table, index, carry);
+      break;
+    }
+    if ((slot & PSL_MASK) < (carry & PSL_MASK)) {
+      set_slot(table, index, carry);
+      carry = slot;
+    }
+    carry++;
+    index = next_index(table, index);
+#ifdef WITH_METRICS
+    table->collisions++;
+#endif
+  }
+
+  table->count++;
+  if (table->count > QUOTIENT_MAX_LOAD_FACTOR * table->size) grow(table);
+}
+
+bool
+contains_key(struct hash_table *table, unsigned int key) {
+  return find_index(table, key) != table->size;
+}
+
+void
+delete_key(struct hash_table *table, unsigned int key) {
+  size_t index = find_index(table, key);
+  if (index == table->size) return;
+
+  // Backward shift, like robin_hood.c. One bin closer to home is -1.
+  for (size_t next = next_index(table, index); (get_slot(table, next) & PSL_MASK) > 1;
+       next = next_index(table, next)) {
+    set_slot(table, index, get_slot(table, next) - 1);
+    index = next;
+  }
+  set_slot(table, index, 0);
+
+  table->count--;
+}
+
+#ifdef WITH_METRICS
+#include <stdio.h>
+void
+print_metrics(struct hash_table *table) {
+  unsigned int max = 0;
+  for (size_t i = 0; i < table->size; ++i) {
+    unsigned int psl = get_slot(table, i) & PSL_MASK;
+    if (psl > max) max = psl;
+  }
+
+  printf("Total stats:\n");
+  printf("            Count: %zu\n", table->count);
+  printf("       Collisions: %zu\n", table->collisions);
+  printf("         Rehashes: %zu\n", table->rehashes);
+  printf(" Max probe length: %u\n", max);
+  printf("             Bins: %zu (2^%u - 1), %u bytes each\n", table->size, table->mersenne_prime_power,
+         table->slot_bytes);
+}
+#endif
@@ -0,0 +1,73 @@
+#ifndef QUOTIENT_TABLE_H
+#define QUOTIENT_TABLE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+/*
+ * Quotiented keys: only store the bits of a key its bin doesn't already tell us.
+ *
+ * Split a key into a = key >> s and b = key & (2^s - 1). Its home bin is hash_bin_index(key, s) = (a + b) mod 2^s - 1,
+ * so given the home bin and a, b is (home - a) mod 2^s - 1. Except that b = 0 and b = 2^s - 1 both land in the same
+ * bin, so we keep one bit for "b is all ones" too. That's 32 - s + 1 bits per key instead of 32, and no false
+ * positives, two different keys never look the same.
+ *
+ * The home bin itself comes from the probe sequence length, same as robin_hood.c (linear probing, Robin Hood inserts,
+ * backward shift deletes, no tombstones). A slot is
+ *
+ *   bits 0 - 6   probe sequence length + 1 (0 is a free slot), so at most 126 bins from home
+ *   bit 7        b is 2^s - 1
+ *   bits 8 -     a, the quotient
+ *
+ * For s >= 24 the quotient is at most 8 bits, so a slot is 16 bits, a quarter of open_addressing.c's 8 byte bins (and
+ * 4x the keys per cache line). Below that slots are 32 bits, still half. Growing past 2^23 - 1 bins switches over.
+ *
+ * A lookup doesn't even have to take slots apart: the slot the key would have at probe length i is a number we can
+ * work out up front, so it's one compare per probe.
+ *
+ * The table grows to the next power (all at once) past QUOTIENT_MAX_LOAD_FACTOR, or when an insert would push some key
+ * further than 126 bins from home. If it can't grow (at MAX_QUOTIENT_POWER, or malloc fails) the new key is left out,
+ * never one that's already in. Any key can be inserted, 0 included.
+ */
+
+#define QUOTIENT_MAX_LOAD_FACTOR 0.9
+// Slots need room for the quotient, 32 - s bits of it, next to the 8 bits of metadata.
+#define MIN_QUOTIENT_POWER 8
+#define MAX_QUOTIENT_POWER 32
+// s from here on gets 16 bit slots.
+#define NARROW_QUOTIENT_POWER 24
+
+struct hash_table {
+  // uint16_t or uint32_t slots, depending on the power.
+  void *slots;
+  size_t size;
+  size_t count;
+  uint8_t mersenne_prime_power;
+  // 2 or 4.
+  uint8_t slot_bytes;
+#ifdef WITH_METRICS
+  size_t collisions;
+  size_t rehashes;
+#endif
+};
+
+// Powers below MIN_QUOTIENT_POWER are rounded up to it.
+struct hash_table *
+empty_table(uint8_t mersenne_prime_power);
+void
+delete_table(struct hash_table *table);
+
+void
+insert_key(struct hash_table *table, unsigned int key);
+bool
+contains_key(struct hash_table *table, unsigned int key);
+void
+delete_key(struct hash_table *table, unsigned int key);
+
+#ifdef WITH_METRICS
+void
+print_metrics(struct hash_table *table);
+#endif
+
+#endif
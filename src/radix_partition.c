@@ -0,0 +1,192 @@
+#include "radix_partition.h"
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+struct partition_job {
+  const unsigned int *keys;
+  size_t n;
+  const struct hasher *hasher;
+  uint8_t mersenne_prime_power;
+  uint8_t shift;
+  size_t partitions;
+  int threads;
+  fill_partition_fn fill;
+  void *table;
+  // counts[thread * partitions + p]: how many of thread's keys go to p, then where the next one of them goes.
+  size_t *counts;
+  // Where partition p's keys start in scratch, and one past the last partition.
+  size_t *starts;
+  unsigned int *scratch;
+  // What fill left over, per partition.
+  size_t *leftovers;
+};
+
+struct partition_thread {
+  struct partition_job *job;
+  int id;
+};
+
+// Around 4 partitions per thread, and at most 2^(s/2) of them so a partition is big next to a run of keys.
+static uint8_t
+partition_shift(uint8_t mersenne_prime_power, int threads) {
+  uint8_t bits = 0;
+  while ((1L << bits) < 4L * threads && bits < mersenne_prime_power / 2) bits++;
+  return mersenne_prime_power - bits;
+}
+
+static inline size_t
+partition_of(const struct partition_job *job, unsigned int key) {
+  return hash_bin_index(hash_key(job->hasher, key), job->mersenne_prime_power) >> job->shift;
+}
+
+// Pass one, counting.
+static void *
+count_keys(void *arg) {
+  struct partition_thread *thread = arg;
+  struct partition_job *job = thread->job;
+  size_t *counts = &job->counts[thread->id * job->partitions];
+  size_t end = job->n * (thread->id + 1) / job->threads;
+  for (size_t i = job->n * thread->id / job->threads; i < end; ++i) counts[partition_of(job, job->keys[i])]++;
+  return NULL;
+}
+
+// Pass two, copying every key to its partition.
+static void *
+scatter_keys(void *arg) {
+  struct partition_thread *thread = arg;
+  struct partition_job *job = thread->job;
+  size_t *next = &job->counts[thread->id * job->partitions];
+  size_t end = job->n * (thread->id + 1) / job->threads;
+  for (size_t i = job->n * thread->id / job->threads; i < end; ++i) {
+    unsigned int key = job->keys[i];
+    job->scratch[next[partition_of(job, key)]++] = key;
+  }
+  return NULL;
+}
+
+static void *
+fill_partitions(void *arg) {
+  struct partition_thread *thread = arg;
+  struct partition_job *job = thread->job;
+  size_t size = ((size_t)1 << job->mersenne_prime_power) - 1;
+  for (size_t p = thread->id; p < job->partitions; p += job->threads) {
+    size_t begin = p << job->shift, end = (p + 1) << job->shift;
+    if (end > size) end = size;
+    size_t start = job->starts[p];
+    job->leftovers[p] =
+        job->fill(job->table, thread->id, begin, end, job->scratch + start, job->starts[p + 1] - start);
+  }
+  return NULL;
+}
+
+// Runs work on every thread and waits for them. If a thread can't be started its share is done on this one.
+static void
+run_threads(struct partition_job *job, void *(*work)(void *)) {
+  pthread_t ids[job->threads];
+  struct partition_thread threads[job->threads];
+  bool started[job->threads];
+  for (int t = 0; t < job->threads; ++t) {
+    threads[t] = (struct partition_thread){.job = job, .id = t};
+    started[t] = t > 0 && pthread_create(&ids[t], NULL, work, &threads[t]) == 0;
+  }
+  for (int t = 0; t < job->threads; ++t) {
+    if (!started[t]) work(&threads[t]);
+  }
+  for (int t = 0; t < job->threads; ++t) {
+    if (started[t]) pthread_join(ids[t], NULL);
+  }
+}
+
+// Passes one and two, into job->scratch and job->starts. False if there wasn't enough memory.
+static bool
+partition(struct partition_job *job) {
+  job->counts = calloc((size_t)job->threads * job->partitions, sizeof *job->counts);
+  // At least one, so there's something to hand back even with no keys.
+  job->scratch = malloc((job->n ? job->n : 1) * sizeof *job->scratch);
+  // Sadly malloc can fail.
+  if (!job->counts || !job->scratch) {
+    free(job->counts);
+    free(job->scratch);
+    job->counts = NULL;
+    job->scratch = NULL;
+    return false;
+  }
+
+  run_threads(job, count_keys);
+  // Partition by partition, thread by thread, so every thread's keys for a partition come in one go.
+  size_t offset = 0;
+  for (size_t p = 0; p < job->partitions; ++p) {
+    job->starts[p] = offset;
+    for (int t = 0; t < job->threads; ++t) {
+      size_t count = job->counts[t * job->partitions + p];
+      job->counts[t * job->partitions + p] = offset;
+      offset += count;
+    }
+  }
+  job->starts[job->partitions] = offset;
+  run_threads(job, scatter_keys);
+
+  free(job->counts);
+  job->counts = NULL;
+  return true;
+}
+
+unsigned int *
+partition_keys(const unsigned int *keys, size_t n, const struct hasher *hasher, uint8_t mersenne_prime_power,
+               uint8_t shift, int threads, size_t *starts) {
+  struct partition_job job = {
+      .keys = keys,
+      .n = n,
+      .hasher = hasher,
+      .mersenne_prime_power = mersenne_prime_power,
+      .shift = shift,
+      .partitions = (size_t)1 << (mersenne_prime_power - shift),
+      .threads = threads < 1 ? 1 : threads,
+      .starts = starts,
+  };
+  return partition(&job) ? job.scratch : NULL;
+}
+
+size_t
+fill_partitioned(const unsigned int *keys, size_t n, const struct hasher *hasher, uint8_t mersenne_prime_power,
+                 int threads, fill_partition_fn fill, void *table, unsigned int **leftovers) {
+  if (threads < 1) threads = 1;
+  uint8_t shift = partition_shift(mersenne_prime_power, threads);
+  size_t partitions = (size_t)1 << (mersenne_prime_power - shift);
+  struct partition_job job = {
+      .keys = keys,
+      .n = n,
+      .hasher = hasher,
+      .mersenne_prime_power = mersenne_prime_power,
+      .shift = shift,
+      .partitions = partitions,
+      .threads = threads,
+      .fill = fill,
+      .table = table,
+      .starts = malloc((partitions + 1) * sizeof *job.starts),
+      .leftovers = malloc(partitions * sizeof *job.leftovers),
+  };
+  size_t left = SIZE_MAX;
+  // Sadly malloc can fail.
+  if (!job.starts || !job.leftovers || !partition(&job)) goto error;
+
+  run_threads(&job, fill_partitions);
+
+  // Every partition's leftovers are at its front, move them all to the front of scratch.
+  left = 0;
+  for (size_t p = 0; p < partitions; ++p) {
+    memmove(job.scratch + left, job.scratch + job.starts[p], job.leftovers[p] * sizeof *job.scratch);
+    left += job.leftovers[p];
+  }
+  *leftovers = job.scratch;
+  job.scratch = NULL;
+
+error:
+  free(job.starts);
+  free(job.scratch);
+  free(job.leftovers);
+  return left;
+}
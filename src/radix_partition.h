@@ -0,0 +1,46 @@
+#ifndef RADIX_PARTITION_H
+#define RADIX_PARTITION_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "hash_table_helper.h"
+
+/*
+ * What the bulk builds (open_addressing_bulk.c, hash_table_bulk.c) have in common: split the keys by the top bits of
+ * their bin index, then have every thread fill its own partitions' bins, without any locking since no two threads ever
+ * touch the same bin range.
+ *
+ * The split is a two pass radix partition. Every thread counts how many of its share of the keys go to each partition,
+ * then the counts are summed up into where each thread's keys for each partition start, and every thread copies its
+ * keys there. No atomics, every thread writes to its own slots of the scratch array.
+ *
+ * Bin indexes are Mersenne ones (hash_bin_index) at mersenne_prime_power, and a partition is a range of 2^k bins (the
+ * last one is a bin short). There are a few times more partitions than threads, so one unlucky partition doesn't hold
+ * the rest up.
+ */
+
+// Puts keys into bins [begin, end), every one of them has its bin in there. Anything thread needs of its own (an
+// allocator, counters) is on thread. Keys that don't fit (open addressing running off the end of the range) go to the
+// front of keys, returns how many there are.
+typedef size_t (*fill_partition_fn)(void *table, int thread, size_t begin, size_t end, unsigned int *keys, size_t n);
+
+/*
+ * Partitions keys and runs fill on every partition, from threads threads (the calling one included). Returns how many
+ * keys were left over, with *leftovers pointing to them (free it when done), for the caller to insert one at a time.
+ * SIZE_MAX if there wasn't enough memory, nothing was filled then.
+ */
+size_t
+fill_partitioned(const unsigned int *keys, size_t n, const struct hasher *hasher, uint8_t mersenne_prime_power,
+                 int threads, fill_partition_fn fill, void *table, unsigned int **leftovers);
+
+/*
+ * Just the partitioning, for builds that need more than one pass over every partition (perfect_hash.c). Partition p is
+ * bins [p << shift, (p + 1) << shift), and starts (room for 2^(s - shift) + 1) gets where each one begins in the array
+ * that comes back, plus where the last one ends. Free the array when done, NULL if there wasn't enough memory.
+ */
+unsigned int *
+partition_keys(const unsigned int *keys, size_t n, const struct hasher *hasher, uint8_t mersenne_prime_power,
+               uint8_t shift, int threads, size_t *starts);
+
+#endif
@@ -0,0 +1,143 @@
+#include "robin_hood.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "hash_table_helper.h"
+
+static inline size_t
+next_index(struct hash_table *table, size_t index) {
+  return ++index == table->size ? 0 : index;
+}
+
+// Returns the bin holding key, or table->size if it's not there.
+static size_t
+find_index(struct hash_table *table, unsigned int key) {
+  const struct bin *bins = table->table;
+  size_t index = hash_bin_index(key, table->mersenne_prime_power);
+  // A key is only ever further from home than the bins before it are, so as soon as a bin's key is closer to home than
+  // ours would be (that includes free bins, psl 0), we can stop.
+  for (unsigned int psl = 1; bins[index].psl >= psl; ++psl) {
+    if (bins[index].key == key) return index;
+    index = next_index(table, index);
+  }
+  return table->size;
+}
+
+struct hash_table *
+empty_table(uint8_t mersenne_prime_power) {
+  struct hash_table *table = (struct hash_table *)malloc(sizeof *table);
+  size_t size = (1ULL << mersenne_prime_power) - 1;
+  struct bin *bins = (struct bin *)malloc(size * sizeof *bins);
+
+  // Sadly malloc can fail.
+  if (!table || !bins) goto error;
+
+  // psl 0 everywhere, every bin free.
+  memset(bins, 0, size * sizeof *bins);
+  *table = (struct hash_table){.table = bins, .size = size, .count = 0, .mersenne_prime_power = mersenne_prime_power};
+
+  return table;
+
+error:
+  free(table);
+  free(bins);
+  return NULL;
+}
+
+void
+delete_table(struct hash_table *table) {
+  free(table->table);
+  free(table);
+}
+
+void
+insert_key(struct hash_table *table, unsigned int key) {
+  // Nowhere to put it.
+  if (table->count == table->size) return;
+
+  size_t index = hash_bin_index(key, table->mersenne_prime_power);
+  struct bin carry = {.key = key, .psl = 1};
+
+  // Same walk as find_index: up to the first bin whose key is closer to home than ours would be, the key could already
+  // be in here. No duplicates.
+  for (; table->table[index].psl >= carry.psl; carry.psl++) {
+    if (table->table[index].key == key) return;
+    index = next_index(table, index);
+#ifdef WITH_METRICS
+    table->collisions++;
+#endif
+  }
+
+  // That first bin is ours. Whatever was in it gets carried on until it finds a free bin, taking over any bin whose key
+  // is closer to home than it is (take from the rich).
+  for (;;) {
+    struct bin *bin = &table->table[index];
+    if (!bin->psl) {
+      *bin = carry;
+      break;
+    }
+
+    if (bin->psl < carry.psl) {
+      struct bin evicted = *bin;
+      *bin = carry;
+      carry = evicted;
+    }
+
+    carry.psl++;
+    index = next_index(table, index);
+#ifdef WITH_METRICS
+    table->collisions++;
+#endif
+  }
+
+  table->count++;
+}
+
+bool
+contains_key(struct hash_table *table, unsigned int key) {
+  return find_index(table, key) != table->size;
+}
+
+void
+delete_key(struct hash_table *table, unsigned int key) {
+  size_t index = find_index(table, key);
+  if (index == table->size) return;
+
+  // Backward shift: pull every following key that isn't home yet one bin closer to home, until we hit a free bin or a
+  // key that's already home.
+  for (size_t next = next_index(table, index); table->table[next].psl > 1; next = next_index(table, next)) {
+    table->table[index] = table->table[next];
+    table->table[index].psl--;
+    index = next;
+  }
+  table->table[index].psl = 0;
+
+  table->count--;
+}
+
+#ifdef WITH_METRICS
+#include <stdio.h>
+void
+print_metrics(struct hash_table *table) {
+  // Probe length distribution, that's what Robin Hood is supposed to keep in check.
+  double sum = 0, sum_of_squares = 0;
+  unsigned int max = 0;
+  for (size_t i = 0; i < table->size; ++i) {
+    unsigned int psl = table->table[i].psl;
+    if (!psl) continue;
+    sum += psl;
+    sum_of_squares += (double)psl * psl;
+    if (psl > max) max = psl;
+  }
+  double mean = table->count ? sum / table->count : 0;
+  double variance = table->count ? sum_of_squares / table->count - mean * mean : 0;
+
+  printf("Total stats:\n");
+  printf("            Count: %zu\n", table->count);
+  printf("       Collisions: %zu\n", table->collisions);
+  printf("Mean probe length: %.3f\n", mean);
+  printf(" Probe length var: %.3f\n", variance);
+  printf(" Max probe length: %u\n", max);
+}
+#endif
@@ -0,0 +1,56 @@
+#ifndef ROBIN_HOOD_H
+#define ROBIN_HOOD_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+/*
+ * Linear probing, Robin Hood style.
+ *
+ * Every bin remembers how far its key is from its home bin (its probe sequence length). On insert, whenever we run
+ * into a key that's closer to home than the one we're carrying, they swap places and we carry on with the richer one.
+ * That keeps probe lengths evenly spread instead of a few keys ending up miles from home.
+ *
+ * It also means a lookup can stop early: once the key we're looking for would be further from home than the key
+ * sitting in the bin, it would have taken that bin, so it isn't in the table.
+ *
+ * Deletes don't leave tombstones (is_deleted in open_addressing.h). Instead the keys after the deleted one are shifted
+ * back one bin until we hit an empty bin or a key that's already home. So the table never fills up with tombstones no
+ * matter how much churn it sees, and probe lengths stay what they'd be on a fresh table.
+ */
+
+struct bin {
+  unsigned int key;
+  // Probe sequence length + 1, so 0 means the bin is free and 1 means the key is in its home bin.
+  unsigned int psl;
+};
+
+struct hash_table {
+  struct bin *table;
+  size_t size;
+  size_t count;
+  uint8_t mersenne_prime_power;
+#ifdef WITH_METRICS
+  size_t collisions;
+#endif
+};
+
+struct hash_table *
+empty_table(uint8_t mersenne_prime_power);
+void
+delete_table(struct hash_table *table);
+
+void
+insert_key(struct hash_table *table, unsigned int key);
+bool
+contains_key(struct hash_table *table, unsigned int key);
+void
+delete_key(struct hash_table *table, unsigned int key);
+
+#ifdef WITH_METRICS
+void
+print_metrics(struct hash_table *table);
+#endif
+
+#endif
@@ -0,0 +1,225 @@
+#include "sharded_table.h"
+
+#include <sched.h>
+#include <string.h>
+
+#include "hash_table_helper.h"
+
+struct sharded_table *
+new_sharded_table(uint8_t shard_bits, uint8_t mersenne_prime_power) {
+  if (shard_bits > MAX_SHARD_BITS) return NULL;
+
+  struct sharded_table *table = malloc(sizeof *table);
+  size_t shards = (size_t)1 << shard_bits;
+  struct shard *shard = aligned_alloc(_Alignof(struct shard), shards * sizeof *shard);
+  // Sadly malloc can fail.
+  if (!table || !shard) goto error;
+
+  table->shard_bits = shard_bits;
+  table->shards = shard;
+  for (size_t i = 0; i < shards; ++i) {
+    shard[i].table = new_table(mersenne_prime_power, (1ULL << mersenne_prime_power) - 1);
+    if (!shard[i].table) {
+      while (i--) {
+        delete_table(shard[i].table);
+        pthread_mutex_destroy(&shard[i].lock);
+      }
+      goto error;
+    }
+    pthread_mutex_init(&shard[i].lock, NULL);
+  }
+  return table;
+
+error:
+  free(table);
+  free(shard);
+  return NULL;
+}
+
+void
+delete_sharded_table(struct sharded_table *table) {
+  for (size_t i = 0; i < shard_count(table); ++i) {
+    delete_table(table->shards[i].table);
+    pthread_mutex_destroy(&table->shards[i].lock);
+  }
+  free(table->shards);
+  free(table);
+}
+
+/*
+ * Locked.
+ */
+
+void
+sharded_insert_key(struct sharded_table *table, unsigned int key) {
+  struct shard *shard = &table->shards[shard_index(table, key)];
+  pthread_mutex_lock(&shard->lock);
+  insert_key(shard->table, key);
+  pthread_mutex_unlock(&shard->lock);
+}
+
+bool
+sharded_contains_key(struct sharded_table *table, unsigned int key) {
+  struct shard *shard = &table->shards[shard_index(table, key)];
+  pthread_mutex_lock(&shard->lock);
+  bool found = contains_key(shard->table, key);
+  pthread_mutex_unlock(&shard->lock);
+  return found;
+}
+
+void
+sharded_delete_key(struct sharded_table *table, unsigned int key) {
+  struct shard *shard = &table->shards[shard_index(table, key)];
+  pthread_mutex_lock(&shard->lock);
+  delete_key(shard->table, key);
+  pthread_mutex_unlock(&shard->lock);
+}
+
+size_t
+sharded_count(struct sharded_table *table) {
+  size_t count = 0;
+  for (size_t i = 0; i < shard_count(table); ++i) count += table->shards[i].table->count;
+  return count;
+}
+
+/*
+ * Shared-nothing.
+ *
+ * A request is the key in the low 32 bits, the op in the next 2 and the index into the sender's ops in the top 30. An
+ * answer is just the index, and only hits get one: the owner pushes the answer before it pops the request, so once a
+ * sender's requests are all popped its answers are all in too.
+ */
+
+// Operations between two looks at what the others sent.
+#define SERVE_EVERY 64
+
+struct shard_group *
+new_shard_group(struct sharded_table *table, int threads) {
+  struct shard_group *group = aligned_alloc(_Alignof(struct shard_group), sizeof *group);
+  size_t queues = (size_t)threads * threads;
+  struct spsc_queue *requests = aligned_alloc(_Alignof(struct spsc_queue), queues * sizeof *requests);
+  struct spsc_queue *answers = aligned_alloc(_Alignof(struct spsc_queue), queues * sizeof *answers);
+  size_t *runs = calloc(threads, sizeof *runs);
+  // Sadly malloc can fail.
+  if (!group || !requests || !answers || !runs) goto error;
+
+  for (size_t i = 0; i < queues; ++i) {
+    init_spsc_queue(&requests[i]);
+    init_spsc_queue(&answers[i]);
+  }
+  group->table = table;
+  group->threads = threads;
+  group->requests = requests;
+  group->answers = answers;
+  group->runs = runs;
+  atomic_init(&group->finished, 0);
+  return group;
+
+error:
+  free(group);
+  free(requests);
+  free(answers);
+  free(runs);
+  return NULL;
+}
+
+void
+delete_shard_group(struct shard_group *group) {
+  free(group->requests);
+  free(group->answers);
+  free(group->runs);
+  free(group);
+}
+
+static inline bool
+do_op(struct hash_table *table, enum shard_op op, unsigned int key) {
+  switch (op) {
+  case SHARD_CONTAINS:
+    return contains_key(table, key);
+  case SHARD_INSERT:
+    insert_key(table, key);
+    break;
+  case SHARD_DELETE:
+    delete_key(table, key);
+    break;
+  }
+  return false;
+}
+
+static void
+collect_answers(struct shard_group *group, int id, uint64_t *out_bitmap) {
+  for (int owner = 0; owner < group->threads; ++owner) {
+    struct spsc_queue *answers = &group->answers[owner * group->threads + id];
+    uint64_t index;
+    while (spsc_peek(answers, &index)) {
+      out_bitmap[index / 64] |= 1ULL << (index % 64);
+      spsc_pop(answers);
+    }
+  }
+}
+
+// Does what the other threads sent us, and picks up the answers to what we sent them.
+static void
+serve(struct shard_group *group, int id, uint64_t *out_bitmap) {
+  for (int from = 0; from < group->threads; ++from) {
+    struct spsc_queue *requests = &group->requests[from * group->threads + id];
+    struct spsc_queue *answers = &group->answers[id * group->threads + from];
+    uint64_t request;
+    while (spsc_peek(requests, &request)) {
+      unsigned int key = (unsigned int)request;
+      enum shard_op op = (enum shard_op)((request >> 32) & 3);
+      struct hash_table *table = group->table->shards[shard_index(group->table, key)].table;
+      // No room for the answer, leave the request for later. Lookups don't change anything, it can be done again.
+      if (do_op(table, op, key) && !spsc_push(answers, request >> 34)) break;
+      spsc_pop(requests);
+    }
+  }
+  collect_answers(group, id, out_bitmap);
+}
+
+// For when we're waiting on the others: keep them going (they might be waiting on us), and give up the core in case
+// one of them needs it to get anywhere.
+static void
+serve_and_yield(struct shard_group *group, int id, uint64_t *out_bitmap) {
+  serve(group, id, out_bitmap);
+  sched_yield();
+}
+
+void
+run_shard_ops(struct shard_group *group, int id, const enum shard_op *ops, const unsigned int *keys, size_t n,
+              uint64_t *out_bitmap) {
+  struct sharded_table *table = group->table;
+  int threads = group->threads;
+  size_t finished = ++group->runs[id] * threads;
+  memset(out_bitmap, 0, (n + 63) / 64 * sizeof *out_bitmap);
+
+  // A window of MAX_SHARD_OPS at a time, requests carry their index within it. All of a window's answers are in before
+  // the next one starts, so an index is never ambiguous.
+  for (size_t base = 0; base < n; base += MAX_SHARD_OPS) {
+    size_t end = n - base > MAX_SHARD_OPS ? base + MAX_SHARD_OPS : n;
+    uint64_t *bitmap = out_bitmap + base / 64;
+
+    for (size_t i = base; i < end; ++i) {
+      size_t shard = shard_index(table, keys[i]);
+      int owner = shard % threads;
+      if (owner == id) {
+        if (do_op(table->shards[shard].table, ops[i], keys[i])) out_bitmap[i / 64] |= 1ULL << (i % 64);
+      } else {
+        uint64_t request = keys[i] | (uint64_t)ops[i] << 32 | (uint64_t)(i - base) << 34;
+        // Full, the owner is behind.
+        while (!spsc_push(&group->requests[id * threads + owner], request)) serve_and_yield(group, id, bitmap);
+      }
+      if (i % SERVE_EVERY == SERVE_EVERY - 1) serve(group, id, bitmap);
+    }
+
+    // Wait for our requests to be done, their answers are in once they are.
+    for (int owner = 0; owner < threads; ++owner) {
+      while (!spsc_drained(&group->requests[id * threads + owner])) serve_and_yield(group, id, bitmap);
+    }
+    collect_answers(group, id, bitmap);
+  }
+
+  // The others may still need us.
+  atomic_fetch_add(&group->finished, 1);
+  while (atomic_load(&group->finished) < finished) serve_and_yield(group, id, out_bitmap);
+}
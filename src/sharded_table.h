@@ -0,0 +1,113 @@
+#ifndef SHARDED_TABLE_H
+#define SHARDED_TABLE_H
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "hash_table.h"
+#include "spsc_queue.h"
+
+/*
+ * 2^k independent chaining tables (hash_table.c) behind one front end.
+ *
+ * The top k bits of a Fibonacci hash of the key (see hash_table_helper.h) pick the shard, the shard's own table then
+ * uses hash_bin_index as usual. Those are unrelated, so every shard gets an even share of the keys and still uses all
+ * of its bins. Each shard has its own bins and its own slab allocator, and the shard headers are cache line aligned so
+ * threads working on different shards never share a line.
+ *
+ * There are two ways to use it from many threads:
+ *
+ *   Locked          sharded_insert_key and friends, from any thread. Every shard has its own mutex, so threads only
+ *                   wait for each other on the same shard.
+ *
+ *   Shared-nothing  A shard_group of n threads, thread i owns every shard s with s % n == i and is the only one that
+ *                   ever touches them, no locks. run_shard_ops runs a thread's operations: the ones on its own shards
+ *                   right away, the others go to their owner through an SPSC queue (one per pair of threads, see
+ *                   spsc_queue.h), and lookup hits come back the same way. While it's waiting on a queue a thread
+ *                   works through what the others sent it, so nobody stalls.
+ *
+ * Key 0 can't be inserted, same as hash_table.c.
+ */
+
+#define MAX_SHARD_BITS 16
+
+struct shard {
+  _Alignas(64) pthread_mutex_t lock;
+  struct hash_table *table;
+};
+
+struct sharded_table {
+  uint8_t shard_bits;
+  struct shard *shards;
+};
+
+// 2^shard_bits shards, each starting out with 2^mersenne_prime_power - 1 bins.
+struct sharded_table *
+new_sharded_table(uint8_t shard_bits, uint8_t mersenne_prime_power);
+
+void
+delete_sharded_table(struct sharded_table *table);
+
+static inline size_t
+shard_count(const struct sharded_table *table) {
+  return (size_t)1 << table->shard_bits;
+}
+
+static inline size_t
+shard_index(const struct sharded_table *table, unsigned int key) {
+  return reduce_index(key, INDEX_FIBONACCI, table->shard_bits, 0);
+}
+
+// Locked mode.
+void
+sharded_insert_key(struct sharded_table *table, unsigned int key);
+
+bool
+sharded_contains_key(struct sharded_table *table, unsigned int key);
+
+void
+sharded_delete_key(struct sharded_table *table, unsigned int key);
+
+// Keys in every shard, only exact while no one's inserting or deleting.
+size_t
+sharded_count(struct sharded_table *table);
+
+// Shared-nothing mode.
+enum shard_op { SHARD_CONTAINS, SHARD_INSERT, SHARD_DELETE };
+
+// Requests carry the index of their operation next to the key in a queue entry, which leaves 30 bits. run_shard_ops
+// goes through longer runs this many operations at a time. A multiple of 64, and at most 2^30.
+#ifndef MAX_SHARD_OPS
+#define MAX_SHARD_OPS (1UL << 30)
+#endif
+
+struct shard_group {
+  struct sharded_table *table;
+  int threads;
+  // requests[from * threads + to], answers[to * threads + from] (lookup hits, going back).
+  struct spsc_queue *requests;
+  struct spsc_queue *answers;
+  // How many times each thread has called run_shard_ops, only ever touched by that thread.
+  size_t *runs;
+  // Threads done with their part of each run so far, counting up across runs.
+  _Alignas(64) atomic_size_t finished;
+};
+
+struct shard_group *
+new_shard_group(struct sharded_table *table, int threads);
+
+void
+delete_shard_group(struct shard_group *group);
+
+/*
+ * Called by thread id (0 to threads - 1), every one of them has to call it for the run to finish. Does ops[i] on
+ * keys[i] for every i < n, and sets bit i of out_bitmap (room for n bits, cleared first) if ops[i] is a lookup that
+ * found its key. Returns once every thread's operations are done.
+ */
+void
+run_shard_ops(struct shard_group *group, int id, const enum shard_op *ops, const unsigned int *keys, size_t n,
+              uint64_t *out_bitmap);
+
+#endif
@@ -0,0 +1,106 @@
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/*
+ * Snapshot files, whatever table they're for.
+ *
+ * A snapshot is a SNAPSHOT_HEADER_SIZE byte header followed by the table's arrays exactly as they are in memory. Each
+ * table has its own header struct, starting with a magic number of its own and a version, and that's all the header
+ * zeroes past it. The payload starts on a page boundary, so the file can be mmap'd and the table pointed straight at
+ * it. See save_table in open_addressing.h and save_frozen_table in frozen_table.h.
+ */
+#define SNAPSHOT_HEADER_SIZE 4096
+
+// A multiply and an xorshift per 8 bytes, so it keeps up with reading the file. Only meant to catch a damaged file.
+static inline uint64_t
+snapshot_checksum(const void *data, size_t length) {
+  const unsigned char *bytes = data;
+  uint64_t hash = length;
+  size_t i = 0;
+  for (; i + 8 <= length; i += 8) {
+    uint64_t word;
+    memcpy(&word, bytes + i, 8);
+    hash = (hash ^ word) * 0x9E3779B97F4A7C15ULL;
+    hash ^= hash >> 32;
+  }
+  for (; i < length; ++i) hash = (hash ^ bytes[i]) * 0x9E3779B97F4A7C15ULL;
+  return hash;
+}
+
+// write() can stop short, and big writes do.
+static inline bool
+snapshot_write_all(int fd, const void *buffer, size_t length) {
+  const char *next = buffer;
+  while (length) {
+    ssize_t written = write(fd, next, length);
+    if (written < 0) {
+      if (errno == EINTR) continue;
+      return false;
+    }
+    next += written;
+    length -= (size_t)written;
+  }
+  return true;
+}
+
+// Writes header (padded with zeroes to SNAPSHOT_HEADER_SIZE) and payload to path. The file is written next to path and
+// renamed over it once it's complete, so path is never half written. False if anything went wrong, errno says what.
+static inline bool
+write_snapshot(const char *path, const void *header, size_t header_length, const void *payload, size_t payload_length) {
+  static const unsigned char zeroes[SNAPSHOT_HEADER_SIZE];
+  size_t length = strlen(path) + sizeof ".tmp";
+  char *temporary = malloc(length);
+  // Sadly malloc can fail.
+  if (!temporary) return false;
+  snprintf(temporary, length, "%s.tmp", path);
+
+  int fd = open(temporary, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+  bool saved = fd >= 0 && snapshot_write_all(fd, header, header_length) &&
+               snapshot_write_all(fd, zeroes, SNAPSHOT_HEADER_SIZE - header_length) &&
+               snapshot_write_all(fd, payload, payload_length);
+  // On disk before it replaces the old one, otherwise a crash could leave us with neither.
+  saved = saved && fsync(fd) == 0;
+  if (fd >= 0 && close(fd) != 0) saved = false;
+  saved = saved && rename(temporary, path) == 0;
+  if (!saved) {
+    int error = errno;
+    unlink(temporary);
+    errno = error;
+  }
+  free(temporary);
+  return saved;
+}
+
+// The whole file at path mapped, its length in *length. Read only, or if writable, private: writes land in the
+// process's own copy of the page and never reach the file. NULL if it can't be mapped or is shorter than a header. The
+// header isn't checked, that's up to the table. munmap it when done.
+static inline void *
+map_snapshot(const char *path, bool writable, size_t *length) {
+  int fd = open(path, O_RDONLY);
+  if (fd < 0) return NULL;
+  struct stat st;
+  void *mapping = MAP_FAILED;
+  if (fstat(fd, &st) == 0 && st.st_size >= SNAPSHOT_HEADER_SIZE)
+    mapping = writable ? mmap(NULL, st.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0)
+                       : mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+  // The mapping keeps the file open.
+  close(fd);
+  if (mapping == MAP_FAILED) return NULL;
+  *length = st.st_size;
+  // Lookups land all over the file, reading ahead around each one would only bring in pages nobody asked for.
+  madvise(mapping, *length, MADV_RANDOM);
+  return mapping;
+}
+
+#endif
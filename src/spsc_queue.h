@@ -0,0 +1,82 @@
+#ifndef SPSC_QUEUE_H
+#define SPSC_QUEUE_H
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * A ring of 64 bit entries between exactly one producer thread and one consumer thread, no locks.
+ *
+ * head and tail only ever go up (they're wrapped when indexing), each one is written by one side only and they sit on
+ * their own cache lines. Each side also keeps its own copy of the other side's index and only reloads it when the ring
+ * looks full (or empty) from that copy, so most pushes and pops don't touch the other side's line at all.
+ *
+ * The consumer looks at an entry with spsc_peek and only lets go of it with spsc_pop, so "the ring is empty" means
+ * the consumer is done with everything that was pushed, not just that it's seen it.
+ */
+
+// A power of two.
+#ifndef SPSC_QUEUE_SIZE
+#define SPSC_QUEUE_SIZE 1024
+#endif
+
+struct spsc_queue {
+  // Written by the consumer.
+  _Alignas(64) atomic_size_t head;
+  size_t cached_tail;
+  // Written by the producer.
+  _Alignas(64) atomic_size_t tail;
+  size_t cached_head;
+  _Alignas(64) uint64_t entries[SPSC_QUEUE_SIZE];
+};
+
+static inline void
+init_spsc_queue(struct spsc_queue *queue) {
+  atomic_init(&queue->head, 0);
+  atomic_init(&queue->tail, 0);
+  queue->cached_tail = 0;
+  queue->cached_head = 0;
+}
+
+// Producer only. False if the ring is full.
+static inline bool
+spsc_push(struct spsc_queue *queue, uint64_t entry) {
+  size_t tail = atomic_load_explicit(&queue->tail, memory_order_relaxed);
+  if (tail - queue->cached_head == SPSC_QUEUE_SIZE) {
+    queue->cached_head = atomic_load_explicit(&queue->head, memory_order_acquire);
+    if (tail - queue->cached_head == SPSC_QUEUE_SIZE) return false;
+  }
+  queue->entries[tail & (SPSC_QUEUE_SIZE - 1)] = entry;
+  atomic_store_explicit(&queue->tail, tail + 1, memory_order_release);
+  return true;
+}
+
+// Consumer only. False if the ring is empty, otherwise the oldest entry stays where it is until spsc_pop.
+static inline bool
+spsc_peek(struct spsc_queue *queue, uint64_t *entry) {
+  size_t head = atomic_load_explicit(&queue->head, memory_order_relaxed);
+  if (head == queue->cached_tail) {
+    queue->cached_tail = atomic_load_explicit(&queue->tail, memory_order_acquire);
+    if (head == queue->cached_tail) return false;
+  }
+  *entry = queue->entries[head & (SPSC_QUEUE_SIZE - 1)];
+  return true;
+}
+
+// Consumer only, after a successful spsc_peek.
+static inline void
+spsc_pop(struct spsc_queue *queue) {
+  atomic_store_explicit(&queue->head, atomic_load_explicit(&queue->head, memory_order_relaxed) + 1,
+                        memory_order_release);
+}
+
+// Producer only. True once the consumer has popped everything pushed so far.
+static inline bool
+spsc_drained(struct spsc_queue *queue) {
+  return atomic_load_explicit(&queue->head, memory_order_acquire) ==
+         atomic_load_explicit(&queue->tail, memory_order_relaxed);
+}
+
+#endif
@@ -0,0 +1,263 @@
+#include "swiss_table.h"
+
+#include <assert.h>
+#include <string.h>
+
+#include "hash_table_helper.h"
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+// The bin index already uses the low bits of the key (mod 2^s - 1), so the fingerprint comes from a multiplicative
+// hash's top 7 bits instead, otherwise keys in the same bin would mostly share a fingerprint.
+static inline uint8_t
+fingerprint(unsigned int key) {
+  return (uint8_t)((key * 0x9E3779B1u) >> 25);
+}
+
+/*
+ * Group matching. Each returns a bitmask with bit i set if ctrl[i] matches.
+ */
+#ifdef __SSE2__
+static inline uint32_t
+group_match(const uint8_t *ctrl, uint8_t h2) {
+  __m128i group = _mm_loadu_si128((const __m128i *)ctrl);
+  return (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(group, _mm_set1_epi8((char)h2)));
+}
+
+static inline uint32_t
+group_match_empty(const uint8_t *ctrl) {
+  return group_match(ctrl, CTRL_EMPTY);
+}
+
+// Both CTRL_EMPTY and CTRL_DELETED have the top bit set and full slots don't, so that's just movemask.
+static inline uint32_t
+group_match_empty_or_deleted(const uint8_t *ctrl) {
+  return (uint32_t)_mm_movemask_epi8(_mm_loadu_si128((const __m128i *)ctrl));
+}
+#else
+static inline uint32_t
+group_match(const uint8_t *ctrl, uint8_t h2) {
+  uint32_t mask = 0;
+  for (int i = 0; i < GROUP_WIDTH; i++) mask |= (uint32_t)(ctrl[i] == h2) << i;
+  return mask;
+}
+
+static inline uint32_t
+group_match_empty(const uint8_t *ctrl) {
+  return group_match(ctrl, CTRL_EMPTY);
+}
+
+static inline uint32_t
+group_match_empty_or_deleted(const uint8_t *ctrl) {
+  uint32_t mask = 0;
+  for (int i = 0; i < GROUP_WIDTH; i++) mask |= (uint32_t)(ctrl[i] >> 7) << i;
+  return mask;
+}
+#endif
+
+static inline size_t
+slot_index(const struct hash_table *table, size_t group, unsigned int offset) {
+  size_t index = group + offset;
+  return index >= table->size ? index - table->size : index;
+}
+
+static inline size_t
+next_group(const struct hash_table *table, size_t group) {
+  group += GROUP_WIDTH;
+  return group >= table->size ? group - table->size : group;
+}
+
+static inline void
+set_ctrl(struct hash_table *table, size_t index, uint8_t value) {
+  table->ctrl[index] = value;
+  // Keep the mirrored tail in sync.
+  if (index < GROUP_WIDTH - 1) table->ctrl[table->size + index] = value;
+}
+
+// Returns the slot holding key, or table->size if it's not there.
+static size_t
+find_slot(struct hash_table *table, unsigned int key) {
+  uint8_t h2 = fingerprint(key);
+  size_t group = hash_bin_index(key, table->mersenne_prime_power);
+  size_t groups = (table->size + GROUP_WIDTH - 1) / GROUP_WIDTH;
+
+  for (size_t probe = 0; probe < groups; ++probe) {
+    const uint8_t *ctrl = table->ctrl + group;
+    for (uint32_t match = group_match(ctrl, h2); match; match &= match - 1) {
+      size_t index = slot_index(table, group, __builtin_ctz(match));
+      if (table->keys[index] == key) return index;
+#ifdef WITH_METRICS
+      table->false_positives++;
+#endif
+    }
+    // An empty slot means the key would have been put here (or earlier) if it existed.
+    if (group_match_empty(ctrl)) break;
+    group = next_group(table, group);
+  }
+  return table->size;
+}
+
+struct hash_table *
+empty_table(uint8_t mersenne_prime_power) {
+  assert(mersenne_prime_power >= 5);
+
+  struct hash_table *table = (struct hash_table *)malloc(sizeof *table);
+  size_t size = (1ULL << mersenne_prime_power) - 1;
+  uint8_t *ctrl = (uint8_t *)malloc(size + GROUP_WIDTH - 1);
+  unsigned int *keys = (unsigned int *)malloc(size * sizeof *keys);
+
+  // Sadly malloc can fail.
+  if (!table || !ctrl || !keys) goto error;
+
+  // Only the control bytes need initializing, keys are only ever read behind a full control byte.
+  memset(ctrl, CTRL_EMPTY, size + GROUP_WIDTH - 1);
+  *table = (struct hash_table){.ctrl = ctrl,
+                               .keys = keys,
+                               .size = size,
+                               .count = 0,
+                               .tombstones = 0,
+                               .mersenne_prime_power = mersenne_prime_power};
+
+  return table;
+
+error:
+  free(table);
+  free(ctrl);
+  free(keys);
+  return NULL;
+}
+
+void
+delete_table(struct hash_table *table) {
+  free(table->ctrl);
+  free(table->keys);
+  free(table);
+}
+
+// Puts a key we know isn't in the table yet into the first empty slot of its probe sequence.
+static void
+place_new_key(struct hash_table *table, uint8_t *ctrl, unsigned int *keys, unsigned int key) {
+  size_t group = hash_bin_index(key, table->mersenne_prime_power);
+  uint32_t available;
+  while (!(available = group_match_empty_or_deleted(ctrl + group))) group = next_group(table, group);
+
+  size_t index = slot_index(table, group, __builtin_ctz(available));
+  ctrl[index] = fingerprint(key);
+  if (index < GROUP_WIDTH - 1) ctrl[table->size + index] = ctrl[index];
+  keys[index] = key;
+}
+
+// Rebuilds the table at the same size, without the tombstones.
+static void
+drop_tombstones(struct hash_table *table) {
+  uint8_t *ctrl = (uint8_t *)malloc(table->size + GROUP_WIDTH - 1);
+  unsigned int *keys = (unsigned int *)malloc(table->size * sizeof *keys);
+  if (!ctrl || !keys) {
+    // Keep going with the tombstones, it's only slower.
+    free(ctrl);
+    free(keys);
+    return;
+  }
+  memset(ctrl, CTRL_EMPTY, table->size + GROUP_WIDTH - 1);
+
+  for (size_t i = 0; i < table->size; ++i) {
+    if (!(table->ctrl[i] & CTRL_EMPTY)) place_new_key(table, ctrl, keys, table->keys[i]);
+  }
+
+  free(table->ctrl);
+  free(table->keys);
+  table->ctrl = ctrl;
+  table->keys = keys;
+  table->tombstones = 0;
+#ifdef WITH_METRICS
+  table->rehashes++;
+#endif
+}
+
+void
+insert_key(struct hash_table *table, unsigned int key) {
+  uint8_t h2 = fingerprint(key);
+  size_t group = hash_bin_index(key, table->mersenne_prime_power);
+  size_t groups = (table->size + GROUP_WIDTH - 1) / GROUP_WIDTH;
+  // First empty or deleted slot seen, that's where the key goes if it's not already in here.
+  size_t target = table->size;
+
+  for (size_t probe = 0; probe < groups; ++probe) {
+    const uint8_t *ctrl = table->ctrl + group;
+    for (uint32_t match = group_match(ctrl, h2); match; match &= match - 1) {
+      // No duplicates
+      if (table->keys[slot_index(table, group, __builtin_ctz(match))] == key) return;
+#ifdef WITH_METRICS
+      table->false_positives++;
+#endif
+    }
+
+    uint32_t available = group_match_empty_or_deleted(ctrl);
+    if (target == table->size && available) target = slot_index(table, group, __builtin_ctz(available));
+    if (group_match_empty(ctrl)) break;
+
+#ifdef WITH_METRICS
+    // Had to move on to the next group.
+    table->collisions++;
+#endif
+    group = next_group(table, group);
+  }
+
+  // Table is full.
+  if (target == table->size) return;
+
+  if (table->ctrl[target] == CTRL_DELETED) {
+    table->tombstones--;
+  } else if (table->tombstones && (table->count + table->tombstones + 1) * 8 > table->size * 7) {
+    // About to use up one more empty slot with too many tombstones around, clean them up first. The key isn't in the
+    // table, so it can go straight into its new spot.
+    drop_tombstones(table);
+    place_new_key(table, table->ctrl, table->keys, key);
+    table->count++;
+    return;
+  }
+
+  set_ctrl(table, target, h2);
+  table->keys[target] = key;
+  table->count++;
+}
+
+bool
+contains_key(struct hash_table *table, unsigned int key) {
+  return find_slot(table, key) != table->size;
+}
+
+void
+delete_key(struct hash_table *table, unsigned int key) {
+  size_t index = find_slot(table, key);
+  if (index == table->size) return;
+
+  /*
+   * A probe only ever went past this slot if it loaded 16 control bytes containing it with no empty one among them. So
+   * if the run of non-empty slots around it is shorter than a group, no probe could have, and the slot can go straight
+   * back to empty. Otherwise it needs a tombstone. (Same check abseil does.)
+   */
+  size_t before = index >= GROUP_WIDTH ? index - GROUP_WIDTH : index + table->size - GROUP_WIDTH;
+  uint32_t empty_before = group_match_empty(table->ctrl + before);
+  uint32_t empty_after = group_match_empty(table->ctrl + index);
+  bool was_never_full = empty_before && empty_after &&
+                        (__builtin_ctz(empty_after) + __builtin_clz(empty_before << 16)) < GROUP_WIDTH;
+
+  set_ctrl(table, index, was_never_full ? CTRL_EMPTY : CTRL_DELETED);
+  if (!was_never_full) table->tombstones++;
+  table->count--;
+}
+
+#ifdef WITH_METRICS
+#include <stdio.h>
+void
+print_metrics(struct hash_table *table) {
+  printf("Total stats:\n");
+  printf("           Count: %zu\n", table->count);
+  printf("      Collisions: %zu\n", table->collisions);
+  printf(" False positives: %zu\n", table->false_positives);
+  printf("        Rehashes: %zu\n", table->rehashes);
+}
+#endif
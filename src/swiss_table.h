@@ -0,0 +1,66 @@
+#ifndef SWISS_TABLE_H
+#define SWISS_TABLE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+/*
+ * Open addressing, Swiss table style (abseil's flat_hash_set).
+ *
+ * Instead of keeping is_free/is_deleted next to every key like open_addressing.h does, every slot gets one control
+ * byte in a separate array:
+ *   - CTRL_EMPTY   (0x80): never used, ends a probe.
+ *   - CTRL_DELETED (0xFE): tombstone, keep probing.
+ *   - 0x00 - 0x7F       : slot is full, the byte is 7 bits of the key's hash (a fingerprint).
+ *
+ * A probe looks at 16 control bytes at a time with one SSE2 compare, and only reads a key when its fingerprint
+ * matches, which is ~1 in 128 for the wrong keys. So most probes never touch the key array at all.
+ *
+ * The table is still 2^s - 1 slots, probed a group (16 slots) at a time starting from hash_bin_index(key). Since the
+ * size is odd, stepping 16 slots at a time visits every slot before coming back around. To be able to load a group
+ * that runs past the end, the first 15 control bytes are mirrored after the last one.
+ *
+ * The size is fixed. Tombstones do pile up under deletes though, and with no empty slots left every miss would probe
+ * the whole table, so once full + deleted slots reach 7/8 of the table it's rebuilt without them.
+ */
+
+#define GROUP_WIDTH 16
+
+#define CTRL_EMPTY ((uint8_t)0x80)
+#define CTRL_DELETED ((uint8_t)0xFE)
+
+struct hash_table {
+  // size + GROUP_WIDTH - 1 control bytes, the tail mirrors the first GROUP_WIDTH - 1.
+  uint8_t *ctrl;
+  unsigned int *keys;
+  size_t size;
+  size_t count;
+  size_t tombstones;
+  uint8_t mersenne_prime_power;
+#ifdef WITH_METRICS
+  size_t collisions;
+  size_t false_positives;
+  size_t rehashes;
+#endif
+};
+
+// mersenne_prime_power has to be at least 5, the table has to be bigger than a group.
+struct hash_table *
+empty_table(uint8_t mersenne_prime_power);
+void
+delete_table(struct hash_table *table);
+
+void
+insert_key(struct hash_table *table, unsigned int key);
+bool
+contains_key(struct hash_table *table, unsigned int key);
+void
+delete_key(struct hash_table *table, unsigned int key);
+
+#ifdef WITH_METRICS
+void
+print_metrics(struct hash_table *table);
+#endif
+
+#endif
@@ -0,0 +1,80 @@
+#ifndef TABLE_ALLOC_H
+#define TABLE_ALLOC_H
+
+#include <stdlib.h>
+
+/*
+ * Where the big bin arrays come from.
+ *
+ * Every table here uses all zero bytes for "empty" (NULL chains, a bin with is_used = 0, ...), so all an allocator has
+ * to do is hand out zeroed memory, ideally without touching it. Fresh anonymous pages from the OS are zero already and
+ * only get faulted in on first touch, so a 16 GB table can be created without writing 16 GB.
+ *
+ * By default that's calloc, which gets big allocations straight from mmap anyway. At 2^31 bins though, every probe is
+ * a TLB miss with 4K pages (16 GB is 4M pages, the TLB holds a couple thousand), so:
+ *
+ *   WITH_HUGE_PAGES   mmap with MAP_HUGETLB (2 MB pages from the reserved pool, see vm.nr_hugepages). If there's no
+ *                     pool, plain mmap + madvise(MADV_HUGEPAGE) so transparent huge pages kick in.
+ *   WITH_SMALL_PAGES  mmap + madvise(MADV_NOHUGEPAGE), always 4K pages, to compare against.
+ *
+ * Allocations smaller than a huge page keep using calloc either way. table_free needs the size that was asked for.
+ */
+
+#define HUGE_PAGE_SIZE (2UL << 20)
+
+#if defined(WITH_HUGE_PAGES) || defined(WITH_SMALL_PAGES)
+#include <sys/mman.h>
+
+static inline size_t
+table_alloc_length(size_t bytes) {
+  return (bytes + HUGE_PAGE_SIZE - 1) & ~(HUGE_PAGE_SIZE - 1);
+}
+
+static inline void *
+table_alloc(size_t bytes) {
+  if (bytes < HUGE_PAGE_SIZE) return calloc(1, bytes);
+
+  size_t length = table_alloc_length(bytes);
+  void *memory = MAP_FAILED;
+#if defined(WITH_HUGE_PAGES) && defined(MAP_HUGETLB)
+  memory = mmap(NULL, length, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+#endif
+  if (memory == MAP_FAILED) {
+    memory = mmap(NULL, length, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (memory == MAP_FAILED) return NULL;
+    // Only a hint, nothing to do if it doesn't work out :shrug:
+#if defined(WITH_HUGE_PAGES) && defined(MADV_HUGEPAGE)
+    madvise(memory, length, MADV_HUGEPAGE);
+#elif defined(WITH_SMALL_PAGES) && defined(MADV_NOHUGEPAGE)
+    madvise(memory, length, MADV_NOHUGEPAGE);
+#endif
+  }
+  return memory;
+}
+
+static inline void
+table_free(void *memory, size_t bytes) {
+  if (!memory) return;
+  if (bytes < HUGE_PAGE_SIZE) {
+    free(memory);
+    return;
+  }
+  munmap(memory, table_alloc_length(bytes));
+}
+
+#else
+
+static inline void *
+table_alloc(size_t bytes) {
+  return calloc(1, bytes);
+}
+
+static inline void
+table_free(void *memory, size_t bytes) {
+  (void)bytes;
+  free(memory);
+}
+
+#endif
+
+#endif
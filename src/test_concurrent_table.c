@@ -0,0 +1,200 @@
+/**
+ * Test file for the striped concurrent chaining table in concurrent_table.h
+ *
+ * This file tests the following operations:
+ * - new_concurrent_table() / join_table() / leave_table()
+ * - concurrent_insert_key()
+ * - concurrent_contains_key()
+ * - concurrent_delete_key()
+ * - concurrent_count()
+ *
+ * Build with: gcc -O2 -pthread test_concurrent_table.c concurrent_table.c hash_table.c
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "concurrent_table.h"
+
+// Test counters
+static int tests_passed = 0;
+static int tests_failed = 0;
+
+// Helper macro for test assertions
+#define TEST_ASSERT(condition, test_name) do { \
+    if (condition) { \
+        printf("[PASS] %s\n", test_name); \
+        tests_passed++; \
+    } else { \
+        printf("[FAIL] %s\n", test_name); \
+        tests_failed++; \
+    } \
+} while (0)
+
+#define NUM_THREADS 4
+// Keys every thread owns, and operations every thread does on them.
+#define KEYS_PER_THREAD 4096
+#define OPS_PER_THREAD 200000
+// Inserted before the threads start and never deleted, everyone looks them up all the time.
+#define STABLE_KEYS 1000
+
+// PRNG so every run does the same operations (the interleaving is up to the scheduler).
+static uint64_t xorshift64(uint64_t *state) {
+    uint64_t x = *state;
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+    return *state = x;
+}
+
+// ============================================================================
+// Test: one thread
+// ============================================================================
+void test_single_thread() {
+    printf("\n--- Testing one thread ---\n");
+
+    struct concurrent_table *table = new_concurrent_table(4);
+    TEST_ASSERT(table != NULL, "new_concurrent_table returns non-NULL pointer");
+    struct concurrent_thread *thread = join_table(table);
+    TEST_ASSERT(thread != NULL, "join_table returns non-NULL pointer");
+
+    TEST_ASSERT(!concurrent_contains_key(thread, 42), "new table contains nothing");
+    concurrent_insert_key(thread, 42);
+    concurrent_insert_key(thread, 57);  // 57 % 15 == 42 % 15, same bin
+    concurrent_insert_key(thread, 42);
+    TEST_ASSERT(concurrent_contains_key(thread, 42) && concurrent_contains_key(thread, 57), "inserted keys are found");
+    TEST_ASSERT(concurrent_count(table) == 2, "inserting a key twice counts it once");
+
+    concurrent_insert_key(thread, 0);
+    TEST_ASSERT(!concurrent_contains_key(thread, 0) && concurrent_count(table) == 2, "key 0 is not inserted");
+
+    concurrent_delete_key(thread, 42);
+    concurrent_delete_key(thread, 1000);
+    TEST_ASSERT(!concurrent_contains_key(thread, 42), "deleted key is gone");
+    TEST_ASSERT(concurrent_contains_key(thread, 57), "the other key in its bin is still there");
+    TEST_ASSERT(concurrent_count(table) == 1, "deleting a missing key changes nothing");
+
+    // Enough keys for a few grows, and deletes to go through the limbo lists and back.
+    for (unsigned int key = 1; key <= 100000; ++key) concurrent_insert_key(thread, key);
+    for (unsigned int key = 1; key <= 100000; key += 2) concurrent_delete_key(thread, key);
+    for (unsigned int key = 100001; key <= 150000; ++key) concurrent_insert_key(thread, key);
+    int correct = 0;
+    for (unsigned int key = 1; key <= 150000; ++key)
+        correct += concurrent_contains_key(thread, key) == (key > 100000 || key % 2 == 0);
+    TEST_ASSERT(correct == 150000, "every key is where it should be after growing and reusing links");
+    TEST_ASSERT(concurrent_count(table) == 100000, "table has 100000 keys");
+    TEST_ASSERT(table->bins->mersenne_prime_power > 4, "table grew");
+
+    leave_table(thread);
+    delete_concurrent_table(table);
+}
+
+// ============================================================================
+// Test: threads on disjoint keys
+// ============================================================================
+struct worker {
+    pthread_t id;
+    struct concurrent_table *table;
+    unsigned int first_key;
+    uint64_t seed;
+    // Whether each of the thread's keys should be in the table.
+    bool model[KEYS_PER_THREAD];
+    size_t wrong;
+    size_t stable_missing;
+    int joined;
+};
+
+static void *run_worker(void *arg) {
+    struct worker *worker = arg;
+    struct concurrent_thread *thread = join_table(worker->table);
+    if (!thread) return NULL;
+    worker->joined = 1;
+    uint64_t rng_state = worker->seed;
+
+    for (size_t i = 0; i < OPS_PER_THREAD; ++i) {
+        uint64_t r = xorshift64(&rng_state);
+        size_t k = (r >> 8) % KEYS_PER_THREAD;
+        unsigned int key = worker->first_key + (unsigned int)k;
+        switch (r % 3) {
+        case 0:
+            concurrent_insert_key(thread, key);
+            worker->model[k] = true;
+            break;
+        case 1:
+            concurrent_delete_key(thread, key);
+            worker->model[k] = false;
+            break;
+        default:
+            worker->wrong += concurrent_contains_key(thread, key) != worker->model[k];
+        }
+        // Other threads keep unlinking and reusing links in the same chains, a reader must never be sent off them.
+        worker->stable_missing += !concurrent_contains_key(thread, 1 + (unsigned int)((r >> 40) % STABLE_KEYS));
+    }
+
+    for (size_t k = 0; k < KEYS_PER_THREAD; ++k)
+        worker->wrong += concurrent_contains_key(thread, worker->first_key + (unsigned int)k) != worker->model[k];
+    leave_table(thread);
+    return NULL;
+}
+
+void test_threads() {
+    printf("\n--- Testing %d threads on disjoint keys ---\n", NUM_THREADS);
+
+    // Small enough to grow a few times while the threads are at it.
+    struct concurrent_table *table = new_concurrent_table(4);
+    struct concurrent_thread *thread = join_table(table);
+    for (unsigned int key = 1; key <= STABLE_KEYS; ++key) concurrent_insert_key(thread, key);
+    leave_table(thread);
+
+    struct worker *workers = calloc(NUM_THREADS, sizeof *workers);
+    for (int t = 0; t < NUM_THREADS; ++t) {
+        workers[t].table = table;
+        workers[t].first_key = STABLE_KEYS + 1 + t * KEYS_PER_THREAD;
+        workers[t].seed = 12346 + t;
+        pthread_create(&workers[t].id, NULL, run_worker, &workers[t]);
+    }
+    for (int t = 0; t < NUM_THREADS; ++t) pthread_join(workers[t].id, NULL);
+
+    size_t joined = 0, wrong = 0, stable_missing = 0, expected = STABLE_KEYS;
+    for (int t = 0; t < NUM_THREADS; ++t) {
+        joined += workers[t].joined;
+        wrong += workers[t].wrong;
+        stable_missing += workers[t].stable_missing;
+        for (size_t k = 0; k < KEYS_PER_THREAD; ++k) expected += workers[t].model[k];
+    }
+    TEST_ASSERT(joined == NUM_THREADS, "every thread joined");
+    TEST_ASSERT(wrong == 0, "every lookup agrees with its thread's model");
+    TEST_ASSERT(stable_missing == 0, "keys nobody deletes are always found");
+    TEST_ASSERT(concurrent_count(table) == expected, "count matches the models");
+    TEST_ASSERT(table->bins->mersenne_prime_power > 4, "table grew while the threads were at it");
+
+    free(workers);
+    delete_concurrent_table(table);
+}
+
+// ============================================================================
+// Main test runner
+// ============================================================================
+int main() {
+    printf("===============================================\n");
+    printf("    Concurrent Table Test Suite\n");
+    printf("===============================================\n");
+
+    test_single_thread();
+    test_threads();
+
+    printf("\n===============================================\n");
+    printf("    Test Results Summary\n");
+    printf("===============================================\n");
+    printf("Tests passed: %d\n", tests_passed);
+    printf("Tests failed: %d\n", tests_failed);
+    printf("Total tests:  %d\n", tests_passed + tests_failed);
+    printf("===============================================\n");
+
+    if (tests_failed > 0) {
+        printf("\nSome tests FAILED!\n");
+        return 1;
+    } else {
+        printf("\nAll tests PASSED!\n");
+        return 0;
+    }
+}
@@ -0,0 +1,204 @@
+/**
+ * Test file for frozen chaining tables and their snapshots in frozen_table.h
+ *
+ * This file tests the following operations:
+ * - freeze_table()
+ * - frozen_contains_key() / frozen_contains_keys()
+ * - save_frozen_table()
+ * - map_frozen_table()
+ * - verify_frozen_snapshot()
+ *
+ * Build with: gcc -O2 test_frozen_table.c frozen_table.c hash_table.c
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include "frozen_table.h"
+
+// Test counters
+static int tests_passed = 0;
+static int tests_failed = 0;
+
+// Helper macro for test assertions
+#define TEST_ASSERT(condition, test_name) do { \
+    if (condition) { \
+        printf("[PASS] %s\n", test_name); \
+        tests_passed++; \
+    } else { \
+        printf("[FAIL] %s\n", test_name); \
+        tests_failed++; \
+    } \
+} while (0)
+
+#define SNAPSHOT_PATH "test_frozen_table.bin"
+#define NUM_KEYS 100000
+
+// PRNG so every run uses the same keys.
+static uint64_t xorshift64(uint64_t *state) {
+    uint64_t x = *state;
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+    return *state = x;
+}
+
+// Every key, and as many that were never inserted, gets the same answer from both tables, one at a time and batched.
+static int same_answers(struct hash_table *table, const struct frozen_table *frozen, const unsigned int *keys,
+                        size_t n) {
+    unsigned int *lookups = calloc(2 * n, sizeof *lookups);
+    uint64_t *bitmap = malloc((2 * n + 63) / 64 * sizeof *bitmap);
+    uint64_t rng_state = 54321;
+    for (size_t i = 0; i < n; ++i) {
+        lookups[2 * i] = keys[i];
+        lookups[2 * i + 1] = (unsigned int)xorshift64(&rng_state);
+    }
+    frozen_contains_keys(frozen, lookups, 2 * n, bitmap);
+
+    int same = 1;
+    for (size_t i = 0; i < 2 * n; ++i) {
+        bool expected = contains_key(table, lookups[i]);
+        same &= frozen_contains_key(frozen, lookups[i]) == expected;
+        same &= (bool)(bitmap[i / 64] >> (i % 64) & 1) == expected;
+    }
+    free(lookups);
+    free(bitmap);
+    return same;
+}
+
+static int cut_file(const char *path, off_t length) {
+    return truncate(path, length) == 0;
+}
+
+// Overwrites the 4 bytes at offset in the file at path.
+static void poke_file(const char *path, long offset, uint32_t value) {
+    FILE *file = fopen(path, "r+b");
+    fseek(file, offset, SEEK_SET);
+    fwrite(&value, sizeof value, 1, file);
+    fclose(file);
+}
+
+// ============================================================================
+// Test: freeze_table and frozen snapshots
+// ============================================================================
+void test_freeze_and_map(unsigned int *keys) {
+    printf("\n--- Testing freeze_table, save_frozen_table and map_frozen_table ---\n");
+
+    struct hash_table *table = new_table(16, (1U << 16) - 1);
+    for (size_t i = 0; i < NUM_KEYS; ++i) insert_key(table, keys[i]);
+    for (size_t i = 0; i < NUM_KEYS; i += 3) delete_key(table, keys[i]);
+
+    struct frozen_table *frozen = freeze_table(table);
+    TEST_ASSERT(frozen != NULL, "freeze_table returns non-NULL pointer");
+    TEST_ASSERT(frozen->count == table->count, "frozen table has every key");
+    TEST_ASSERT(same_answers(table, frozen, keys, NUM_KEYS), "every lookup matches the chaining table");
+
+    TEST_ASSERT(save_frozen_table(frozen, SNAPSHOT_PATH), "save_frozen_table succeeds");
+    struct frozen_table *mapped = map_frozen_table(SNAPSHOT_PATH);
+    TEST_ASSERT(mapped != NULL, "map_frozen_table returns non-NULL pointer");
+    TEST_ASSERT(mapped && verify_frozen_snapshot(mapped), "the mapped table matches the checksum");
+    TEST_ASSERT(mapped && same_answers(table, mapped, keys, NUM_KEYS),
+                "every mapped lookup matches the chaining table");
+
+    if (mapped) delete_frozen_table(mapped);
+    delete_frozen_table(frozen);
+    delete_table(table);
+    unlink(SNAPSHOT_PATH);
+}
+
+// ============================================================================
+// Test: freezing a table while it's resizing
+// ============================================================================
+void test_mid_resize(unsigned int *keys) {
+    printf("\n--- Testing a table frozen mid-resize ---\n");
+
+    struct hash_table *table = new_table(10, (1U << 10) - 1);
+    size_t i = 0;
+    // Until a grow starts, and stop before it's done moving the old bins.
+    while (i < NUM_KEYS && !table->old_bins) insert_key(table, keys[i++]);
+    TEST_ASSERT(table->old_bins != NULL, "table is resizing");
+
+    struct frozen_table *frozen = freeze_table(table);
+    TEST_ASSERT(frozen && frozen->count == i, "frozen table has the keys from both sets of bins");
+    TEST_ASSERT(save_frozen_table(frozen, SNAPSHOT_PATH), "save_frozen_table succeeds");
+    struct frozen_table *mapped = map_frozen_table(SNAPSHOT_PATH);
+    TEST_ASSERT(mapped && verify_frozen_snapshot(mapped), "the snapshot maps and verifies");
+    TEST_ASSERT(mapped && same_answers(table, mapped, keys, NUM_KEYS), "every lookup matches the chaining table");
+
+    if (mapped) delete_frozen_table(mapped);
+    if (frozen) delete_frozen_table(frozen);
+    delete_table(table);
+    unlink(SNAPSHOT_PATH);
+}
+
+// ============================================================================
+// Test: files that aren't a whole frozen snapshot
+// ============================================================================
+void test_bad_files(unsigned int *keys) {
+    printf("\n--- Testing truncated and damaged frozen snapshots ---\n");
+
+    struct hash_table *table = new_table(12, (1U << 12) - 1);
+    for (size_t i = 0; i < 1000; ++i) insert_key(table, keys[i]);
+    struct frozen_table *frozen = freeze_table(table);
+    size_t length = SNAPSHOT_HEADER_SIZE + (frozen->size + 1 + frozen->count) * sizeof(uint32_t);
+
+    TEST_ASSERT(map_frozen_table("no_such_snapshot.bin") == NULL, "a missing file maps to NULL");
+
+    save_frozen_table(frozen, SNAPSHOT_PATH);
+    TEST_ASSERT(cut_file(SNAPSHOT_PATH, length - 1) && map_frozen_table(SNAPSHOT_PATH) == NULL,
+                "a file one byte short maps to NULL");
+    TEST_ASSERT(cut_file(SNAPSHOT_PATH, SNAPSHOT_HEADER_SIZE) && map_frozen_table(SNAPSHOT_PATH) == NULL,
+                "a header without offsets maps to NULL");
+
+    // Every offset past the end, a lookup would read way past the mapping.
+    save_frozen_table(frozen, SNAPSHOT_PATH);
+    poke_file(SNAPSHOT_PATH, SNAPSHOT_HEADER_SIZE + frozen->size * sizeof(uint32_t), 0xffffffffu);
+    TEST_ASSERT(map_frozen_table(SNAPSHOT_PATH) == NULL, "offsets that don't end at count map to NULL");
+
+    save_frozen_table(frozen, SNAPSHOT_PATH);
+    poke_file(SNAPSHOT_PATH, length - sizeof(uint32_t), 12345);
+    struct frozen_table *mapped = map_frozen_table(SNAPSHOT_PATH);
+    TEST_ASSERT(mapped != NULL && !verify_frozen_snapshot(mapped), "a damaged key fails verify_frozen_snapshot");
+
+    if (mapped) delete_frozen_table(mapped);
+    delete_frozen_table(frozen);
+    delete_table(table);
+    unlink(SNAPSHOT_PATH);
+}
+
+// ============================================================================
+// Main test runner
+// ============================================================================
+int main() {
+    printf("===============================================\n");
+    printf("    Frozen Table Test Suite\n");
+    printf("===============================================\n");
+
+    unsigned int *keys = malloc(NUM_KEYS * sizeof *keys);
+    uint64_t rng_state = 12346;
+    for (size_t i = 0; i < NUM_KEYS; ++i) {
+        keys[i] = (unsigned int)xorshift64(&rng_state);
+        if (keys[i] == 0) keys[i] = 1;
+    }
+
+    test_freeze_and_map(keys);
+    test_mid_resize(keys);
+    test_bad_files(keys);
+    free(keys);
+
+    printf("\n===============================================\n");
+    printf("    Test Results Summary\n");
+    printf("===============================================\n");
+    printf("Tests passed: %d\n", tests_passed);
+    printf("Tests failed: %d\n", tests_failed);
+    printf("Total tests:  %d\n", tests_passed + tests_failed);
+    printf("===============================================\n");
+
+    if (tests_failed > 0) {
+        printf("\nSome tests FAILED!\n");
+        return 1;
+    } else {
+        printf("\nAll tests PASSED!\n");
+        return 0;
+    }
+}
@@ -0,0 +1,201 @@
+/**
+ * Test file for the intrusive hash table in hlist_table.h
+ *
+ * This file tests the following operations:
+ * - new_hlist_table()
+ * - hlist_table_insert()
+ * - hlist_table_find()
+ * - hlist_table_contains()
+ * - hlist_table_remove()
+ */
+
+#include <stdio.h>
+#include "hlist_table.h"
+
+// Test counters
+static int tests_passed = 0;
+static int tests_failed = 0;
+
+// Helper macro for test assertions
+#define TEST_ASSERT(condition, test_name) do { \
+    if (condition) { \
+        printf("[PASS] %s\n", test_name); \
+        tests_passed++; \
+    } else { \
+        printf("[FAIL] %s\n", test_name); \
+        tests_failed++; \
+    } \
+} while (0)
+
+// The records live in the test, the table only links them.
+struct record {
+    unsigned int key;
+    int value;
+    struct hlist_node node;
+};
+
+static struct hlist_table *new_record_table(uint8_t power) {
+    return new_hlist_table(power, HLIST_KEY_OFFSET(struct record, key, node));
+}
+
+static void init_record(struct record *record, unsigned int key, int value) {
+    record->key = key;
+    record->value = value;
+    INIT_HLIST_NODE(&record->node);
+}
+
+// ============================================================================
+// Test: new_hlist_table
+// ============================================================================
+void test_new_hlist_table() {
+    printf("\n--- Testing new_hlist_table ---\n");
+
+    struct hlist_table *table = new_record_table(4);
+
+    TEST_ASSERT(table != NULL, "new_hlist_table returns non-NULL pointer");
+    TEST_ASSERT(table->size == 15, "table has 2^4 - 1 bins");
+    TEST_ASSERT(table->count == 0, "new table is empty");
+    TEST_ASSERT(!hlist_table_contains(table, 42), "new table contains nothing");
+
+    delete_hlist_table(table);
+}
+
+// ============================================================================
+// Test: hlist_table_insert / hlist_table_find
+// ============================================================================
+void test_insert_and_find() {
+    printf("\n--- Testing hlist_table_insert and hlist_table_find ---\n");
+
+    struct hlist_table *table = new_record_table(4);
+    struct record a, b, c, duplicate;
+    init_record(&a, 1, 10);
+    init_record(&b, 16, 20);  // 16 % 15 == 1, same bin as a
+    init_record(&c, 7, 30);
+    init_record(&duplicate, 1, 40);
+
+    TEST_ASSERT(hlist_table_insert(table, &a.node), "insert first record");
+    TEST_ASSERT(hlist_table_insert(table, &b.node), "insert record colliding with the first one");
+    TEST_ASSERT(hlist_table_insert(table, &c.node), "insert record in another bin");
+    TEST_ASSERT(table->count == 3, "table has 3 records");
+
+    TEST_ASSERT(!hlist_table_insert(table, &duplicate.node), "inserting a duplicate key fails");
+    TEST_ASSERT(hlist_unhashed(&duplicate.node), "rejected node is left unlinked");
+    TEST_ASSERT(table->count == 3, "count unchanged after duplicate insert");
+    hlist_table_remove(table, &duplicate.node);
+    TEST_ASSERT(table->count == 3 && hlist_table_find(table, 1) == &a.node, "removing a rejected node changes nothing");
+
+    struct hlist_node *node = hlist_table_find(table, 16);
+    TEST_ASSERT(node == &b.node, "find returns the node embedded in the record");
+    TEST_ASSERT(hlist_entry(node, struct record, node)->value == 20, "hlist_entry gets back to the record");
+    TEST_ASSERT(hlist_table_find(table, 1) == &a.node, "find returns the other record in the same bin");
+    TEST_ASSERT(hlist_table_find(table, 31) == NULL, "find returns NULL for a missing key in a used bin");
+    TEST_ASSERT(hlist_table_find(table, 3) == NULL, "find returns NULL for a missing key in an empty bin");
+
+    delete_hlist_table(table);
+}
+
+// ============================================================================
+// Test: hlist_table_remove
+// ============================================================================
+void test_remove() {
+    printf("\n--- Testing hlist_table_remove ---\n");
+
+    struct hlist_table *table = new_record_table(4);
+    struct record records[3];
+    // All three end up in bin 1: 1, 16, 31
+    for (int i = 0; i < 3; i++) {
+        init_record(&records[i], 1 + 15 * i, i);
+        hlist_table_insert(table, &records[i].node);
+    }
+    // Bin is now: 31 -> 16 -> 1
+
+    hlist_table_remove(table, &records[1].node);
+    TEST_ASSERT(!hlist_table_contains(table, 16), "removed middle record is gone");
+    TEST_ASSERT(hlist_table_contains(table, 1) && hlist_table_contains(table, 31), "neighbours still there");
+    TEST_ASSERT(hlist_unhashed(&records[1].node), "removed node is re-initialized");
+
+    hlist_table_remove(table, &records[1].node);
+    TEST_ASSERT(table->count == 2, "removing a node twice changes nothing");
+    TEST_ASSERT(hlist_table_contains(table, 1) && hlist_table_contains(table, 31),
+                "neighbours survive a second remove");
+
+    hlist_table_remove(table, &records[2].node);
+    TEST_ASSERT(!hlist_table_contains(table, 31), "removed head record is gone");
+    TEST_ASSERT(hlist_table_bin(table, 1)->first == &records[0].node, "bin head moves to the next record");
+
+    hlist_table_remove(table, &records[0].node);
+    TEST_ASSERT(hlist_empty(hlist_table_bin(table, 1)), "bin is empty after removing every record");
+    TEST_ASSERT(table->count == 0, "table is empty");
+
+    TEST_ASSERT(hlist_table_insert(table, &records[1].node), "removed record can be inserted again");
+    TEST_ASSERT(hlist_table_contains(table, 16), "re-inserted record is found");
+
+    delete_hlist_table(table);
+}
+
+// ============================================================================
+// Test: Large number of records
+// ============================================================================
+void test_many_records() {
+    printf("\n--- Testing with many records ---\n");
+
+    const int NUM_RECORDS = 10000;
+    struct hlist_table *table = new_record_table(10);
+    struct record *records = malloc(NUM_RECORDS * sizeof *records);
+
+    for (int i = 0; i < NUM_RECORDS; i++) {
+        init_record(&records[i], (unsigned int)i * 2654435761u, i);
+        hlist_table_insert(table, &records[i].node);
+    }
+    TEST_ASSERT(table->count == (size_t)NUM_RECORDS, "table has 10000 records");
+
+    int found = 0;
+    for (int i = 0; i < NUM_RECORDS; i++) {
+        found += hlist_table_find(table, records[i].key) == &records[i].node;
+    }
+    TEST_ASSERT(found == NUM_RECORDS, "every record is found");
+
+    // Remove every other record
+    for (int i = 0; i < NUM_RECORDS; i += 2) {
+        hlist_table_remove(table, &records[i].node);
+    }
+    int correct = 0;
+    for (int i = 0; i < NUM_RECORDS; i++) {
+        correct += hlist_table_contains(table, records[i].key) == (i % 2 == 1);
+    }
+    TEST_ASSERT(correct == NUM_RECORDS, "only the odd records are left");
+    TEST_ASSERT(table->count == (size_t)NUM_RECORDS / 2, "table has 5000 records");
+
+    free(records);
+    delete_hlist_table(table);
+}
+
+// ============================================================================
+// Main test runner
+// ============================================================================
+int main() {
+    printf("===============================================\n");
+    printf("    HLIST Hash Table Test Suite\n");
+    printf("===============================================\n");
+
+    test_new_hlist_table();
+    test_insert_and_find();
+    test_remove();
+    test_many_records();
+
+    printf("\n===============================================\n");
+    printf("    Test Results Summary\n");
+    printf("===============================================\n");
+    printf("Tests passed: %d\n", tests_passed);
+    printf("Tests failed: %d\n", tests_failed);
+    printf("Total tests:  %d\n", tests_passed + tests_failed);
+    printf("===============================================\n");
+
+    if (tests_failed > 0) {
+        printf("\nSome tests FAILED!\n");
+        return 1;
+    } else {
+        printf("\nAll tests PASSED!\n");
+        return 0;
+    }
+}
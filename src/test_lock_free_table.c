@@ -0,0 +1,274 @@
+/**
+ * Test file for the lock-free open addressing table in lock_free_table.h
+ *
+ * This file tests the following operations:
+ * - new_lock_free_table()
+ * - lock_free_insert_key()
+ * - lock_free_contains_key()
+ * - lock_free_delete_key()
+ * - lock_free_count()
+ *
+ * Build with: gcc -O2 -pthread test_lock_free_table.c lock_free_table.c
+ */
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "lock_free_table.h"
+
+// Test counters
+static int tests_passed = 0;
+static int tests_failed = 0;
+
+// Helper macro for test assertions
+#define TEST_ASSERT(condition, test_name) do { \
+    if (condition) { \
+        printf("[PASS] %s\n", test_name); \
+        tests_passed++; \
+    } else { \
+        printf("[FAIL] %s\n", test_name); \
+        tests_failed++; \
+    } \
+} while (0)
+
+#define NUM_THREADS 4
+// Keys every thread owns, and operations every thread does on them.
+#define KEYS_PER_THREAD 4096
+#define OPS_PER_THREAD 200000
+// Inserted before the threads start and never deleted, everyone looks them up all the time.
+#define STABLE_KEYS 1000
+// Keys every thread inserts and deletes at once.
+#define SHARED_KEYS 256
+// Keys every thread inserts at once, in the same order.
+#define RACING_KEYS 100000
+
+// PRNG so every run does the same operations (the interleaving is up to the scheduler).
+static uint64_t xorshift64(uint64_t *state) {
+    uint64_t x = *state;
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+    return *state = x;
+}
+
+// What the shards say the current slots have in tombstones, against what's really in there.
+static int tombstones_add_up(struct lock_free_table *table) {
+    struct lock_free_slots *slots = atomic_load(&table->slots);
+    int64_t counted = -atomic_load(&slots->tombstone_base), found = 0;
+    for (size_t i = 0; i < LOCK_FREE_SHARDS; ++i) counted += atomic_load(&table->shards[i].tombstones);
+    for (size_t i = 0; i < slots->size; ++i) found += (atomic_load(&slots->slots[i].state) & SLOT_DELETED) != 0;
+    return counted == found;
+}
+
+// ============================================================================
+// Test: one thread
+// ============================================================================
+void test_single_thread() {
+    printf("\n--- Testing one thread ---\n");
+
+    struct lock_free_table *table = new_lock_free_table(4);
+    TEST_ASSERT(table != NULL, "new_lock_free_table returns non-NULL pointer");
+
+    TEST_ASSERT(!lock_free_contains_key(table, 42), "new table contains nothing");
+    lock_free_insert_key(table, 42);
+    lock_free_insert_key(table, 57);  // 57 % 15 == 42 % 15, same home slot
+    lock_free_insert_key(table, 42);
+    TEST_ASSERT(lock_free_contains_key(table, 42) && lock_free_contains_key(table, 57), "inserted keys are found");
+    TEST_ASSERT(lock_free_count(table) == 2, "inserting a key twice counts it once");
+
+    lock_free_insert_key(table, 0);
+    TEST_ASSERT(!lock_free_contains_key(table, 0) && lock_free_count(table) == 2, "key 0 is not inserted");
+
+    lock_free_delete_key(table, 42);
+    lock_free_delete_key(table, 42);
+    lock_free_delete_key(table, 1000);
+    TEST_ASSERT(!lock_free_contains_key(table, 42), "deleted key is gone");
+    TEST_ASSERT(lock_free_contains_key(table, 57), "the key probed past it is still there");
+    TEST_ASSERT(lock_free_count(table) == 1, "deleting a missing key changes nothing");
+    TEST_ASSERT(tombstones_add_up(table), "deleting a key twice leaves one tombstone");
+
+    lock_free_insert_key(table, 42);
+    TEST_ASSERT(lock_free_contains_key(table, 42) && lock_free_count(table) == 2, "a deleted key comes back");
+    TEST_ASSERT(tombstones_add_up(table), "bringing a key back uses up its tombstone");
+
+    // Enough keys for a few grows, and enough deletes for rehashes that only drop tombstones. Random keys for the
+    // churn, consecutive ones make one long run that every insert walks (see lock_free_table.h).
+    for (unsigned int key = 1; key <= 100000; ++key) lock_free_insert_key(table, key);
+    for (unsigned int key = 1; key <= 100000; key += 2) lock_free_delete_key(table, key);
+    uint8_t power = atomic_load(&table->slots)->mersenne_prime_power;
+    uint64_t rng_state = 12346;
+    for (int round = 0; round < 20; ++round) {
+        uint64_t round_state = rng_state;
+        // Top bit set, so they're never one of the keys above.
+        for (int i = 0; i < 50000; ++i) lock_free_insert_key(table, (unsigned int)xorshift64(&rng_state) | 1u << 31);
+        for (int i = 0; i < 50000; ++i) lock_free_delete_key(table, (unsigned int)xorshift64(&round_state) | 1u << 31);
+    }
+    int correct = 0;
+    for (unsigned int key = 1; key <= 100000; ++key) correct += lock_free_contains_key(table, key) == (key % 2 == 0);
+    TEST_ASSERT(correct == 100000, "every key is where it should be after growing and rehashing");
+    TEST_ASSERT(lock_free_count(table) == 50000, "table has 50000 keys");
+    TEST_ASSERT(power > 4, "table grew");
+    TEST_ASSERT(tombstones_add_up(table), "tombstones add up after rehashing");
+
+    delete_lock_free_table(table);
+}
+
+// ============================================================================
+// Test: threads on disjoint keys, and on the same keys
+// ============================================================================
+struct worker {
+    pthread_t id;
+    struct lock_free_table *table;
+    unsigned int first_key;
+    uint64_t seed;
+    // Whether each of the thread's keys should be in the table.
+    bool model[KEYS_PER_THREAD];
+    size_t wrong;
+    size_t stable_missing;
+};
+
+static void *run_worker(void *arg) {
+    struct worker *worker = arg;
+    uint64_t rng_state = worker->seed;
+
+    for (size_t i = 0; i < OPS_PER_THREAD; ++i) {
+        uint64_t r = xorshift64(&rng_state);
+        size_t k = (r >> 8) % KEYS_PER_THREAD;
+        unsigned int key = worker->first_key + (unsigned int)k;
+        switch (r % 3) {
+        case 0:
+            lock_free_insert_key(worker->table, key);
+            worker->model[k] = true;
+            break;
+        case 1:
+            lock_free_delete_key(worker->table, key);
+            worker->model[k] = false;
+            break;
+        default:
+            worker->wrong += lock_free_contains_key(worker->table, key) != worker->model[k];
+        }
+        // The table keeps being copied into new slots, none of these may ever go missing on the way.
+        worker->stable_missing += !lock_free_contains_key(worker->table, 1 + (unsigned int)((r >> 40) % STABLE_KEYS));
+    }
+
+    for (size_t k = 0; k < KEYS_PER_THREAD; ++k)
+        worker->wrong += lock_free_contains_key(worker->table, worker->first_key + (unsigned int)k) != worker->model[k];
+    return NULL;
+}
+
+// Everyone inserting and deleting the same few keys, in a table big enough to never rehash.
+static void *run_shared_worker(void *arg) {
+    struct worker *worker = arg;
+    uint64_t rng_state = worker->seed;
+    for (size_t i = 0; i < OPS_PER_THREAD; ++i) {
+        uint64_t r = xorshift64(&rng_state);
+        unsigned int key = worker->first_key + (unsigned int)((r >> 8) % SHARED_KEYS);
+        if (r % 2)
+            lock_free_insert_key(worker->table, key);
+        else
+            lock_free_delete_key(worker->table, key);
+    }
+    return NULL;
+}
+
+// Everyone inserting the same keys in the same order, so they keep landing on a slot someone else just claimed. Each
+// insert has to be visible by the time it returns, whoever's insert it was that made it live.
+static void *run_racing_worker(void *arg) {
+    struct worker *worker = arg;
+    for (unsigned int key = worker->first_key; key < worker->first_key + RACING_KEYS; ++key) {
+        lock_free_insert_key(worker->table, key);
+        worker->wrong += !lock_free_contains_key(worker->table, key);
+    }
+    return NULL;
+}
+
+void test_threads() {
+    printf("\n--- Testing %d threads on disjoint keys ---\n", NUM_THREADS);
+
+    // Small enough to grow a few times while the threads are at it.
+    struct lock_free_table *table = new_lock_free_table(4);
+    for (unsigned int key = 1; key <= STABLE_KEYS; ++key) lock_free_insert_key(table, key);
+
+    struct worker *workers = calloc(NUM_THREADS, sizeof *workers);
+    for (int t = 0; t < NUM_THREADS; ++t) {
+        workers[t].table = table;
+        workers[t].first_key = STABLE_KEYS + 1 + t * KEYS_PER_THREAD;
+        workers[t].seed = 12346 + t;
+        pthread_create(&workers[t].id, NULL, run_worker, &workers[t]);
+    }
+    for (int t = 0; t < NUM_THREADS; ++t) pthread_join(workers[t].id, NULL);
+
+    size_t wrong = 0, stable_missing = 0, expected = STABLE_KEYS;
+    for (int t = 0; t < NUM_THREADS; ++t) {
+        wrong += workers[t].wrong;
+        stable_missing += workers[t].stable_missing;
+        for (size_t k = 0; k < KEYS_PER_THREAD; ++k) expected += workers[t].model[k];
+    }
+    TEST_ASSERT(wrong == 0, "every lookup agrees with its thread's model");
+    TEST_ASSERT(stable_missing == 0, "keys nobody deletes are always found");
+    TEST_ASSERT(lock_free_count(table) == expected, "count matches the models");
+    TEST_ASSERT(atomic_load(&table->slots)->mersenne_prime_power > 4, "table grew while the threads were at it");
+    delete_lock_free_table(table);
+
+    printf("\n--- Testing %d threads on the same keys ---\n", NUM_THREADS);
+
+    table = new_lock_free_table(16);
+    for (int t = 0; t < NUM_THREADS; ++t) {
+        workers[t] = (struct worker){.table = table, .first_key = 1, .seed = 54321 + t};
+        pthread_create(&workers[t].id, NULL, run_shared_worker, &workers[t]);
+    }
+    for (int t = 0; t < NUM_THREADS; ++t) pthread_join(workers[t].id, NULL);
+
+    size_t live = 0;
+    for (unsigned int key = 1; key <= SHARED_KEYS; ++key) live += lock_free_contains_key(table, key);
+    TEST_ASSERT(lock_free_count(table) == live, "count matches the keys that are in");
+    TEST_ASSERT(tombstones_add_up(table), "tombstones match the deleted slots");
+    delete_lock_free_table(table);
+
+    printf("\n--- Testing %d threads inserting the same keys ---\n", NUM_THREADS);
+
+    // Small enough to grow while they're at it too.
+    table = new_lock_free_table(4);
+    for (int t = 0; t < NUM_THREADS; ++t) {
+        workers[t] = (struct worker){.table = table, .first_key = 1};
+        pthread_create(&workers[t].id, NULL, run_racing_worker, &workers[t]);
+    }
+    for (int t = 0; t < NUM_THREADS; ++t) pthread_join(workers[t].id, NULL);
+
+    wrong = 0;
+    for (int t = 0; t < NUM_THREADS; ++t) wrong += workers[t].wrong;
+    TEST_ASSERT(wrong == 0, "every key is found right after its insert returns");
+    TEST_ASSERT(lock_free_count(table) == RACING_KEYS, "every key is counted once");
+    TEST_ASSERT(tombstones_add_up(table), "no tombstones from inserts");
+
+    free(workers);
+    delete_lock_free_table(table);
+}
+
+// ============================================================================
+// Main test runner
+// ============================================================================
+int main() {
+    printf("===============================================\n");
+    printf("    Lock-Free Table Test Suite\n");
+    printf("===============================================\n");
+
+    test_single_thread();
+    test_threads();
+
+    printf("\n===============================================\n");
+    printf("    Test Results Summary\n");
+    printf("===============================================\n");
+    printf("Tests passed: %d\n", tests_passed);
+    printf("Tests failed: %d\n", tests_failed);
+    printf("Total tests:  %d\n", tests_passed + tests_failed);
+    printf("===============================================\n");
+
+    if (tests_failed > 0) {
+        printf("\nSome tests FAILED!\n");
+        return 1;
+    } else {
+        printf("\nAll tests PASSED!\n");
+        return 0;
+    }
+}
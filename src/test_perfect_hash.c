@@ -0,0 +1,191 @@
+/**
+ * Test file for the minimal perfect hash in perfect_hash.h
+ *
+ * This file tests the following operations:
+ * - build_perfect_hash()
+ * - perfect_hash_index()
+ * - perfect_hash_contains()
+ * - delete_perfect_hash()
+ *
+ * Build with: gcc -O2 -pthread test_perfect_hash.c perfect_hash.c radix_partition.c
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "perfect_hash.h"
+
+// Test counters
+static int tests_passed = 0;
+static int tests_failed = 0;
+
+// Helper macro for test assertions
+#define TEST_ASSERT(condition, test_name) do { \
+    if (condition) { \
+        printf("[PASS] %s\n", test_name); \
+        tests_passed++; \
+    } else { \
+        printf("[FAIL] %s\n", test_name); \
+        tests_failed++; \
+    } \
+} while (0)
+
+// More than PERFECT_HASH_PARTITION_KEYS, so the big builds have several partitions.
+#define NUM_KEYS 300000
+
+// PRNG so every run uses the same keys.
+static uint64_t xorshift64(uint64_t *state) {
+    uint64_t x = *state;
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+    return *state = x;
+}
+
+// n different random keys, none with the top bit set (see contains_only).
+static unsigned int *different_keys(size_t n, uint64_t seed) {
+    unsigned int *keys = malloc(n * sizeof *keys);
+    uint8_t *taken = calloc((size_t)1 << 28, 1);
+    uint64_t rng_state = seed;
+    for (size_t i = 0; i < n;) {
+        unsigned int key = (unsigned int)xorshift64(&rng_state) & ~(1u << 31);
+        if (taken[key / 8] >> (key % 8) & 1) continue;
+        taken[key / 8] |= 1 << (key % 8);
+        keys[i++] = key;
+    }
+    free(taken);
+    return keys;
+}
+
+// Every one of the different keys gets its own index in [0, count), so all of [0, count) is used up, and
+// keys[index] is the key.
+static int is_bijection(const struct perfect_hash *hash, const unsigned int *keys, size_t n) {
+    if (hash->count != n) return 0;
+    bool *used = calloc(n ? n : 1, sizeof *used);
+    int bijection = 1;
+    for (size_t i = 0; i < n && bijection; ++i) {
+        size_t index = perfect_hash_index(hash, keys[i]);
+        bijection = index < n && !used[index] && hash->keys[index] == keys[i];
+        if (bijection) used[index] = true;
+    }
+    free(used);
+    return bijection;
+}
+
+// Every key is in, and of as many random keys none that isn't one of them is.
+static int contains_only(const struct perfect_hash *hash, const unsigned int *keys, size_t n) {
+    for (size_t i = 0; i < n; ++i)
+        if (!perfect_hash_contains(hash, keys[i])) return 0;
+    // None of the keys has the top bit set.
+    uint64_t rng_state = 54321;
+    for (size_t i = 0; i < n + 1000; ++i)
+        if (perfect_hash_contains(hash, (unsigned int)xorshift64(&rng_state) | 1u << 31)) return 0;
+    return 1;
+}
+
+// ============================================================================
+// Test: tiny key sets
+// ============================================================================
+void test_tiny() {
+    printf("\n--- Testing 0 and 1 keys ---\n");
+
+    unsigned int key = 42;
+    struct perfect_hash *hash = build_perfect_hash(&key, 0, 1);
+    TEST_ASSERT(hash != NULL, "build_perfect_hash with 0 keys returns non-NULL pointer");
+    TEST_ASSERT(hash && hash->count == 0, "no keys, count is 0");
+    TEST_ASSERT(hash && !perfect_hash_contains(hash, 42) && !perfect_hash_contains(hash, 0),
+                "no keys, nothing is contained");
+    if (hash) delete_perfect_hash(hash);
+
+    hash = build_perfect_hash(&key, 1, 1);
+    TEST_ASSERT(hash != NULL, "build_perfect_hash with 1 key returns non-NULL pointer");
+    TEST_ASSERT(hash && is_bijection(hash, &key, 1), "the one key gets index 0");
+    TEST_ASSERT(hash && contains_only(hash, &key, 1), "only the one key is contained");
+    if (hash) delete_perfect_hash(hash);
+
+    key = 0;
+    hash = build_perfect_hash(&key, 1, 1);
+    TEST_ASSERT(hash && is_bijection(hash, &key, 1) && perfect_hash_contains(hash, 0), "key 0 is a key like any other");
+    if (hash) delete_perfect_hash(hash);
+}
+
+// ============================================================================
+// Test: bijection onto [0, count) for different thread counts
+// ============================================================================
+void test_threads(const unsigned int *keys) {
+    static const size_t sizes[] = {2, 100, 5000, NUM_KEYS};
+    static const int threads[] = {1, 2, 5};
+    char name[128];
+
+    for (size_t t = 0; t < sizeof threads / sizeof *threads; ++t) {
+        printf("\n--- Testing %d thread(s) ---\n", threads[t]);
+        for (size_t s = 0; s < sizeof sizes / sizeof *sizes; ++s) {
+            size_t n = sizes[s];
+            struct perfect_hash *hash = build_perfect_hash(keys, n, threads[t]);
+            snprintf(name, sizeof name, "%zu keys: every key gets its own index in [0, count)", n);
+            TEST_ASSERT(hash && is_bijection(hash, keys, n), name);
+            snprintf(name, sizeof name, "%zu keys: only the keys are contained", n);
+            TEST_ASSERT(hash && contains_only(hash, keys, n), name);
+            if (hash) delete_perfect_hash(hash);
+        }
+    }
+}
+
+// ============================================================================
+// Test: duplicate keys
+// ============================================================================
+void test_duplicates(const unsigned int *keys) {
+    printf("\n--- Testing duplicate keys ---\n");
+
+    // Every key 3 times, the copies spread out, plus one key a thousand times.
+    size_t n = 10000, m = 3 * n + 1000;
+    unsigned int *input = malloc(m * sizeof *input);
+    for (size_t i = 0; i < 3 * n; ++i) input[i] = keys[i % n];
+    for (size_t i = 3 * n; i < m; ++i) input[i] = keys[0];
+
+    for (int threads = 1; threads <= 2; ++threads) {
+        struct perfect_hash *hash = build_perfect_hash(input, m, threads);
+        TEST_ASSERT(hash && hash->count == n, "count is the number of different keys");
+        TEST_ASSERT(hash && is_bijection(hash, keys, n), "every different key gets its own index in [0, count)");
+        TEST_ASSERT(hash && contains_only(hash, keys, n), "only the keys are contained");
+        if (hash) delete_perfect_hash(hash);
+    }
+
+    // Nothing but one key.
+    for (size_t i = 0; i < n; ++i) input[i] = keys[7];
+    struct perfect_hash *hash = build_perfect_hash(input, n, 2);
+    TEST_ASSERT(hash && is_bijection(hash, &keys[7], 1), "the same key n times is one key with index 0");
+    if (hash) delete_perfect_hash(hash);
+    free(input);
+}
+
+// ============================================================================
+// Main test runner
+// ============================================================================
+int main() {
+    printf("===============================================\n");
+    printf("    Perfect Hash Test Suite\n");
+    printf("===============================================\n");
+
+    unsigned int *keys = different_keys(NUM_KEYS, 12346);
+
+    test_tiny();
+    test_threads(keys);
+    test_duplicates(keys);
+    free(keys);
+
+    printf("\n===============================================\n");
+    printf("    Test Results Summary\n");
+    printf("===============================================\n");
+    printf("Tests passed: %d\n", tests_passed);
+    printf("Tests failed: %d\n", tests_failed);
+    printf("Total tests:  %d\n", tests_passed + tests_failed);
+    printf("===============================================\n");
+
+    if (tests_failed > 0) {
+        printf("\nSome tests FAILED!\n");
+        return 1;
+    } else {
+        printf("\nAll tests PASSED!\n");
+        return 0;
+    }
+}
@@ -0,0 +1,195 @@
+/**
+ * Test file for open addressing snapshots (save_table / map_table in open_addressing.h)
+ *
+ * This file tests the following operations:
+ * - save_table()
+ * - map_table()
+ * - verify_snapshot()
+ * - insert_key() / delete_key() on a mapped table
+ *
+ * Build with: gcc -O2 test_snapshot.c open_addressing.c
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include "open_addressing.h"
+
+// Test counters
+static int tests_passed = 0;
+static int tests_failed = 0;
+
+// Helper macro for test assertions
+#define TEST_ASSERT(condition, test_name) do { \
+    if (condition) { \
+        printf("[PASS] %s\n", test_name); \
+        tests_passed++; \
+    } else { \
+        printf("[FAIL] %s\n", test_name); \
+        tests_failed++; \
+    } \
+} while (0)
+
+#define SNAPSHOT_PATH "test_snapshot.bin"
+#define NUM_KEYS 100000
+
+// PRNG so every run uses the same keys.
+static uint64_t xorshift64(uint64_t *state) {
+    uint64_t x = *state;
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+    return *state = x;
+}
+
+// Every key, and as many that were never inserted, gets the same answer from both tables.
+static int same_answers(struct hash_table *table, struct hash_table *mapped, const unsigned int *keys, size_t n) {
+    uint64_t rng_state = 54321;
+    for (size_t i = 0; i < n; ++i) {
+        unsigned int other = (unsigned int)xorshift64(&rng_state);
+        if (contains_key(table, keys[i]) != contains_key(mapped, keys[i])) return 0;
+        if (contains_key(table, other) != contains_key(mapped, other)) return 0;
+    }
+    return 1;
+}
+
+// Cuts the file at path down to length bytes.
+static int cut_file(const char *path, off_t length) {
+    return truncate(path, length) == 0;
+}
+
+// ============================================================================
+// Test: save_table / map_table
+// ============================================================================
+void test_save_and_map(unsigned int *keys) {
+    printf("\n--- Testing save_table and map_table ---\n");
+
+    struct hash_table *table = empty_table(16);
+    set_hash_function(table, HASH_UNIVERSAL, 42);
+    for (size_t i = 0; i < NUM_KEYS; ++i) insert_key(table, keys[i]);
+    for (size_t i = 0; i < NUM_KEYS; i += 3) delete_key(table, keys[i]);
+
+    TEST_ASSERT(save_table(table, SNAPSHOT_PATH), "save_table succeeds");
+    struct hash_table *mapped = map_table(SNAPSHOT_PATH);
+    TEST_ASSERT(mapped != NULL, "map_table returns non-NULL pointer");
+    TEST_ASSERT(verify_snapshot(mapped), "the mapped bins match the checksum");
+    TEST_ASSERT(mapped->count == table->count && mapped->tombstones == table->tombstones, "count and tombstones match");
+    TEST_ASSERT(mapped->hasher.function == HASH_UNIVERSAL && mapped->hasher.seed == 42, "hash function and seed match");
+    TEST_ASSERT(same_answers(table, mapped, keys, NUM_KEYS), "every lookup matches the source table");
+
+    // Mapped tables are copy on write, the file stays as it was.
+    insert_key(mapped, keys[0]);
+    delete_key(mapped, keys[1]);
+    TEST_ASSERT(contains_key(mapped, keys[0]) && !contains_key(mapped, keys[1]), "a mapped table takes writes");
+    TEST_ASSERT(!verify_snapshot(mapped), "writes show up in verify_snapshot");
+    struct hash_table *again = map_table(SNAPSHOT_PATH);
+    TEST_ASSERT(again && verify_snapshot(again) && same_answers(table, again, keys, NUM_KEYS),
+                "writes never reach the file");
+
+    // Enough to grow, which moves the bins off the file.
+    for (unsigned int key = 1; key <= 2 * NUM_KEYS; ++key) insert_key(again, key);
+    int correct = 1;
+    for (unsigned int key = 1; key <= 2 * NUM_KEYS; ++key) correct &= contains_key(again, key);
+    TEST_ASSERT(correct && again->mapping == NULL, "a mapped table grows off the file");
+
+    delete_table(again);
+    delete_table(mapped);
+    delete_table(table);
+    unlink(SNAPSHOT_PATH);
+}
+
+// ============================================================================
+// Test: a snapshot taken while the table is resizing
+// ============================================================================
+void test_mid_resize(unsigned int *keys) {
+    printf("\n--- Testing a snapshot taken mid-resize ---\n");
+
+    struct hash_table *table = empty_table(10);
+    size_t i = 0;
+    // Until a grow starts, and stop before it's done moving the old bins.
+    while (i < NUM_KEYS && !table->old_table) insert_key(table, keys[i++]);
+    TEST_ASSERT(table->old_table != NULL, "table is resizing");
+
+    TEST_ASSERT(save_table(table, SNAPSHOT_PATH), "save_table succeeds");
+    struct hash_table *mapped = map_table(SNAPSHOT_PATH);
+    TEST_ASSERT(mapped != NULL && verify_snapshot(mapped), "the snapshot maps and verifies");
+    TEST_ASSERT(mapped && mapped->size == table->size && mapped->count == i, "it has the new bins and every key");
+    TEST_ASSERT(mapped && same_answers(table, mapped, keys, NUM_KEYS), "every lookup matches the source table");
+
+    if (mapped) delete_table(mapped);
+    delete_table(table);
+    unlink(SNAPSHOT_PATH);
+}
+
+// ============================================================================
+// Test: files that aren't a whole snapshot
+// ============================================================================
+void test_bad_files(unsigned int *keys) {
+    printf("\n--- Testing truncated and damaged snapshots ---\n");
+
+    struct hash_table *table = empty_table(12);
+    for (size_t i = 0; i < 1000; ++i) insert_key(table, keys[i]);
+    size_t length = SNAPSHOT_HEADER_SIZE + table->size * sizeof(struct bin);
+
+    TEST_ASSERT(map_table("no_such_snapshot.bin") == NULL, "a missing file maps to NULL");
+
+    save_table(table, SNAPSHOT_PATH);
+    TEST_ASSERT(cut_file(SNAPSHOT_PATH, length - 1) && map_table(SNAPSHOT_PATH) == NULL,
+                "a file one byte short maps to NULL");
+    save_table(table, SNAPSHOT_PATH);
+    TEST_ASSERT(cut_file(SNAPSHOT_PATH, SNAPSHOT_HEADER_SIZE) && map_table(SNAPSHOT_PATH) == NULL,
+                "a header without bins maps to NULL");
+    TEST_ASSERT(cut_file(SNAPSHOT_PATH, 100) && map_table(SNAPSHOT_PATH) == NULL, "half a header maps to NULL");
+
+    // A flipped byte in the bins gets past the header, but not the checksum.
+    save_table(table, SNAPSHOT_PATH);
+    FILE *file = fopen(SNAPSHOT_PATH, "r+b");
+    fseek(file, SNAPSHOT_HEADER_SIZE + 8, SEEK_SET);
+    int byte = fgetc(file);
+    fseek(file, SNAPSHOT_HEADER_SIZE + 8, SEEK_SET);
+    fputc(byte ^ 0x40, file);
+    fclose(file);
+    struct hash_table *mapped = map_table(SNAPSHOT_PATH);
+    TEST_ASSERT(mapped != NULL && !verify_snapshot(mapped), "a damaged bin fails verify_snapshot");
+
+    if (mapped) delete_table(mapped);
+    delete_table(table);
+    unlink(SNAPSHOT_PATH);
+}
+
+// ============================================================================
+// Main test runner
+// ============================================================================
+int main() {
+    printf("===============================================\n");
+    printf("    Snapshot Test Suite\n");
+    printf("===============================================\n");
+
+    unsigned int *keys = malloc(NUM_KEYS * sizeof *keys);
+    uint64_t rng_state = 12346;
+    for (size_t i = 0; i < NUM_KEYS; ++i) {
+        keys[i] = (unsigned int)xorshift64(&rng_state);
+        if (keys[i] == 0) keys[i] = 1;
+    }
+
+    test_save_and_map(keys);
+    test_mid_resize(keys);
+    test_bad_files(keys);
+    free(keys);
+
+    printf("\n===============================================\n");
+    printf("    Test Results Summary\n");
+    printf("===============================================\n");
+    printf("Tests passed: %d\n", tests_passed);
+    printf("Tests failed: %d\n", tests_failed);
+    printf("Total tests:  %d\n", tests_passed + tests_failed);
+    printf("===============================================\n");
+
+    if (tests_failed > 0) {
+        printf("\nSome tests FAILED!\n");
+        return 1;
+    } else {
+        printf("\nAll tests PASSED!\n");
+        return 0;
+    }
+}